@@ -27,6 +27,7 @@
 #include "code_generator.hpp"
 #include "function_internal.hpp"
 #include "convexify.hpp"
+#include "global_options.hpp"
 #include <casadi_runtime_str.h>
 #include <iomanip>
 
@@ -54,6 +55,11 @@ namespace casadi {
     bool prefix_set = false;
     this->prefix = "";
     avoid_stack_ = false;
+    this->blas = false;
+    this->blas_threshold = GlobalOptions::blas_threshold;
+    this->max_body_size = 0;
+    this->split_files = false;
+    this->roll_loops = false;
     indent_ = 2;
 
     // Read options
@@ -95,6 +101,17 @@ namespace casadi {
         casadi_assert_dev(indent_>=0);
       } else if (e.first=="avoid_stack") {
         avoid_stack_ = e.second;
+      } else if (e.first=="blas") {
+        this->blas = e.second;
+      } else if (e.first=="blas_threshold") {
+        this->blas_threshold = e.second;
+      } else if (e.first=="max_body_size") {
+        this->max_body_size = e.second;
+        casadi_assert(this->max_body_size>=0, "Option 'max_body_size' must be nonnegative");
+      } else if (e.first=="split_files") {
+        this->split_files = e.second;
+      } else if (e.first=="roll_loops") {
+        this->roll_loops = e.second;
       } else if (e.first=="prefix") {
         this->prefix = e.second.to_string();
         prefix_set = true;
@@ -174,6 +191,10 @@ namespace casadi {
   }
 
   void CodeGenerator::scope_exit() {
+    scope_exit(body);
+  }
+
+  void CodeGenerator::scope_exit(std::ostream &s) {
     // Order local variables
     std::map<string, set<pair<string, string>>> local_variables_by_type;
     for (auto&& e : local_variables_) {
@@ -182,14 +203,22 @@ namespace casadi {
 
     // Codegen local variables
     for (auto&& e : local_variables_by_type) {
-      body << "  " << e.first;
+      s << "  " << e.first;
       for (auto it=e.second.begin(); it!=e.second.end(); ++it) {
-        body << (it==e.second.begin() ? " " : ", ") << it->second << it->first;
+        s << (it==e.second.begin() ? " " : ", ") << it->second << it->first;
         // Insert definition, if any
         auto k=local_default_.find(it->first);
-        if (k!=local_default_.end()) body << "=" << k->second;
+        if (k!=local_default_.end()) s << "=" << k->second;
       }
-      body << ";\n";
+      s << ";\n";
+    }
+  }
+
+  void CodeGenerator::add_part(const std::string& code) {
+    if (this->split_files) {
+      parts_.push_back(code);
+    } else {
+      body << code;
     }
   }
 
@@ -412,8 +441,11 @@ namespace casadi {
     string fullname = prefix + this->name + this->suffix;
     file_open(s, fullname);
 
-    // Dump code to file
+    // Dump code to file, without the separate compilation units
+    std::vector<std::string> parts;
+    parts.swap(parts_);
     dump(s);
+    parts.swap(parts_);
 
     // Mex entry point
     if (this->mex) generate_mex(s);
@@ -424,6 +456,16 @@ namespace casadi {
     // Finalize file
     file_close(s);
 
+    // Separate compilation units
+    split_sources_.clear();
+    for (casadi_int k=0; k<parts_.size(); ++k) {
+      split_sources_.push_back(prefix + this->name + "_" + str(k+1) + this->suffix);
+      file_open(s, split_sources_.back());
+      dump_preamble(s, true);
+      s << parts_[k];
+      file_close(s);
+    }
+
     // Generate header
     if (this->with_header) {
       // Create a header file
@@ -548,10 +590,7 @@ namespace casadi {
     return "casadi_ri" + str(size);
   }
 
-  void CodeGenerator::dump(std::ostream& s) {
-    // Consistency check
-    casadi_assert_dev(current_indent_ == 0);
-
+  void CodeGenerator::dump_preamble(std::ostream& s, bool part) const {
     // Prefix internal symbols to avoid symbol collisions
     s << "/* How to prefix internal symbols */\n"
       << "#ifdef CASADI_CODEGEN_PREFIX\n"
@@ -595,6 +634,42 @@ namespace casadi {
 
     if (this->with_export) generate_export_symbol(s);
 
+    if (part) {
+      // Auxiliary functions are defined in the main file, declare the ones
+      // needed for elementary operations
+      if (added_auxiliaries_.count(AUX_SQ)) {
+        s << "casadi_real casadi_sq(casadi_real x);\n";
+      }
+      if (added_auxiliaries_.count(AUX_SIGN)) {
+        s << "casadi_real casadi_sign(casadi_real x);\n";
+      }
+      if (added_auxiliaries_.count(AUX_FMIN)) {
+        s << "casadi_real casadi_fmin(casadi_real x, casadi_real y);\n";
+      }
+      if (added_auxiliaries_.count(AUX_FMAX)) {
+        s << "casadi_real casadi_fmax(casadi_real x, casadi_real y);\n";
+      }
+      if (added_auxiliaries_.count(AUX_INF)) {
+        s << "#ifndef casadi_inf\n"
+          << "  #define casadi_inf " << this->infinity << "\n"
+          << "#endif\n";
+      }
+      if (added_auxiliaries_.count(AUX_NAN)) {
+        s << "#ifndef casadi_nan\n"
+          << "  #define casadi_nan " << this->nan << "\n"
+          << "#endif\n";
+      }
+      s << endl;
+    } else {
+      // Codegen auxiliary functions
+      s << this->auxiliaries.str();
+    }
+  }
+
+  void CodeGenerator::dump(std::ostream& s) {
+    // Consistency check
+    casadi_assert_dev(current_indent_ == 0);
+
     // Check if inf/nan is needed
     for (const auto& d : double_constants_) {
       for (double e : d) {
@@ -603,8 +678,8 @@ namespace casadi {
       }
     }
 
-    // Codegen auxiliary functions
-    s << this->auxiliaries.str();
+    // Macros, types and auxiliary functions
+    dump_preamble(s, false);
 
     // Print integer constants
     if (!integer_constants_.empty()) {
@@ -652,6 +727,9 @@ namespace casadi {
     // Codegen body
     s << this->body.str();
 
+    // Definitions not written to separate compilation units
+    for (auto&& p : parts_) s << p;
+
     // End with new line
     s << endl;
   }
@@ -1077,6 +1155,9 @@ namespace casadi {
       add_auxiliary(AUX_QR);
       this->auxiliaries << sanitize_source(casadi_newton_str, inst);
       break;
+    case AUX_ERK:
+      this->auxiliaries << sanitize_source(casadi_erk_str, inst);
+      break;
     case AUX_MAX_VIOL:
       this->auxiliaries << sanitize_source(casadi_max_viol_str, inst);
       break;
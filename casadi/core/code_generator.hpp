@@ -61,6 +61,13 @@ namespace casadi {
     */
     std::string generate(const std::string& prefix="");
 
+    /** \brief Additional source files written by the last call to generate
+
+      Non-empty only with the "split_files" option. The files must be compiled
+      and linked together with the returned main file.
+    */
+    const std::vector<std::string>& split_sources() const { return split_sources_;}
+
     /// Add an include file optionally using a relative path "..." instead of an absolute path <...>
     void add_include(const std::string& new_include, bool relative_path=false,
                     const std::string& use_ifdef=std::string());
@@ -145,6 +152,16 @@ namespace casadi {
     /** \brief Exit a local scope */
     void scope_exit();
 
+    /** \brief Exit a local scope, declaring the local variables in a stream of choice */
+    void scope_exit(std::ostream &s);
+
+    /** \brief Add a function definition that goes to a separate compilation unit
+
+      Written to its own file by generate() if "split_files" is set, otherwise
+      appended to the main file.
+    */
+    void add_part(const std::string& code);
+
     /** \brief Declare a work vector element */
     std::string sx_work(casadi_int i);
 
@@ -158,7 +175,7 @@ namespace casadi {
     void unindent() {current_indent_--;}
 
     /** \brief Avoid stack? */
-    bool avoid_stack() { return avoid_stack_;}
+    bool avoid_stack() const { return avoid_stack_;}
 
     /** \brief Print a constant in a lossless but compact manner */
     std::string constant(double v);
@@ -355,6 +372,7 @@ namespace casadi {
       AUX_SQPMETHOD,
       AUX_LDL,
       AUX_NEWTON,
+      AUX_ERK,
       AUX_TO_DOUBLE,
       AUX_TO_INT,
       AUX_CAST,
@@ -500,6 +518,10 @@ namespace casadi {
     // Generate import symbol macros
     void generate_import_symbol(std::ostream &s) const;
 
+    // Generate the macros, types and auxiliary functions, or only declarations
+    // of the latter in separate compilation units
+    void dump_preamble(std::ostream &s, bool part) const;
+
     //  private:
   public:
     /// \cond INTERNAL
@@ -540,6 +562,26 @@ namespace casadi {
     // Do we want to be lean on stack usage?
     bool avoid_stack_;
 
+    /** \brief Call the external BLAS for dense matrix products
+     * Products with at least blas_threshold multiply-adds call dgemm,
+     * the generated code must then be linked with a BLAS library
+     */
+    bool blas;
+    casadi_int blas_threshold;
+
+    /** \brief Split large function bodies
+     * Bodies with more than max_body_size elementary operations (0: no limit) are
+     * divided into sub-functions, written to separate files if split_files is set
+     */
+    casadi_int max_body_size;
+    bool split_files;
+
+    /** \brief Roll repeated instruction sequences into loops
+     * Sequences of identical SXFunction instructions, differing only in the
+     * referenced input, output and work vector indices, are emitted as loops
+     */
+    bool roll_loops;
+
     std::string infinity, nan, real_min;
 
     /** \brief Codegen scalar
@@ -605,6 +647,12 @@ namespace casadi {
     // Does any function need thread-local memory?
     bool needs_mem_;
 
+    // Function definitions for separate compilation units
+    std::vector<std::string> parts_;
+
+    // Files written for the parts
+    std::vector<std::string> split_sources_;
+
     // Hash a vector
     static size_t hash(const std::vector<double>& v);
     static size_t hash(const std::vector<casadi_int>& v);
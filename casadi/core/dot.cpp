@@ -24,6 +24,7 @@
 
 
 #include "dot.hpp"
+#include "simd_kernels.hpp"
 using namespace std;
 namespace casadi {
 
@@ -58,7 +59,8 @@ namespace casadi {
   }
 
   int Dot::eval(const double** arg, double** res, casadi_int* iw, double* w) const {
-    return eval_gen<double>(arg, res, iw, w);
+    *res[0] = simd_dot(dep(0).nnz(), arg[0], arg[1]);
+    return 0;
   }
 
   int Dot::eval_sx(const SXElem** arg, SXElem** res, casadi_int* iw, SXElem* w) const {
@@ -30,6 +30,7 @@
 #include "switch.hpp"
 #include "bspline.hpp"
 #include "nlpsol.hpp"
+#include "map.hpp"
 #include "mapsum.hpp"
 #include "conic.hpp"
 #include "jit_function.hpp"
@@ -612,6 +613,10 @@ namespace casadi {
   Function::map(casadi_int n, const std::string& parallelization,
       casadi_int max_num_threads) const {
     casadi_assert(max_num_threads>=1, "max_num_threads invalid.");
+    // Thread maps bound the number of concurrent workers themselves
+    if (parallelization=="thread" && n>1) {
+      return Map::create(parallelization, *this, n, {{"max_num_threads", max_num_threads}});
+    }
     // No need for logic when we are not saturating the limit
     if (n<=max_num_threads) return map(n, parallelization);
 
@@ -34,7 +34,10 @@
 #include "sx_function.hpp"
 #include "rootfinder_impl.hpp"
 #include "map.hpp"
+#include "thread_pool.hpp"
 #include "mapsum.hpp"
+#include "jit_cache.hpp"
+#include "casadi_meta.hpp"
 #include "switch.hpp"
 #include "interpolant_impl.hpp"
 #include "nlpsol_impl.hpp"
@@ -78,6 +81,7 @@ namespace casadi {
     never_inline_ = false;
     jac_penalty_ = 2;
     max_num_dir_ = GlobalOptions::getMaxNumDir();
+    jac_num_threads_ = 1;
     user_data_ = nullptr;
     regularity_check_ = false;
     inputs_check_ = true;
@@ -86,6 +90,7 @@ namespace casadi {
     jit_serialize_ = "source";
     jit_base_name_ = "jit_tmp";
     jit_temp_suffix_ = true;
+    jit_cached_ = false;
     compiler_plugin_ = "clang";
 
     eval_ = nullptr;
@@ -114,16 +119,19 @@ namespace casadi {
   }
 
   ProtoFunction::~ProtoFunction() {
-    for (void* m : mem_) {
-      if (m!=nullptr) casadi_warning("Memory object has not been properly freed");
+    for (casadi_int i=0; i<mem_.size(); ++i) {
+      if (mem_[i]!=nullptr) casadi_warning("Memory object has not been properly freed");
     }
     mem_.clear();
   }
 
   FunctionInternal::~FunctionInternal() {
-    if (jit_cleanup_ && jit_) {
+    if (jit_cleanup_ && jit_ && compiler_plugin_!="llvm" && !jit_cached_) {
       std::string jit_name = jit_name_ + ".c";
       if (remove(jit_name.c_str())) casadi_warning("Failed to remove " + jit_name);
+      for (auto&& f : jit_sources_) {
+        if (remove(f.c_str())) casadi_warning("Failed to remove " + f);
+      }
     }
   }
 
@@ -247,6 +255,10 @@ namespace casadi {
       {"jit_options",
        {OT_DICT,
         "Options to be passed to the jit compiler."}},
+      {"jit_codegen_options",
+       {OT_DICT,
+        "Options to be passed to the code generator for just-in-time compilation, "
+        "e.g. max_body_size and split_files to compile huge functions in parallel."}},
       {"derivative_of",
        {OT_FUNCTION,
         "The function is a derivative of another function. "
@@ -256,6 +268,10 @@ namespace casadi {
        {OT_INT,
         "Specify the maximum number of directions for derivative functions."
         " Overrules the builtin optimized_num_dir."}},
+      {"jac_num_threads",
+       {OT_INT,
+        "Number of threads used to evaluate the batches of max_num_dir directions "
+        "of a Jacobian concurrently, each on a separate memory object [default: 1]"}},
       {"enable_forward",
        {OT_BOOL,
         "Enable derivative calculation using generated functions for"
@@ -351,6 +367,7 @@ namespace casadi {
     opts["jit_serialize"] = jit_serialize_;
     opts["compiler"] = compiler_plugin_;
     opts["jit_options"] = jit_options_;
+    opts["jit_codegen_options"] = jit_codegen_options_;
     opts["jit_name"] = jit_base_name_;
     opts["jit_temp_suffix"] = jit_temp_suffix_;
     opts["derivative_of"] = derivative_of_;
@@ -359,6 +376,7 @@ namespace casadi {
     opts["always_inline"] = always_inline_;
     opts["never_inline"] = never_inline_;
     opts["max_num_dir"] = max_num_dir_;
+    opts["jac_num_threads"] = jac_num_threads_;
     opts["enable_forward"] = enable_forward_op_;
     opts["enable_reverse"] = enable_reverse_op_;
     opts["enable_jacobian"] = enable_jacobian_op_;
@@ -414,6 +432,8 @@ namespace casadi {
         compiler_plugin_ = op.second.to_string();
       } else if (op.first=="jit_options") {
         jit_options_ = op.second;
+      } else if (op.first=="jit_codegen_options") {
+        jit_codegen_options_ = op.second;
       } else if (op.first=="jit_name") {
         jit_base_name_ = op.second.to_string();
       } else if (op.first=="jit_temp_suffix") {
@@ -426,6 +446,8 @@ namespace casadi {
         ad_weight_sp_ = op.second;
       } else if (op.first=="max_num_dir") {
         max_num_dir_ = op.second;
+      } else if (op.first=="jac_num_threads") {
+        jac_num_threads_ = op.second;
       } else if (op.first=="enable_forward") {
         enable_forward_op_ = op.second;
       } else if (op.first=="enable_reverse") {
@@ -557,25 +579,74 @@ namespace casadi {
     return "o" + str(i);
   }
 
+  std::string FunctionInternal::jit_cache_key() const {
+    // Everything determining the generated code: the serialized function,
+    // the compiler and its options, and the CasADi version
+    std::stringstream ss;
+    ss << CasadiMeta::version() << '\n' << compiler_plugin_ << '\n' << str(jit_options_) << '\n'
+       << str(jit_codegen_options_) << '\n';
+    try {
+      ss << self().serialize();
+    } catch (std::exception& e) {
+      if (verbose_) casadi_message("Function '" + name_ + "' cannot be cached: " + e.what());
+      return std::string();
+    }
+    return JitCache::hash(ss.str());
+  }
+
   void FunctionInternal::finalize() {
     if (jit_) {
+      // Look for a library compiled earlier from an identical function
+      std::string cache_key;
+      if (has_codegen() && compiler_.is_null() && compiler_plugin_!="llvm"
+          && JitCache::enabled()) {
+        cache_key = jit_cache_key();
+        std::string library = cache_key.empty() ? "" : JitCache::lookup(cache_key);
+        if (!library.empty()) {
+          if (verbose_) casadi_message("Loading function '" + name_ + "' from " + library);
+          compiler_ = Importer(library, "dll");
+          jit_cached_ = true;
+        }
+      }
       jit_name_ = jit_base_name_;
-      if (jit_temp_suffix_) {
+      // The llvm compiler works in memory and cached libraries need no source
+      if (jit_temp_suffix_ && compiler_plugin_!="llvm" && !jit_cached_) {
         jit_name_ = temporary_file(jit_name_, ".c");
         jit_name_ = std::string(jit_name_.begin(), jit_name_.begin()+jit_name_.size()-2);
       }
       if (has_codegen()) {
-        if (compiler_.is_null()) {
+        if (compiler_.is_null() && compiler_plugin_=="llvm") {
+          // Lower directly to LLVM IR, bypassing C code generation
+          casadi_assert(jit_serialize_=="source",
+            "Compiler 'llvm' keeps no library on disk, use jit_serialize 'source'.");
+          if (verbose_) casadi_message("Compiling function '" + name_ + "' with LLVM..");
+          Dict opts = jit_options_;
+          opts["function"] = self();
+          if (verbose_) opts["verbose"] = true;
+          compiler_ = Importer(name_, compiler_plugin_, opts);
+          if (verbose_) casadi_message("Compiling function '" + name_ + "' done.");
+        } else if (compiler_.is_null()) {
           if (verbose_) casadi_message("Codegenerating function '" + name_ + "'.");
           // JIT everything
-          Dict opts;
+          Dict opts = jit_codegen_options_;
           // Override the default to avoid random strings in the generated code
           opts["prefix"] = "jit";
           CodeGenerator gen(jit_name_, opts);
           gen.add(self());
           if (verbose_) casadi_message("Compiling function '" + name_ + "'..");
-          compiler_ = Importer(gen.generate(), compiler_plugin_, jit_options_);
+          Dict jit_options = jit_options_;
+          // Cached below, keyed by the function rather than the generated source
+          if (!cache_key.empty()) jit_options["cache"] = false;
+          std::string source = gen.generate();
+          // Separate compilation units
+          jit_sources_ = gen.split_sources();
+          if (!jit_sources_.empty()) jit_options["sources"] = jit_sources_;
+          compiler_ = Importer(source, compiler_plugin_, jit_options);
           if (verbose_) casadi_message("Compiling function '" + name_ + "' done.");
+          // Plugins producing a shared library populate the cache
+          if (!cache_key.empty() && compiler_.library()!=source) {
+            JitCache::store(cache_key, compiler_.library());
+          }
         }
         // Try to load
         eval_ = (eval_t) compiler_.get_function(name_);
@@ -858,6 +929,7 @@ namespace casadi {
     my_opts["ad_weight"] = ad_weight();
     my_opts["ad_weight_sp"] = sp_weight();
     my_opts["max_num_dir"] = max_num_dir_;
+    my_opts["jac_num_threads"] = jac_num_threads_;
     // Wrap the function
     vector<MX> arg = mx_in();
     vector<MX> res = self()(arg);
@@ -874,6 +946,7 @@ namespace casadi {
       opts["ad_weight"] = ad_weight();
       opts["ad_weight_sp"] = sp_weight();
       opts["max_num_dir"] = max_num_dir_;
+      opts["jac_num_threads"] = jac_num_threads_;
       opts["is_diff_in"] = is_diff_in_;
       opts["is_diff_out"] = is_diff_out_;
       // Wrap the function
@@ -951,48 +1024,129 @@ namespace casadi {
     }
   };
 
+  /// \cond INTERNAL
+  // Work vectors of one thread propagating sparsity patterns
+  struct SpWorker {
+    // Bit vectors for the input and output nonzeros
+    std::vector<bvec_t> s_in, s_out;
+    // Evaluation buffers
+    std::vector<const bvec_t*> arg_fwd;
+    std::vector<bvec_t*> arg_adj, res;
+    std::vector<casadi_int> iw;
+    std::vector<bvec_t> w;
+    // Memory object
+    int mem;
+  };
+
+  // Workers for concurrent sparsity sweeps, each with its own memory object
+  class SpWorkers {
+  public:
+    SpWorkers(const FunctionInternal* f, casadi_int iind, casadi_int oind,
+              casadi_int n_sweep) : f_(f) {
+      casadi_int n = std::min(GlobalOptions::sparsity_num_threads, n_sweep);
+      w_.resize(std::max(casadi_int(1), n));
+      for (casadi_int k=0; k<w_.size(); ++k) {
+        SpWorker& wk = w_[k];
+        wk.s_in.resize(f->nnz_in(iind), 0);
+        wk.s_out.resize(f->nnz_out(oind), 0);
+        wk.arg_fwd.resize(f->sz_arg(), nullptr);
+        wk.arg_adj.resize(f->sz_arg(), nullptr);
+        wk.res.resize(f->sz_res(), nullptr);
+        wk.arg_fwd[iind] = wk.arg_adj[iind] = get_ptr(wk.s_in);
+        wk.res[oind] = get_ptr(wk.s_out);
+        wk.iw.resize(f->sz_iw());
+        wk.w.resize(f->sz_w(), 0);
+        // The first worker uses the default memory object
+        wk.mem = k==0 ? 0 : f->checkout();
+      }
+    }
+    ~SpWorkers() {
+      for (casadi_int k=1; k<w_.size(); ++k) f_->release(w_[k].mem);
+    }
+    // Number of workers
+    casadi_int size() const { return w_.size();}
+    // Access a worker
+    SpWorker& operator[](casadi_int k) { return w_[k];}
+    // Propagate dependencies
+    template<bool fwd>
+    void sp(casadi_int k) {
+      SpWorker& wk = w_[k];
+      if (fwd) {
+        JacSparsityTraits<true>::sp(f_, get_ptr(wk.arg_fwd), get_ptr(wk.res),
+          get_ptr(wk.iw), get_ptr(wk.w), f_->memory(wk.mem));
+      } else {
+        std::fill(wk.w.begin(), wk.w.end(), 0);
+        JacSparsityTraits<false>::sp(f_, get_ptr(wk.arg_adj), get_ptr(wk.res),
+          get_ptr(wk.iw), get_ptr(wk.w), f_->memory(wk.mem));
+      }
+    }
+  private:
+    const FunctionInternal* f_;
+    std::vector<SpWorker> w_;
+  };
+
+  // One sweep of the hierarchical sparsity detection
+  struct SpSweep {
+    // Seeds to be toggled, (begin, end, bit) triples
+    std::vector<casadi_int> toggle;
+    // Lookup table (bvec bit x coarse block) in compressed column format
+    std::vector<casadi_int> lookup_colind, lookup_row, lookup_value;
+    // Dependencies found
+    std::vector<casadi_int> jrow, jcol;
+    // Set lookup table
+    void set_lookup(const IM& lookup) {
+      lookup_colind = lookup.sparsity().get_colind();
+      lookup_row = lookup.sparsity().get_row();
+      lookup_value = lookup.nonzeros();
+    }
+    // Index into lookup_value, -1 if no entry
+    casadi_int find(casadi_int bit, casadi_int c) const {
+      auto begin = lookup_row.begin() + lookup_colind[c];
+      auto end = lookup_row.begin() + lookup_colind[c+1];
+      auto it = std::lower_bound(begin, end, bit);
+      return it!=end && *it==bit ? it - lookup_row.begin() : -1;
+    }
+    // Apply the seeds
+    void seed(bvec_t* s) const {
+      for (casadi_int i=0; i<toggle.size(); i+=3) {
+        bvec_toggle(s, toggle[i], toggle[i+1], toggle[i+2]);
+      }
+    }
+  };
+  /// \endcond
+
   template<bool fwd>
   Sparsity FunctionInternal::
   getJacSparsityGen(casadi_int iind, casadi_int oind, bool symmetric,
       casadi_int gr_i, casadi_int gr_o) const {
-    // Number of nonzero inputs and outputs
-    casadi_int nz_in = nnz_in(iind);
-    casadi_int nz_out = nnz_out(oind);
-
-    // Evaluation buffers
-    vector<typename JacSparsityTraits<fwd>::arg_t> arg(sz_arg(), nullptr);
-    vector<bvec_t*> res(sz_res(), nullptr);
-    vector<casadi_int> iw(sz_iw());
-    vector<bvec_t> w(sz_w(), 0);
-
-    // Seeds and sensitivities
-    vector<bvec_t> seed(nz_in, 0);
-    arg[iind] = get_ptr(seed);
-    vector<bvec_t> sens(nz_out, 0);
-    res[oind] = get_ptr(sens);
-    if (!fwd) std::swap(seed, sens);
+    // Number of seed and sensitivity directions
+    casadi_int n_seed = fwd ? nnz_in(iind) : nnz_out(oind);
+    casadi_int n_sens = fwd ? nnz_out(oind) : nnz_in(iind);
 
     // Number of forward sweeps we must make
-    casadi_int nsweep = seed.size() / bvec_size;
-    if (seed.size() % bvec_size) nsweep++;
+    casadi_int nsweep = n_seed / bvec_size;
+    if (n_seed % bvec_size) nsweep++;
+
+    // Evaluation buffers for each thread
+    SpWorkers workers(this, iind, oind, nsweep);
 
     // Print
     if (verbose_) {
       casadi_message(str(nsweep) + string(fwd ? " forward" : " reverse") + " sweeps "
-                     "needed for " + str(seed.size()) + " directions");
+                     "needed for " + str(n_seed) + " directions using "
+                     + str(workers.size()) + " thread(s)");
     }
 
-    // Progress
+    // Progress, only printed in serial mode
     casadi_int progress = -10;
 
-    // Temporary vectors
-    std::vector<casadi_int> jcol, jrow;
-
-    // Loop over the variables, bvec_size variables at a time
-    for (casadi_int s=0; s<nsweep; ++s) {
+    // Dependencies found in each sweep
+    std::vector<std::vector<casadi_int> > jcol(nsweep), jrow(nsweep);
 
+    // Sweep s, bvec_size variables at a time, by worker k
+    auto sweep = [&](casadi_int k, casadi_int s) {
       // Print progress
-      if (verbose_) {
+      if (verbose_ && workers.size()==1) {
         casadi_int progress_new = (s*100)/nsweep;
         // Print when entering a new decade
         if (progress_new / 10 > progress / 10) {
@@ -1001,11 +1155,15 @@ namespace casadi {
         }
       }
 
+      // Seeds and sensitivities of the worker
+      bvec_t* seed = fwd ? get_ptr(workers[k].s_in) : get_ptr(workers[k].s_out);
+      bvec_t* sens = fwd ? get_ptr(workers[k].s_out) : get_ptr(workers[k].s_in);
+
       // Nonzero offset
       casadi_int offset = s*bvec_size;
 
       // Number of local seed directions
-      casadi_int ndir_local = seed.size()-offset;
+      casadi_int ndir_local = n_seed-offset;
       ndir_local = std::min(static_cast<casadi_int>(bvec_size), ndir_local);
 
       for (casadi_int i=0; i<ndir_local; ++i) {
@@ -1013,11 +1171,10 @@ namespace casadi {
       }
 
       // Propagate the dependencies
-      JacSparsityTraits<fwd>::sp(this, get_ptr(arg), get_ptr(res),
-                                  get_ptr(iw), get_ptr(w), memory(0));
+      workers.sp<fwd>(k);
 
       // Loop over the nonzeros of the output
-      for (casadi_int el=0; el<sens.size(); ++el) {
+      for (casadi_int el=0; el<n_sens; ++el) {
 
         // Get the sparsity sensitivity
         bvec_t spsens = sens[el];
@@ -1036,8 +1193,8 @@ namespace casadi {
             // If dependents on the variable
             if ((bvec_t(1) << i) & spsens) {
               // Add to pattern
-              jcol.push_back(el);
-              jrow.push_back(i+offset);
+              jcol[s].push_back(el);
+              jrow[s].push_back(i+offset);
             }
           }
         }
@@ -1047,11 +1204,19 @@ namespace casadi {
       for (casadi_int i=0; i<ndir_local; ++i) {
         seed[offset+i] = 0;
       }
+    };
+    ThreadPool::instance().run(nsweep, workers.size(), sweep, 1);
+
+    // Collect the dependencies, in the order of the sweeps
+    std::vector<casadi_int> jcol_all, jrow_all;
+    for (casadi_int s=0; s<nsweep; ++s) {
+      jcol_all.insert(jcol_all.end(), jcol[s].begin(), jcol[s].end());
+      jrow_all.insert(jrow_all.end(), jrow[s].begin(), jrow[s].end());
     }
 
     // Construct sparsity pattern and return
-    if (!fwd) swap(jrow, jcol);
-    Sparsity ret = Sparsity::triplet(nz_out, nz_in, jcol, jrow);
+    if (!fwd) swap(jrow_all, jcol_all);
+    Sparsity ret = Sparsity::triplet(nnz_out(oind), nnz_in(iind), jcol_all, jrow_all);
     if (verbose_) {
       casadi_message("Formed Jacobian sparsity pattern (dimension " + str(ret.size()) + ", "
           + str(ret.nnz()) + " (" + str(ret.density()) + " %) nonzeros.");
@@ -1067,19 +1232,8 @@ namespace casadi {
     casadi_int nz = nnz_in(iind);
     casadi_assert_dev(nz==nnz_out(oind));
 
-    // Evaluation buffers
-    vector<const bvec_t*> arg(sz_arg(), nullptr);
-    vector<bvec_t*> res(sz_res(), nullptr);
-    vector<casadi_int> iw(sz_iw());
-    vector<bvec_t> w(sz_w());
-
-    // Seeds
-    vector<bvec_t> seed(nz, 0);
-    arg[iind] = get_ptr(seed);
-
-    // Sensitivities
-    vector<bvec_t> sens(nz, 0);
-    res[oind] = get_ptr(sens);
+    // Evaluation buffers for each thread
+    SpWorkers workers(this, iind, oind, GlobalOptions::sparsity_num_threads);
 
     // Sparsity triplet accumulator
     std::vector<casadi_int> jcol, jrow;
@@ -1119,9 +1273,6 @@ namespace casadi {
           + str(D.size2()) + " <-> " + str(D.size1()));
       }
 
-      // Clear the seeds
-      fill(seed.begin(), seed.end(), 0);
-
       // Subdivide the coarse block
       for (casadi_int k=0; k<coarse.size()-1; ++k) {
         casadi_int diff = coarse[k+1]-coarse[k];
@@ -1145,6 +1296,52 @@ namespace casadi {
       std::vector<casadi_int> lookup_row;
       std::vector<casadi_int> lookup_value;
 
+      // Calculate sparsity for bvec_size directions at once, by some worker
+      auto run_sweep = [&](casadi_int k, SpSweep& sw) {
+        bvec_t* seed = get_ptr(workers[k].s_in);
+        bvec_t* sens = get_ptr(workers[k].s_out);
+
+        // Propagate the dependencies
+        sw.seed(seed);
+        workers.sp<true>(k);
+
+        // Temporary bit work vector
+        bvec_t spsens;
+
+        // Loop over the cols of coarse blocks
+        for (casadi_int cri=0; cri<coarse.size()-1; ++cri) {
+
+          // Loop over the cols of fine blocks within the current coarse block
+          for (casadi_int fri=fine_lookup[coarse[cri]];fri<fine_lookup[coarse[cri+1]];++fri) {
+            // Lump individual sensitivities together into fine block
+            bvec_or(sens, spsens, fine[fri], fine[fri+1]);
+
+            // Loop over all bvec_bits
+            for (casadi_int bvec_i=0;bvec_i<bvec_size;++bvec_i) {
+              if (spsens & (bvec_t(1) << bvec_i)) {
+                // if dependency is found, add it to the new sparsity pattern
+                casadi_int ind = sw.find(bvec_i, cri);
+                if (ind==-1) continue;
+                casadi_int lk = sw.lookup_value[ind];
+                if (lk>-bvec_size) {
+                  sw.jrow.push_back(bvec_i+lk);
+                  sw.jcol.push_back(fri);
+                  sw.jrow.push_back(fri);
+                  sw.jcol.push_back(bvec_i+lk);
+                }
+              }
+            }
+          }
+        }
+
+        // Clear the forward seeds, ready for next bvec sweep
+        fill(workers[k].s_in.begin(), workers[k].s_in.end(), 0);
+      };
+
+      // Sweeps to be performed, the one being assembled
+      std::vector<SpSweep> sweeps;
+      SpSweep sweep;
+
       // The maximum number of fine blocks contained in one coarse block
       casadi_int n_fine_blocks_max = 0;
       for (casadi_int i=0;i<coarse.size()-1;++i) {
@@ -1192,8 +1389,9 @@ namespace casadi {
               }
 
               // Toggle on seeds
-              bvec_toggle(get_ptr(seed), fine[fci+fci_start], fine[fci+fci_start+1],
-                          bvec_i+bvec_i_mod);
+              sweep.toggle.push_back(fine[fci+fci_start]);
+              sweep.toggle.push_back(fine[fci+fci_start+1]);
+              sweep.toggle.push_back(bvec_i+bvec_i_mod);
               bvec_i_mod++;
             }
           }
@@ -1203,7 +1401,7 @@ namespace casadi {
 
           // Check if bvec buffer is full
           if (bvec_i==bvec_size || csd==D.size2()-1) {
-            // Calculate sparsity for bvec_size directions at once
+            // A sweep for bvec_size directions at once is complete
 
             // Statistics
             nsweeps+=1;
@@ -1221,41 +1419,17 @@ namespace casadi {
             duplicates = sparsify(duplicates);
             lookup(duplicates.sparsity()) = -bvec_size;
 
-            // Propagate the dependencies
-            JacSparsityTraits<true>::sp(this, get_ptr(arg), get_ptr(res),
-              get_ptr(iw), get_ptr(w), nullptr);
-
-            // Temporary bit work vector
-            bvec_t spsens;
-
-            // Loop over the cols of coarse blocks
-            for (casadi_int cri=0; cri<coarse.size()-1; ++cri) {
-
-              // Loop over the cols of fine blocks within the current coarse block
-              for (casadi_int fri=fine_lookup[coarse[cri]];fri<fine_lookup[coarse[cri+1]];++fri) {
-                // Lump individual sensitivities together into fine block
-                bvec_or(get_ptr(sens), spsens, fine[fri], fine[fri+1]);
-
-                // Loop over all bvec_bits
-                for (casadi_int bvec_i=0;bvec_i<bvec_size;++bvec_i) {
-                  if (spsens & (bvec_t(1) << bvec_i)) {
-                    // if dependency is found, add it to the new sparsity pattern
-                    casadi_int ind = lookup.sparsity().get_nz(bvec_i, cri);
-                    if (ind==-1) continue;
-                    casadi_int lk = lookup->at(ind);
-                    if (lk>-bvec_size) {
-                      jrow.push_back(bvec_i+lk);
-                      jcol.push_back(fri);
-                      jrow.push_back(fri);
-                      jcol.push_back(bvec_i+lk);
-                    }
-                  }
-                }
-              }
+            sweep.set_lookup(lookup);
+            if (workers.size()==1) {
+              // Run the sweep right away, no need to keep it around
+              run_sweep(0, sweep);
+              jrow.insert(jrow.end(), sweep.jrow.begin(), sweep.jrow.end());
+              jcol.insert(jcol.end(), sweep.jcol.begin(), sweep.jcol.end());
+            } else {
+              // Queue the sweep for the workers
+              sweeps.push_back(std::move(sweep));
             }
-
-            // Clear the forward seeds/adjoint sensitivities, ready for next bvec sweep
-            fill(seed.begin(), seed.end(), 0);
+            sweep = SpSweep();
 
             // Clean lookup table
             lookup_col.clear();
@@ -1273,6 +1447,16 @@ namespace casadi {
         }
       }
 
+      // Run the queued sweeps concurrently
+      ThreadPool::instance().run(sweeps.size(), workers.size(),
+        [&](casadi_int k, casadi_int s) { run_sweep(k, sweeps[s]);}, 1);
+
+      // Collect the dependencies, in the order of the sweeps
+      for (auto&& sw : sweeps) {
+        jrow.insert(jrow.end(), sw.jrow.begin(), sw.jrow.end());
+        jcol.insert(jcol.end(), sw.jcol.begin(), sw.jcol.end());
+      }
+
       // Construct fine sparsity pattern
       r = Sparsity::triplet(fine.size()-1, fine.size()-1, jrow, jcol);
 
@@ -1302,18 +1486,8 @@ namespace casadi {
     // Number of nonzero outputs
     casadi_int nz_out = nnz_out(oind);
 
-    // Seeds and sensitivities
-    vector<bvec_t> s_in(nz_in, 0);
-    vector<bvec_t> s_out(nz_out, 0);
-
-    // Evaluation buffers
-    vector<const bvec_t*> arg_fwd(sz_arg(), nullptr);
-    vector<bvec_t*> arg_adj(sz_arg(), nullptr);
-    arg_fwd[iind] = arg_adj[iind] = get_ptr(s_in);
-    vector<bvec_t*> res(sz_res(), nullptr);
-    res[oind] = get_ptr(s_out);
-    vector<casadi_int> iw(sz_iw());
-    vector<bvec_t> w(sz_w());
+    // Evaluation buffers for each thread
+    SpWorkers workers(this, iind, oind, GlobalOptions::sparsity_num_threads);
 
     // Sparsity triplet accumulator
     std::vector<casadi_int> jcol, jrow;
@@ -1392,17 +1566,10 @@ namespace casadi {
             "(fwd cost: " + str(fwd_cost) + ", adj cost: " + str(adj_cost) + ")");
       }
 
-      // Get seeds and sensitivities
-      bvec_t* seed_v = use_fwd ? get_ptr(s_in) : get_ptr(s_out);
-      bvec_t* sens_v = use_fwd ? get_ptr(s_out) : get_ptr(s_in);
-
       // The number of zeros in the seed and sensitivity directions
       casadi_int nz_seed = use_fwd ? nz_in  : nz_out;
       casadi_int nz_sens = use_fwd ? nz_out : nz_in;
 
-      // Clear the seeds
-      for (casadi_int i=0; i<nz_seed; ++i) seed_v[i]=0;
-
       // Choose the active jacobian coloring scheme
       Sparsity D = use_fwd ? D1 : D2;
 
@@ -1448,6 +1615,56 @@ namespace casadi {
       std::vector<casadi_int> lookup_value;
 
 
+      // Calculate sparsity for bvec_size directions at once, by some worker
+      auto run_sweep = [&](casadi_int k, SpSweep& sw) {
+        bvec_t* seed_v = use_fwd ? get_ptr(workers[k].s_in) : get_ptr(workers[k].s_out);
+        bvec_t* sens_v = use_fwd ? get_ptr(workers[k].s_out) : get_ptr(workers[k].s_in);
+
+        // Propagate the dependencies
+        sw.seed(seed_v);
+        if (use_fwd) {
+          workers.sp<true>(k);
+        } else {
+          workers.sp<false>(k);
+        }
+
+        // Temporary bit work vector
+        bvec_t spsens;
+
+        // Loop over the cols of coarse blocks
+        for (casadi_int cri=0;cri<coarse_col.size()-1;++cri) {
+
+          // Loop over the cols of fine blocks within the current coarse block
+          for (casadi_int fri=fine_col_lookup[coarse_col[cri]];
+               fri<fine_col_lookup[coarse_col[cri+1]];++fri) {
+            // Lump individual sensitivities together into fine block
+            bvec_or(sens_v, spsens, fine_col[fri], fine_col[fri+1]);
+
+            // Next iteration if no sparsity
+            if (!spsens) continue;
+
+            // Loop over all bvec_bits
+            for (casadi_int bvec_i=0;bvec_i<bvec_size;++bvec_i) {
+              if (spsens & bvec_lookup[bvec_i]) {
+                // if dependency is found, add it to the new sparsity pattern
+                casadi_int ind = sw.find(bvec_i, cri);
+                if (ind==-1) continue;
+                sw.jrow.push_back(bvec_i+sw.lookup_value[ind]);
+                sw.jcol.push_back(fri);
+              }
+            }
+          }
+        }
+
+        // Clear the seeds and sensitivities, ready for next bvec sweep
+        fill(workers[k].s_in.begin(), workers[k].s_in.end(), 0);
+        fill(workers[k].s_out.begin(), workers[k].s_out.end(), 0);
+      };
+
+      // Sweeps to be performed, the one being assembled
+      std::vector<SpSweep> sweeps;
+      SpSweep sweep;
+
       // The maximum number of fine blocks contained in one coarse block
       casadi_int n_fine_blocks_max = 0;
       for (casadi_int i=0;i<coarse_row.size()-1;++i) {
@@ -1492,8 +1709,9 @@ namespace casadi {
               }
 
               // Toggle on seeds
-              bvec_toggle(seed_v, fine_row[fci+fci_start], fine_row[fci+fci_start+1],
-                          bvec_i+bvec_i_mod);
+              sweep.toggle.push_back(fine_row[fci+fci_start]);
+              sweep.toggle.push_back(fine_row[fci+fci_start+1]);
+              sweep.toggle.push_back(bvec_i+bvec_i_mod);
               bvec_i_mod++;
             }
           }
@@ -1503,7 +1721,7 @@ namespace casadi {
 
           // Check if bvec buffer is full
           if (bvec_i==bvec_size || csd==D.size2()-1) {
-            // Calculate sparsity for bvec_size directions at once
+            // A sweep for bvec_size directions at once is complete
 
             // Statistics
             nsweeps+=1;
@@ -1512,49 +1730,17 @@ namespace casadi {
             IM lookup = IM::triplet(lookup_row, lookup_col, lookup_value, bvec_size,
                                     coarse_col.size());
 
-            // Propagate the dependencies
-            if (use_fwd) {
-              JacSparsityTraits<true>::sp(this, get_ptr(arg_fwd), get_ptr(res),
-                get_ptr(iw), get_ptr(w), memory(0));
+            sweep.set_lookup(lookup);
+            if (workers.size()==1) {
+              // Run the sweep right away, no need to keep it around
+              run_sweep(0, sweep);
+              jrow.insert(jrow.end(), sweep.jrow.begin(), sweep.jrow.end());
+              jcol.insert(jcol.end(), sweep.jcol.begin(), sweep.jcol.end());
             } else {
-              fill(w.begin(), w.end(), 0);
-              JacSparsityTraits<false>::sp(this, get_ptr(arg_adj), get_ptr(res),
-                get_ptr(iw), get_ptr(w), memory(0));
-            }
-
-            // Temporary bit work vector
-            bvec_t spsens;
-
-            // Loop over the cols of coarse blocks
-            for (casadi_int cri=0;cri<coarse_col.size()-1;++cri) {
-
-              // Loop over the cols of fine blocks within the current coarse block
-              for (casadi_int fri=fine_col_lookup[coarse_col[cri]];
-                   fri<fine_col_lookup[coarse_col[cri+1]];++fri) {
-                // Lump individual sensitivities together into fine block
-                bvec_or(sens_v, spsens, fine_col[fri], fine_col[fri+1]);
-
-                // Next iteration if no sparsity
-                if (!spsens) continue;
-
-                // Loop over all bvec_bits
-                for (casadi_int bvec_i=0;bvec_i<bvec_size;++bvec_i) {
-                  if (spsens & bvec_lookup[bvec_i]) {
-                    // if dependency is found, add it to the new sparsity pattern
-                    casadi_int ind = lookup.sparsity().get_nz(bvec_i, cri);
-                    if (ind==-1) continue;
-                    jrow.push_back(bvec_i+lookup->at(ind));
-                    jcol.push_back(fri);
-                  }
-                }
-              }
+              // Queue the sweep for the workers
+              sweeps.push_back(std::move(sweep));
             }
-
-            // Clear the forward seeds/adjoint sensitivities, ready for next bvec sweep
-            fill(s_in.begin(), s_in.end(), 0);
-
-            // Clear the adjoint seeds/forward sensitivities, ready for next bvec sweep
-            fill(s_out.begin(), s_out.end(), 0);
+            sweep = SpSweep();
 
             // Clean lookup table
             lookup_col.clear();
@@ -1574,6 +1760,16 @@ namespace casadi {
 
       }
 
+      // Run the queued sweeps concurrently
+      ThreadPool::instance().run(sweeps.size(), workers.size(),
+        [&](casadi_int k, casadi_int s) { run_sweep(k, sweeps[s]);}, 1);
+
+      // Collect the dependencies, in the order of the sweeps
+      for (auto&& sw : sweeps) {
+        jrow.insert(jrow.end(), sw.jrow.begin(), sw.jrow.end());
+        jcol.insert(jcol.end(), sw.jcol.begin(), sw.jcol.end());
+      }
+
       // Swap results if adjoint mode was used
       if (use_fwd) {
         // Construct fine sparsity pattern
@@ -1741,7 +1937,8 @@ namespace casadi {
 
       // Star coloring if symmetric
       if (verbose_) casadi_message("FunctionInternal::getPartition star_coloring");
-      D1 = A.star_coloring();
+      casadi_int ordering = GlobalOptions::coloring_ordering;
+      D1 = A.star_coloring(ordering<0 ? 1 : ordering);
       if (verbose_) {
         casadi_message("Star coloring completed: " + str(D1.size2())
           + " directional derivatives needed ("
@@ -1758,6 +1955,10 @@ namespace casadi {
       if (w==0) allow_reverse = false;
       casadi_assert(allow_forward || allow_reverse, "Conflicting ad weights");
 
+      // Vertex ordering and number of threads for the unidirectional colorings
+      casadi_int ordering = max(GlobalOptions::coloring_ordering, casadi_int(0));
+      casadi_int num_threads = GlobalOptions::sparsity_num_threads;
+
       // Best coloring encountered so far (relatively tight upper bound)
       double best_coloring = numeric_limits<double>::infinity();
 
@@ -1781,7 +1982,7 @@ namespace casadi {
           bool d = best_coloring>=w*static_cast<double>(A.size1());
           casadi_int max_colorings_to_test =
             d ? A.size1() : static_cast<casadi_int>(floor(best_coloring/w));
-          D1 = AT.uni_coloring(A, max_colorings_to_test);
+          D1 = AT.uni_coloring(A, max_colorings_to_test, ordering, num_threads);
           if (D1.is_null()) {
             if (verbose_) {
               casadi_message("Forward mode coloring interrupted (more than "
@@ -1802,7 +2003,7 @@ namespace casadi {
           casadi_int max_colorings_to_test =
             d ? A.size2() : static_cast<casadi_int>(floor(best_coloring/(1-w)));
 
-          D2 = A.uni_coloring(AT, max_colorings_to_test);
+          D2 = A.uni_coloring(AT, max_colorings_to_test, ordering, num_threads);
           if (D2.is_null()) {
             if (verbose_) {
               casadi_message("Adjoint mode coloring interrupted (more than "
@@ -2250,8 +2451,7 @@ namespace casadi {
     codegen_sparsities(g);
 
     // Determine work vector size
-    casadi_int sz_w_codegen = sz_w();
-    if (is_a("SXFunction", true) && !g.avoid_stack()) sz_w_codegen = 0;
+    casadi_int sz_w_codegen = codegen_sz_w(g);
 
     // Function that returns work vector lengths
     g << g.declare(
@@ -2682,6 +2882,9 @@ namespace casadi {
         }
       }
 
+    } else if (jac_num_threads_>1 && nfwd>max_num_dir_) {
+      // Evaluate the batches concurrently
+      call_forward_batches(arg, res, fseed, fsens);
     } else {
       // Evaluate in batches
       casadi_assert_dev(enable_forward_ || enable_fd_);
@@ -2790,6 +2993,9 @@ namespace casadi {
           }
         }
       }
+    } else if (jac_num_threads_>1 && nadj>max_num_dir_) {
+      // Evaluate the batches concurrently
+      call_reverse_batches(arg, res, aseed, asens);
     } else {
       // Evaluate in batches
       casadi_assert_dev(enable_reverse_);
@@ -2840,6 +3046,126 @@ namespace casadi {
     }
   }
 
+  void FunctionInternal::
+  call_forward_batches(const std::vector<MX>& arg, const std::vector<MX>& res,
+                       const std::vector<std::vector<MX> >& fseed,
+                       std::vector<std::vector<MX> >& fsens) const {
+    // Number of directional derivatives
+    casadi_int nfwd = fseed.size();
+    fsens.resize(nfwd);
+    if (nfwd==0) return;
+
+    // Number of directions in each batch
+    casadi_assert_dev(jac_num_threads_>1);
+    casadi_assert_dev(enable_forward_ || enable_fd_);
+    casadi_int max_nfwd = max_num_dir_;
+    if (!enable_fd_) {
+      while (!has_forward(max_nfwd)) max_nfwd/=2;
+    }
+    casadi_int nfwd_batch = min(nfwd, max_nfwd);
+    casadi_int n_batch = (nfwd+nfwd_batch-1)/nfwd_batch;
+
+    // Forward derivative, mapped over the batches
+    Function dfcn = self().forward(nfwd_batch);
+    if (n_batch>1) dfcn = dfcn.map(n_batch, "thread", jac_num_threads_);
+
+    // All inputs and seeds
+    vector<MX> darg;
+    darg.reserve(n_in_ + n_out_ + n_in_);
+    for (casadi_int i=0; i<n_in_; ++i) darg.push_back(repmat(arg[i], 1, n_batch));
+    for (casadi_int i=0; i<n_out_; ++i) darg.push_back(repmat(res[i], 1, n_batch));
+    vector<MX> v(n_batch*nfwd_batch);
+    for (casadi_int i=0; i<n_in_; ++i) {
+      for (casadi_int d=0; d<v.size(); ++d) v[d] = d<nfwd ? fseed[d][i] : MX(size_in(i));
+      darg.push_back(horzcat(v));
+    }
+
+    // Create the evaluation node
+    vector<MX> x = dfcn(darg);
+    casadi_assert_dev(x.size()==n_out_);
+
+    // Retrieve sensitivities, dropping the padding
+    for (casadi_int d=0; d<nfwd; ++d) fsens[d].resize(n_out_);
+    for (casadi_int i=0; i<n_out_; ++i) {
+      if (size2_out(i)>0) {
+        v = horzsplit(x[i], size2_out(i));
+        casadi_assert_dev(v.size()==n_batch*nfwd_batch);
+      } else {
+        v = vector<MX>(nfwd, MX(size_out(i)));
+      }
+      for (casadi_int d=0; d<nfwd; ++d) fsens[d][i] = v[d];
+    }
+  }
+
+  void FunctionInternal::
+  call_reverse_batches(const std::vector<MX>& arg, const std::vector<MX>& res,
+                       const std::vector<std::vector<MX> >& aseed,
+                       std::vector<std::vector<MX> >& asens) const {
+    // Number of directional derivatives
+    casadi_int nadj = aseed.size();
+    asens.resize(nadj);
+    if (nadj==0) return;
+
+    // Number of directions in each batch
+    casadi_assert_dev(jac_num_threads_>1);
+    casadi_assert_dev(enable_reverse_);
+    casadi_int max_nadj = max_num_dir_;
+    while (!has_reverse(max_nadj)) max_nadj/=2;
+    casadi_int nadj_batch = min(nadj, max_nadj);
+    casadi_int n_batch = (nadj+nadj_batch-1)/nadj_batch;
+
+    // Reverse derivative, mapped over the batches
+    Function dfcn = self().reverse(nadj_batch);
+    if (n_batch>1) dfcn = dfcn.map(n_batch, "thread", jac_num_threads_);
+
+    // All inputs and seeds
+    vector<MX> darg;
+    darg.reserve(n_in_ + n_out_ + n_out_);
+    for (casadi_int i=0; i<n_in_; ++i) darg.push_back(repmat(arg[i], 1, n_batch));
+    for (casadi_int i=0; i<n_out_; ++i) darg.push_back(repmat(res[i], 1, n_batch));
+    vector<MX> v(n_batch*nadj_batch);
+    for (casadi_int i=0; i<n_out_; ++i) {
+      for (casadi_int d=0; d<v.size(); ++d) v[d] = d<nadj ? aseed[d][i] : MX(size_out(i));
+      darg.push_back(horzcat(v));
+    }
+
+    // Create the evaluation node
+    vector<MX> x = dfcn(darg);
+    casadi_assert_dev(x.size()==n_in_);
+
+    // Retrieve sensitivities, dropping the padding
+    for (casadi_int d=0; d<nadj; ++d) asens[d].resize(n_in_);
+    for (casadi_int i=0; i<n_in_; ++i) {
+      if (size2_in(i)>0) {
+        v = horzsplit(x[i], size2_in(i));
+        casadi_assert_dev(v.size()==n_batch*nadj_batch);
+      } else {
+        v = vector<MX>(nadj, MX(size_in(i)));
+      }
+      for (casadi_int d=0; d<nadj; ++d) {
+        if (asens[d][i].is_empty(true)) {
+          asens[d][i] = v[d];
+        } else {
+          asens[d][i] += v[d];
+        }
+      }
+    }
+  }
+
+  void FunctionInternal::
+  call_forward_batches(const std::vector<SX>& arg, const std::vector<SX>& res,
+                       const std::vector<std::vector<SX> >& fseed,
+                       std::vector<std::vector<SX> >& fsens) const {
+    casadi_error("'forward' batches (SX) not defined for " + class_name());
+  }
+
+  void FunctionInternal::
+  call_reverse_batches(const std::vector<SX>& arg, const std::vector<SX>& res,
+                       const std::vector<std::vector<SX> >& aseed,
+                       std::vector<std::vector<SX> >& asens) const {
+    casadi_error("'reverse' batches (SX) not defined for " + class_name());
+  }
+
   void FunctionInternal::
   call_forward(const std::vector<SX>& arg, const std::vector<SX>& res,
              const std::vector<std::vector<SX> >& fseed,
@@ -3143,8 +3469,8 @@ namespace casadi {
   }
 
   void ProtoFunction::clear_mem() {
-    for (auto&& i : mem_) {
-      if (i!=nullptr) free_mem(i);
+    for (casadi_int i=0; i<mem_.size(); ++i) {
+      if (mem_[i]!=nullptr) free_mem(mem_[i]);
     }
     mem_.clear();
   }
@@ -3222,37 +3548,28 @@ namespace casadi {
   }
 
   void* ProtoFunction::memory(int ind) const {
-#ifdef CASADI_WITH_THREAD
-    std::lock_guard<std::mutex> lock(mtx_);
-#endif //CASADI_WITH_THREAD
-    return mem_.at(ind);
+    casadi_assert(ind>=0 && ind<mem_.size(), "Memory object " + str(ind) + " does not exist");
+    return mem_[ind];
   }
 
   int ProtoFunction::checkout() const {
+    // Use an unused memory object, if any (lock-free)
+    casadi_int m = mem_.pop();
+    if (m>=0) return m;
+    // Allocate a new memory object
 #ifdef CASADI_WITH_THREAD
     std::lock_guard<std::mutex> lock(mtx_);
 #endif //CASADI_WITH_THREAD
-    if (unused_.empty()) {
-      // Allocate a new memory object
-      void* m = alloc_mem();
-      mem_.push_back(m);
-      if (init_mem(m)) {
-        casadi_error("Failed to create or initialize memory object");
-      }
-      return mem_.size()-1;
-    } else {
-      // Use an unused memory object
-      casadi_int m = unused_.top();
-      unused_.pop();
-      return m;
+    void* mem = alloc_mem();
+    m = mem_.add(mem);
+    if (init_mem(mem)) {
+      casadi_error("Failed to create or initialize memory object");
     }
+    return m;
   }
 
   void ProtoFunction::release(int mem) const {
-#ifdef CASADI_WITH_THREAD
-    std::lock_guard<std::mutex> lock(mtx_);
-#endif //CASADI_WITH_THREAD
-    unused_.push(mem);
+    mem_.push(mem);
   }
 
   Function FunctionInternal::
@@ -3541,7 +3858,7 @@ namespace casadi {
 
   void FunctionInternal::serialize_body(SerializingStream& s) const {
     ProtoFunction::serialize_body(s);
-    s.version("FunctionInternal", 2);
+    s.version("FunctionInternal", 4);
     s.pack("FunctionInternal::is_diff_in", is_diff_in_);
     s.pack("FunctionInternal::is_diff_out", is_diff_out_);
     s.pack("FunctionInternal::sp_in", sparsity_in_);
@@ -3563,6 +3880,7 @@ namespace casadi {
     s.pack("FunctionInternal::jit_temp_suffix", jit_temp_suffix_);
     s.pack("FunctionInternal::jit_base_name", jit_base_name_);
     s.pack("FunctionInternal::jit_options", jit_options_);
+    s.pack("FunctionInternal::jit_codegen_options", jit_codegen_options_);
     s.pack("FunctionInternal::compiler_plugin", compiler_plugin_);
     s.pack("FunctionInternal::has_refcount", has_refcount_);
 
@@ -3585,6 +3903,7 @@ namespace casadi {
     s.pack("FunctionInternal::never_inline", never_inline_);
 
     s.pack("FunctionInternal::max_num_dir", max_num_dir_);
+    s.pack("FunctionInternal::jac_num_threads", jac_num_threads_);
 
     s.pack("FunctionInternal::regularity_check", regularity_check_);
 
@@ -3614,7 +3933,7 @@ namespace casadi {
   }
 
   FunctionInternal::FunctionInternal(DeserializingStream& s) : ProtoFunction(s) {
-    int version = s.version("FunctionInternal", 1, 2);
+    int version = s.version("FunctionInternal", 1, 4);
     s.unpack("FunctionInternal::is_diff_in", is_diff_in_);
     s.unpack("FunctionInternal::is_diff_out", is_diff_out_);
     s.unpack("FunctionInternal::sp_in", sparsity_in_);
@@ -3647,8 +3966,10 @@ namespace casadi {
       compiler_ = Importer(library, "dll");
     }
     s.unpack("FunctionInternal::jit_temp_suffix", jit_temp_suffix_);
+    jit_cached_ = false;
     s.unpack("FunctionInternal::jit_base_name", jit_base_name_);
     s.unpack("FunctionInternal::jit_options", jit_options_);
+    if (version>=4) s.unpack("FunctionInternal::jit_codegen_options", jit_codegen_options_);
     s.unpack("FunctionInternal::compiler_plugin", compiler_plugin_);
     s.unpack("FunctionInternal::has_refcount", has_refcount_);
 
@@ -3671,6 +3992,11 @@ namespace casadi {
     s.unpack("FunctionInternal::never_inline", never_inline_);
 
     s.unpack("FunctionInternal::max_num_dir", max_num_dir_);
+    if (version>=3) {
+      s.unpack("FunctionInternal::jac_num_threads", jac_num_threads_);
+    } else {
+      jac_num_threads_ = 1;
+    }
 
     s.unpack("FunctionInternal::regularity_check", regularity_check_);
 
@@ -35,6 +35,7 @@
 #include "options.hpp"
 #include "shared_object_internal.hpp"
 #include "timing.hpp"
+#include "memory_list.hpp"
 #ifdef CASADI_WITH_THREAD
 #ifdef CASADI_WITH_THREAD_MINGW
 #include <mingw.mutex.h>
@@ -190,11 +191,8 @@ namespace casadi {
 #endif // CASADI_WITH_THREAD
 
   private:
-    /// Memory objects
-    mutable std::vector<void*> mem_;
-
-    /// Unused memory objects
-    mutable std::stack<casadi_int> unused_;
+    /// Memory objects, with a lock-free list of the unused ones
+    mutable MemoryList mem_;
   };
 
   /** \brief Internal class for Function
@@ -435,6 +433,36 @@ namespace casadi {
                             bool always_inline, bool never_inline) const;
     ///@}
 
+    ///@{
+    /** \brief Forward mode AD in batches of max_num_dir directions
+     *
+     * The batches are evaluated concurrently by a single call to the derivative
+     * mapped with jac_num_threads threads, which must be larger than one.
+     * The last batch is padded with zero seeds.
+     */
+    void call_forward_batches(const std::vector<MX>& arg, const std::vector<MX>& res,
+                              const std::vector<std::vector<MX> >& fseed,
+                              std::vector<std::vector<MX> >& fsens) const;
+    void call_forward_batches(const std::vector<SX>& arg, const std::vector<SX>& res,
+                              const std::vector<std::vector<SX> >& fseed,
+                              std::vector<std::vector<SX> >& fsens) const;
+    ///@}
+
+    ///@{
+    /** \brief Reverse mode AD in batches of max_num_dir directions
+     *
+     * The batches are evaluated concurrently by a single call to the derivative
+     * mapped with jac_num_threads threads, which must be larger than one.
+     * The last batch is padded with zero seeds.
+     */
+    void call_reverse_batches(const std::vector<MX>& arg, const std::vector<MX>& res,
+                              const std::vector<std::vector<MX> >& aseed,
+                              std::vector<std::vector<MX> >& asens) const;
+    void call_reverse_batches(const std::vector<SX>& arg, const std::vector<SX>& res,
+                              const std::vector<std::vector<SX> >& aseed,
+                              std::vector<std::vector<SX> >& asens) const;
+    ///@}
+
     /** \brief Parallel evaluation */
     std::vector<MX> mapsum_mx(const std::vector<MX > &arg, const std::string& parallelization);
 
@@ -578,7 +606,10 @@ namespace casadi {
     void tocache(const Function& f, const std::string& suffix="") const;
 
     /** \brief Generate code the function */
-    void codegen(CodeGenerator& g, const std::string& fname) const;
+    virtual void codegen(CodeGenerator& g, const std::string& fname) const;
+
+    /** \brief Length of the work vector required by the generated code */
+    virtual size_t codegen_sz_w(const CodeGenerator& g) const { return sz_w();}
 
     /** \brief Generate meta-information allowing a user to evaluate a generated function */
     void codegen_meta(CodeGenerator& g) const;
@@ -628,6 +659,9 @@ namespace casadi {
     /** \brief Jit dependencies */
     virtual void jit_dependencies(const std::string& fname) {}
 
+    /** \brief Key identifying the jit library in the on-disk cache, empty if unavailable */
+    std::string jit_cache_key() const;
+
     /** \brief Export function in a specific language */
     virtual void export_code(const std::string& lang,
       std::ostream &stream, const Dict& options) const;
@@ -888,6 +922,9 @@ namespace casadi {
     /** \brief Use a temporary name */
     bool jit_temp_suffix_;
 
+    /** \brief Jit library was loaded from the on-disk cache */
+    bool jit_cached_;
+
     /** \brief Numerical evaluation redirected to a C function */
     eval_t eval_;
 
@@ -926,6 +963,12 @@ namespace casadi {
     Importer compiler_;
     Dict jit_options_;
 
+    /// Options for the code generator used for just-in-time compilation
+    Dict jit_codegen_options_;
+
+    /// Additional source files written for just-in-time compilation
+    std::vector<std::string> jit_sources_;
+
     /// Penalty factor for using a complete Jacobian to calculate directional derivatives
     double jac_penalty_;
 
@@ -939,6 +982,9 @@ namespace casadi {
     /// Maximum number of sensitivity directions
     casadi_int max_num_dir_;
 
+    /// Number of threads evaluating batches of sensitivity directions concurrently
+    casadi_int jac_num_threads_;
+
     /// Errors are thrown when NaN is produced
     bool regularity_check_;
 
@@ -745,6 +745,22 @@ namespace casadi {
       shared(ex_output, v, vdef, v_prefix, v_suffix);
     }
 
+    /** \brief Common subexpression elimination
+
+        Replaces structurally identical subexpressions, shared across all expressions,
+        by a single instance. If commutative is true, the operands of commutative
+        operations (e.g. addition and multiplication) are treated as unordered.
+    */
+    inline friend std::vector<MatType> cse(const std::vector<MatType>& ex,
+                                           bool commutative=true) {
+      return MatType::cse(ex, commutative);
+    }
+
+    /** \brief Common subexpression elimination */
+    inline friend MatType cse(const MatType& ex, bool commutative=true) {
+      return MatType::cse(std::vector<MatType>{ex}, commutative).at(0);
+    }
+
     /** \brief Given a repeated matrix, computes the sum of repeated parts
      */
     inline friend MatType repsum(const MatType &A, casadi_int n, casadi_int m=1) {
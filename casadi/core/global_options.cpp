@@ -36,6 +36,19 @@ namespace casadi {
 
   casadi_int GlobalOptions::max_num_dir = 64;
 
+  casadi_int GlobalOptions::sparsity_num_threads = 1;
+
+  casadi_int GlobalOptions::coloring_ordering = -1;
+
+  std::string GlobalOptions::jit_cache_dir;
+  casadi_int GlobalOptions::jit_cache_size = 1073741824;
+
+  bool GlobalOptions::sx_node_pool = false;
+
+  casadi_int GlobalOptions::simd_level = -1;
+
+  casadi_int GlobalOptions::blas_threshold = 32768;
+
   // By default, use zero-based indexing
   casadi_int GlobalOptions::start_index = 0;
 
@@ -68,6 +68,45 @@ namespace casadi {
 
       static casadi_int start_index;
 
+      /** \brief Number of threads for Jacobian sparsity pattern detection and coloring
+      * Default: 1
+      */
+      static casadi_int sparsity_num_threads;
+
+      /** \brief Vertex ordering for the graph colorings in Jacobian and Hessian compression
+      * None (0), largest first (1), smallest last (2), incidence degree (3)
+      * Default: -1, i.e. none for unidirectional and largest first for star colorings
+      */
+      static casadi_int coloring_ordering;
+
+      /** \brief Directory for caching compiled JIT libraries
+      * Empty: use the environment variable CASADI_JIT_CACHE_DIR, if set
+      */
+      static std::string jit_cache_dir;
+
+      /** \brief Size limit of the JIT cache directory in bytes, negative for no limit
+      * Default: 1 GiB
+      */
+      static casadi_int jit_cache_size;
+
+      /** \brief Allocate scalar expression nodes from a pool of large chunks
+      * Default: false
+      */
+      static bool sx_node_pool;
+
+      /** \brief Highest instruction set for the vectorized numerical kernels
+      * Scalar (0), AVX2 (1), AVX-512 (2), limited by the CPU
+      * Default: -1, i.e. the best supported one
+      */
+      static casadi_int simd_level;
+
+      /** \brief Smallest dense product handed to an external BLAS
+      * Dense matrix products with at least this many multiply-adds call dgemm/dgemv
+      * when CasADi was built with WITH_BLAS=ON. Negative values disable the dispatch.
+      * Default: 32768, i.e. 32-by-32 matrices
+      */
+      static casadi_int blas_threshold;
+
 #endif //SWIG
       // Setter and getter for simplification_on_the_fly
       static void setSimplificationOnTheFly(bool flag) { simplification_on_the_fly = flag; }
@@ -86,6 +125,33 @@ namespace casadi {
       static void setMaxNumDir(casadi_int ndir) { max_num_dir=ndir; }
       static casadi_int getMaxNumDir() { return max_num_dir; }
 
+      // Setter and getter for sparsity_num_threads
+      static void setSparsityNumThreads(casadi_int n) { sparsity_num_threads = n; }
+      static casadi_int getSparsityNumThreads() { return sparsity_num_threads; }
+
+      // Setter and getter for coloring_ordering
+      static void setColoringOrdering(casadi_int ordering) { coloring_ordering = ordering; }
+      static casadi_int getColoringOrdering() { return coloring_ordering; }
+
+      // Setter and getter for the JIT cache
+      static void setJitCacheDir(const std::string & dir) { jit_cache_dir = dir; }
+      static std::string getJitCacheDir() { return jit_cache_dir; }
+
+      static void setJitCacheSize(casadi_int size) { jit_cache_size = size; }
+      static casadi_int getJitCacheSize() { return jit_cache_size; }
+
+      // Setter and getter for sx_node_pool
+      static void setSXNodePool(bool flag) { sx_node_pool = flag; }
+      static bool getSXNodePool() { return sx_node_pool; }
+
+      // Setter and getter for simd_level
+      static void setSimdLevel(casadi_int level) { simd_level = level; }
+      static casadi_int getSimdLevel() { return simd_level; }
+
+      // Setter and getter for blas_threshold
+      static void setBlasThreshold(casadi_int n) { blas_threshold = n; }
+      static casadi_int getBlasThreshold() { return blas_threshold; }
+
   };
 
 } // namespace casadi
@@ -25,6 +25,9 @@
 
 #include "importer.hpp"
 #include "importer_internal.hpp"
+#include "jit_cache.hpp"
+#include "casadi_meta.hpp"
+#include <fstream>
 
 using namespace std;
 namespace casadi {
@@ -40,11 +43,49 @@ namespace casadi {
     } else if (compiler=="dll") {
       own(new DllLibrary(name));
     } else {
+      // Look for a library compiled earlier from identical source and options
+      std::string key;
+      auto it = opts.find("cache");
+      if (JitCache::enabled() && (it==opts.end() || it->second.to_bool())) {
+        std::ifstream src(name, ios_base::binary);
+        if (src.good()) {
+          Dict key_opts = opts;
+          key_opts.erase("cache");
+          std::stringstream ss;
+          ss << CasadiMeta::version() << '\n' << compiler << '\n' << str(key_opts) << '\n'
+             << src.rdbuf();
+          // Additional sources compiled with the main one
+          auto it_src = opts.find("sources");
+          if (it_src!=opts.end()) {
+            for (auto&& f : it_src->second.to_string_vector()) {
+              std::ifstream extra(f, ios_base::binary);
+              ss << '\n' << extra.rdbuf();
+            }
+          }
+          key = JitCache::hash(ss.str());
+          std::string library = JitCache::lookup(key);
+          if (!library.empty()) {
+            own(new DllLibrary(library));
+            (*this)->construct(Dict());
+            // Meta information is still read from the source
+            (*this)->read_source(name);
+            return;
+          }
+        }
+      }
       own(ImporterInternal::getPlugin(compiler).creator(name));
+      (*this)->construct(opts);
+      // Plugins that produce a shared library can populate the cache
+      if (!key.empty() && library()!=name) JitCache::store(key, library());
+      return;
     }
     (*this)->construct(opts);
   }
 
+  Dict Importer::cache_stats() {
+    return JitCache::stats();
+  }
+
   ImporterInternal* Importer::operator->() {
     return static_cast<ImporterInternal*>(SharedObject::operator->());
   }
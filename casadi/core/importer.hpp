@@ -141,6 +141,14 @@ namespace casadi {
     /// Get library name
     std::string library() const;
 
+    /** \brief Statistics of the on-disk cache of compiled libraries
+
+        Returns hits, misses, stores, evictions, entries, size (bytes) and dir.
+        The cache is enabled by setting GlobalOptions::jit_cache_dir or the
+        environment variable CASADI_JIT_CACHE_DIR.
+    */
+    static Dict cache_stats();
+
 #ifndef SWIG
     /** Convert indexed command */
     static inline std::string indexed(const std::string& cmd, casadi_int ind) {
@@ -46,7 +46,11 @@ namespace casadi {
   = {{},
      {{"verbose",
        {OT_BOOL,
-        "Verbose evaluation -- for debugging"}}
+        "Verbose evaluation -- for debugging"}},
+      {"cache",
+       {OT_BOOL,
+        "Reuse compiled libraries from the on-disk JIT cache, "
+        "cf. GlobalOptions::jit_cache_dir. Default: true"}}
       }
     };
 
@@ -69,58 +73,60 @@ namespace casadi {
 
   void ImporterInternal::init(const Dict& opts) {
     // Read meta information from file
-    if (can_have_meta()) {
-      casadi_int offset = 0;
-      ifstream file(name_);
-      std::string line;
-      while (getline(file, line)) {
-        // Update offset
-        offset++;
+    if (can_have_meta()) read_source(name_);
 
-        // Try to find a /*CASADIMETA delimiter
-        string cmd = "/*CASADIMETA";
-        size_t pos = line.find(cmd);
-        if (pos != string::npos) {
-          read_meta(file, offset);
-          continue;
-        }
+    // Read options
+    for (auto&& op : opts) {
+      if (op.first=="verbose") {
+        verbose_ = op.second;
+      }
+    }
+  }
 
-        // Try to find a /*CASADIEXTERNAL delimiter
-        cmd = "/*CASADIEXTERNAL";
-        pos = line.find(cmd);
-        if (pos != string::npos) {
-          istringstream ss(line.substr(pos+cmd.size()));
-          // Read name
-          string sym;
-          ss >> sym;
-          casadi_assert_dev(ss.good());
-          // Default attributes
-          bool inlined = false;
-
-          // Read attributes: FIXME(@jaeandersson): Hacky
-          size_t eqpos = line.find('=', pos+cmd.size());
-          if (eqpos != string::npos) {
-            string attr = "inline";
-            if (line.compare(eqpos-attr.size(), attr.size(), attr)==0) {
-              casadi_assert_dev(line.size()>eqpos+1);
-              if (line.at(eqpos+1)=='1') {
-                inlined=true;
-              } else {
-                casadi_assert_dev(line.at(eqpos+1)=='0');
-              }
+  void ImporterInternal::read_source(const std::string& fname) {
+    casadi_int offset = 0;
+    ifstream file(fname);
+    std::string line;
+    while (getline(file, line)) {
+      // Update offset
+      offset++;
+
+      // Try to find a /*CASADIMETA delimiter
+      string cmd = "/*CASADIMETA";
+      size_t pos = line.find(cmd);
+      if (pos != string::npos) {
+        read_meta(file, offset);
+        continue;
+      }
+
+      // Try to find a /*CASADIEXTERNAL delimiter
+      cmd = "/*CASADIEXTERNAL";
+      pos = line.find(cmd);
+      if (pos != string::npos) {
+        istringstream ss(line.substr(pos+cmd.size()));
+        // Read name
+        string sym;
+        ss >> sym;
+        casadi_assert_dev(ss.good());
+        // Default attributes
+        bool inlined = false;
+
+        // Read attributes: FIXME(@jaeandersson): Hacky
+        size_t eqpos = line.find('=', pos+cmd.size());
+        if (eqpos != string::npos) {
+          string attr = "inline";
+          if (line.compare(eqpos-attr.size(), attr.size(), attr)==0) {
+            casadi_assert_dev(line.size()>eqpos+1);
+            if (line.at(eqpos+1)=='1') {
+              inlined=true;
+            } else {
+              casadi_assert_dev(line.at(eqpos+1)=='0');
             }
           }
-
-          read_external(sym, inlined, file, offset);
-          continue;
         }
-      }
-    }
 
-    // Read options
-    for (auto&& op : opts) {
-      if (op.first=="verbose") {
-        verbose_ = op.second;
+        read_external(sym, inlined, file, offset);
+        continue;
       }
     }
   }
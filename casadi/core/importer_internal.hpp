@@ -103,6 +103,9 @@ namespace casadi {
     /** \brief Get entry as a text */
     std::string get_meta(const std::string& cmd, casadi_int ind=-1) const;
 
+    /// Read meta information and external declarations from a source file
+    void read_source(const std::string& fname);
+
     /// Get meta information
     void read_meta(std::istream& file, casadi_int& offset);
 
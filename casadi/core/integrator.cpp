@@ -227,7 +227,12 @@ namespace casadi {
         "Options to be passed down to the augmented integrator, if one is constructed."}},
       {"output_t0",
        {OT_BOOL,
-        "Output the state at the initial time"}}
+        "Output the state at the initial time"}},
+      {"batch",
+       {OT_INT,
+        "Number of trajectories integrated together in one solver instance, "
+        "with shared step size control. All inputs and outputs except time "
+        "hold the trajectories stacked one after another [1]"}}
      }
   };
 
@@ -235,6 +240,7 @@ namespace casadi {
     // Default (temporary) options
     double t0=0, tf=1;
     bool expand = false;
+    casadi_int batch = 1;
 
     // Read options
     for (auto&& op : opts) {
@@ -252,14 +258,27 @@ namespace casadi {
         t0 = op.second;
       } else if (op.first=="tf") {
         tf = op.second;
+      } else if (op.first=="batch") {
+        batch = op.second;
       }
     }
 
     // Replace MX oracle with SX oracle?
     if (expand) this->expand();
 
+    // Replace oracle with the stacked DAE of all trajectories
+    casadi_assert(batch>=1, "Option 'batch' must be positive");
+    if (batch>1) {
+      if (oracle_.is_a("SXFunction")) {
+        oracle_ = map2batch<SX>(oracle_.name(), batch);
+      } else {
+        oracle_ = map2batch<MX>(oracle_.name(), batch);
+      }
+    }
+
     // Store a copy of the options, for creating augmented integrators
     opts_ = opts;
+    opts_.erase("batch");
 
     // If grid unset, default to [t0, tf]
     if (grid_.empty()) {
@@ -697,6 +716,37 @@ namespace casadi {
     return 0;
   }
 
+  template<typename MatType>
+  Function Integrator::map2batch(const std::string& name, casadi_int n) const {
+    if (verbose_) casadi_message(name_ + "::map2batch");
+
+    // All trajectories are evaluated in a single call
+    Function f = oracle_.map(n);
+
+    // Stacked inputs, time is shared
+    vector<MatType> arg(DE_NUM_IN), f_arg(DE_NUM_IN);
+    for (casadi_int i=0; i<DE_NUM_IN; ++i) {
+      const Sparsity& sp = oracle_.sparsity_in(i);
+      if (i==DE_T) {
+        arg[i] = MatType::sym(DE_INPUTS[i], sp);
+        f_arg[i] = repmat(arg[i], 1, n);
+      } else {
+        casadi_assert(sp.is_dense() && sp.is_column(),
+          "Option 'batch' requires dense column vector '" + DE_INPUTS[i] + "', "
+          "got " + sp.dim() + ".");
+        arg[i] = MatType::sym(DE_INPUTS[i], sp.size1()*n);
+        f_arg[i] = reshape(arg[i], sp.size1(), n);
+      }
+    }
+
+    // Stacked outputs
+    vector<MatType> res = f(f_arg);
+    std::map<string, MatType> d;
+    for (casadi_int i=0; i<DE_NUM_IN; ++i) d[DE_INPUTS[i]] = arg[i];
+    for (casadi_int i=0; i<DE_NUM_OUT; ++i) d[DE_OUTPUTS[i]] = vec(res[i]);
+    return map2oracle(name, d);
+  }
+
   Function Integrator::
   get_forward(casadi_int nfwd, const std::string& name,
               const std::vector<std::string>& inames,
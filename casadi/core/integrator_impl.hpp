@@ -154,6 +154,9 @@ namespace casadi {
     /** \brief Generate a augmented DAE system with \a nadj adjoint sensitivities */
     template<typename MatType> std::map<std::string, MatType> aug_adj(casadi_int nadj) const;
 
+    /** \brief Generate a DAE system stacking \a n independent copies of the oracle */
+    template<typename MatType> Function map2batch(const std::string& name, casadi_int n) const;
+
     /// Create sparsity pattern of the extended Jacobian (forward problem)
     Sparsity sp_jac_dae();
 
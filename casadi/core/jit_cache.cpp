@@ -0,0 +1,310 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "jit_cache.hpp"
+#include "global_options.hpp"
+#include "casadi_misc.hpp"
+#include "exception.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#include <sys/utime.h>
+#else // _WIN32
+#include <dirent.h>
+#include <utime.h>
+#endif // _WIN32
+
+#ifdef CASADI_WITH_THREAD
+#ifdef CASADI_WITH_THREAD_MINGW
+#include <mingw.mutex.h>
+#else // CASADI_WITH_THREAD_MINGW
+#include <mutex>
+#endif // CASADI_WITH_THREAD_MINGW
+#endif // CASADI_WITH_THREAD
+
+#ifndef SHARED_LIBRARY_SUFFIX
+#define SHARED_LIBRARY_SUFFIX ".so"
+#endif // SHARED_LIBRARY_SUFFIX
+
+using namespace std;
+
+namespace casadi {
+
+  namespace {
+    // File name prefix of cache entries
+    const std::string entry_prefix = "casadi_jit_";
+
+    // Statistics
+    casadi_int n_hits = 0, n_misses = 0, n_stores = 0, n_evictions = 0;
+
+#ifdef CASADI_WITH_THREAD
+    // Protects the statistics and modifications of the cache directory
+    std::mutex mtx;
+#define CASADI_JIT_CACHE_LOCK std::lock_guard<std::mutex> lock(mtx);
+#else // CASADI_WITH_THREAD
+#define CASADI_JIT_CACHE_LOCK
+#endif // CASADI_WITH_THREAD
+
+    // An entry in the cache directory
+    struct Entry {
+      std::string path;
+      casadi_int size;
+      time_t mtime;
+    };
+
+    // Does a string end with a suffix
+    bool ends_with(const std::string& s, const std::string& suffix) {
+      return s.size()>=suffix.size() && s.compare(s.size()-suffix.size(), suffix.size(), suffix)==0;
+    }
+
+    // Size and modification time of a file
+    bool file_stat(const std::string& path, casadi_int& size, time_t& mtime) {
+      struct stat st;
+      if (stat(path.c_str(), &st)) return false;
+      size = st.st_size;
+      mtime = st.st_mtime;
+      return true;
+    }
+
+    // List all entries in the cache directory
+    std::vector<Entry> list_entries(const std::string& dir) {
+      std::vector<std::string> names;
+#ifdef _WIN32
+      WIN32_FIND_DATAA fd;
+      HANDLE h = FindFirstFileA((dir + "\\" + entry_prefix + "*").c_str(), &fd);
+      if (h!=INVALID_HANDLE_VALUE) {
+        do {
+          names.push_back(fd.cFileName);
+        } while (FindNextFileA(h, &fd));
+        FindClose(h);
+      }
+#else // _WIN32
+      DIR* d = opendir(dir.c_str());
+      if (d) {
+        while (struct dirent* e = readdir(d)) names.push_back(e->d_name);
+        closedir(d);
+      }
+#endif // _WIN32
+      std::vector<Entry> ret;
+      for (auto&& n : names) {
+        if (n.compare(0, entry_prefix.size(), entry_prefix)!=0) continue;
+        if (!ends_with(n, SHARED_LIBRARY_SUFFIX)) continue;
+        Entry e;
+        e.path = dir + "/" + n;
+        if (file_stat(e.path, e.size, e.mtime)) ret.push_back(e);
+      }
+      return ret;
+    }
+
+    // SHA-256 round constants
+    const uint32_t sha256_k[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+      0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+      0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+      0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+      0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+      0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+      0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+      0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+      0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+      0xc67178f2};
+
+    inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n));}
+
+    // Process one 64-byte block
+    void sha256_block(uint32_t* h, const unsigned char* p) {
+      uint32_t w[64];
+      for (int i=0; i<16; ++i) {
+        w[i] = uint32_t(p[4*i])<<24 | uint32_t(p[4*i+1])<<16 | uint32_t(p[4*i+2])<<8 | p[4*i+3];
+      }
+      for (int i=16; i<64; ++i) {
+        uint32_t s0 = rotr(w[i-15], 7) ^ rotr(w[i-15], 18) ^ (w[i-15] >> 3);
+        uint32_t s1 = rotr(w[i-2], 17) ^ rotr(w[i-2], 19) ^ (w[i-2] >> 10);
+        w[i] = w[i-16] + s0 + w[i-7] + s1;
+      }
+      uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+      for (int i=0; i<64; ++i) {
+        uint32_t t1 = k + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g))
+          + sha256_k[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        k = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+      }
+      h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+      h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+    }
+
+    // SHA-256 digest (FIPS 180-4)
+    std::vector<uint32_t> sha256(const std::string& data) {
+      std::vector<uint32_t> h = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+      const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data());
+      size_t n = data.size(), i = 0;
+      for (; i+64<=n; i+=64) sha256_block(get_ptr(h), p + i);
+      // Padding: a one bit, zeros and the message length in bits
+      unsigned char last[128] = {0};
+      size_t r = n - i;
+      std::copy(p + i, p + n, last);
+      last[r] = 0x80;
+      size_t nlast = r+9<=64 ? 64 : 128;
+      uint64_t bits = uint64_t(n)*8;
+      for (int j=0; j<8; ++j) last[nlast-1-j] = static_cast<unsigned char>(bits >> (8*j));
+      for (size_t j=0; j<nlast; j+=64) sha256_block(get_ptr(h), last + j);
+      return h;
+    }
+  } // namespace
+
+  std::string JitCache::dir() {
+    std::string ret = GlobalOptions::jit_cache_dir;
+    if (ret.empty()) {
+      const char* env = getenv("CASADI_JIT_CACHE_DIR");
+      if (env) ret = env;
+    }
+    return ret;
+  }
+
+  bool JitCache::enabled() {
+    return !dir().empty();
+  }
+
+  std::string JitCache::hash(const std::string& data) {
+    // The key is used as a content address: collisions must be infeasible
+    std::stringstream ss;
+    ss << std::hex;
+    for (uint32_t e : sha256(data)) {
+      ss.width(8);
+      ss.fill('0');
+      ss << e;
+    }
+    return ss.str();
+  }
+
+  std::string JitCache::path(const std::string& key) {
+    return dir() + "/" + entry_prefix + key + SHARED_LIBRARY_SUFFIX;
+  }
+
+  std::string JitCache::lookup(const std::string& key) {
+    std::string ret = path(key);
+    CASADI_JIT_CACHE_LOCK
+    if (!std::ifstream(ret).good()) {
+      n_misses++;
+      return std::string();
+    }
+    n_hits++;
+    // Mark as recently used
+    utime(ret.c_str(), nullptr);
+    return ret;
+  }
+
+  std::string JitCache::store(const std::string& key, const std::string& library) {
+    std::string d = dir(), ret = path(key);
+    {
+      CASADI_JIT_CACHE_LOCK
+      // Make sure that the directory exists
+#ifdef _WIN32
+      _mkdir(d.c_str());
+#else // _WIN32
+      mkdir(d.c_str(), 0755);
+#endif // _WIN32
+      // Copy to a temporary file, then rename, so other processes never see partial entries
+      std::string tmp;
+      try {
+        tmp = temporary_file(d + "/tmp_" + entry_prefix, ".part");
+      } catch (std::exception& e) {
+        casadi_warning("Cannot write to JIT cache directory '" + d + "': " + str(e.what()));
+        return std::string();
+      }
+      {
+        std::ifstream src(library, ios_base::binary);
+        std::ofstream dst(tmp, ios_base::binary);
+        if (src.good() && dst.good()) dst << src.rdbuf();
+        if (!src.good() || !dst.good()) {
+          dst.close();
+          remove(tmp.c_str());
+          casadi_warning("Failed to copy '" + library + "' into the JIT cache.");
+          return std::string();
+        }
+      }
+      if (rename(tmp.c_str(), ret.c_str())) {
+        // Another process may have stored the same entry in the meantime
+        remove(tmp.c_str());
+        if (!std::ifstream(ret).good()) return std::string();
+      }
+      n_stores++;
+    }
+    evict(ret);
+    return ret;
+  }
+
+  void JitCache::evict(const std::string& keep) {
+    casadi_int limit = GlobalOptions::jit_cache_size;
+    if (limit<0) return;
+    CASADI_JIT_CACHE_LOCK
+    std::vector<Entry> entries = list_entries(dir());
+    casadi_int total = 0;
+    for (auto&& e : entries) total += e.size;
+    if (total<=limit) return;
+    // Least recently used first
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.mtime<b.mtime;});
+    for (casadi_int k=0; k<entries.size() && total>limit; ++k) {
+      if (entries[k].path==keep || remove(entries[k].path.c_str())) continue;
+      total -= entries[k].size;
+      n_evictions++;
+    }
+  }
+
+  Dict JitCache::stats() {
+    CASADI_JIT_CACHE_LOCK
+    Dict ret;
+    ret["hits"] = n_hits;
+    ret["misses"] = n_misses;
+    ret["stores"] = n_stores;
+    ret["evictions"] = n_evictions;
+    std::vector<Entry> entries;
+    if (enabled()) entries = list_entries(dir());
+    casadi_int total = 0;
+    for (auto&& e : entries) total += e.size;
+    ret["entries"] = static_cast<casadi_int>(entries.size());
+    ret["size"] = total;
+    ret["dir"] = dir();
+    return ret;
+  }
+
+  void JitCache::reset_stats() {
+    CASADI_JIT_CACHE_LOCK
+    n_hits = n_misses = n_stores = n_evictions = 0;
+  }
+
+} // namespace casadi
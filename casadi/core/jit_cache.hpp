@@ -0,0 +1,92 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#ifndef CASADI_JIT_CACHE_HPP
+#define CASADI_JIT_CACHE_HPP
+
+#include "generic_type.hpp"
+
+/// \cond INTERNAL
+
+namespace casadi {
+
+  /** \brief Content-addressed on-disk cache of compiled libraries
+
+      Shared libraries produced by the just-in-time compilers are copied into
+      the directory GlobalOptions::jit_cache_dir (or the environment variable
+      CASADI_JIT_CACHE_DIR), named after a hash of everything that determines
+      their contents. Subsequent lookups with the same key, in the same or
+      another process, load the cached library instead of compiling again.
+
+      The total size of the cache is kept below GlobalOptions::jit_cache_size
+      bytes by removing the least recently used entries.
+  */
+  class CASADI_EXPORT JitCache {
+  public:
+    /** \brief Is the cache enabled, i.e. is a cache directory set? */
+    static bool enabled();
+
+    /** \brief Cache directory, empty if disabled */
+    static std::string dir();
+
+    /** \brief SHA-256 digest of a string, as hexadecimal characters */
+    static std::string hash(const std::string& data);
+
+    /** \brief Path to the cached library for a key, empty if not cached
+
+        Updates hit/miss statistics and marks the entry as recently used.
+     */
+    static std::string lookup(const std::string& key);
+
+    /** \brief Copy a library into the cache, returns the path to the copy
+
+        Evicts the least recently used entries if the size limit is exceeded.
+        Failures are not fatal, an empty string is returned.
+     */
+    static std::string store(const std::string& key, const std::string& library);
+
+    /** \brief Remove least recently used entries until the size limit holds
+
+        The entry at path keep, typically the one just stored, is never removed.
+     */
+    static void evict(const std::string& keep=std::string());
+
+    /** \brief Statistics: hits, misses, stores, evictions, entries, size */
+    static Dict stats();
+
+    /** \brief Reset the hit/miss statistics */
+    static void reset_stats();
+
+  private:
+    // Path to the cached library for a key
+    static std::string path(const std::string& key);
+  };
+
+} // namespace casadi
+
+/// \endcond
+
+#endif // CASADI_JIT_CACHE_HPP
@@ -25,35 +25,30 @@
 
 #include "map.hpp"
 #include "serializing_stream.hpp"
-
-#ifdef CASADI_WITH_THREAD
-#ifdef CASADI_WITH_THREAD_MINGW
-#include <mingw.thread.h>
-#else // CASADI_WITH_THREAD_MINGW
-#include <thread>
-#endif // CASADI_WITH_THREAD_MINGW
-#endif // CASADI_WITH_THREAD
+#include "sx_function.hpp"
+#include "thread_pool.hpp"
 
 using namespace std;
 
 namespace casadi {
 
-  Function Map::create(const std::string& parallelization, const Function& f, casadi_int n) {
+  Function Map::create(const std::string& parallelization, const Function& f, casadi_int n,
+      const Dict& opts) {
     // Create instance of the right class
     string suffix = str(n) + "_" + f.name();
     if (parallelization == "serial") {
-      return Function::create(new Map("map" + suffix, f, n), Dict());
+      return Function::create(new Map("map" + suffix, f, n), opts);
     } else if (parallelization== "openmp") {
-      return Function::create(new OmpMap("ompmap" + suffix, f, n), Dict());
+      return Function::create(new OmpMap("ompmap" + suffix, f, n), opts);
     } else if (parallelization== "thread") {
-      return Function::create(new ThreadMap("threadmap" + suffix, f, n), Dict());
+      return Function::create(new ThreadMap("threadmap" + suffix, f, n), opts);
     } else {
       casadi_error("Unknown parallelization: " + parallelization);
     }
   }
 
   Map::Map(const std::string& name, const Function& f, casadi_int n)
-    : FunctionInternal(name), f_(f), n_(n) {
+    : FunctionInternal(name), f_(f), n_(n), batch_(false) {
   }
 
   bool Map::is_a(const std::string& type, bool recursive) const {
@@ -100,20 +95,26 @@ namespace casadi {
   Map::Map(DeserializingStream& s) : FunctionInternal(s) {
     s.unpack("Map::f", f_);
     s.unpack("Map::n", n_);
+    batch_ = false;
   }
 
   ProtoFunction* Map::deserialize(DeserializingStream& s) {
     std::string class_name;
     s.unpack("Map::class_name", class_name);
+    Map* ret;
     if (class_name=="Map") {
-      return new Map(s);
+      ret = new Map(s);
     } else if (class_name=="OmpMap") {
-      return new OmpMap(s);
+      ret = new OmpMap(s);
     } else if (class_name=="ThreadMap") {
-      return new ThreadMap(s);
+      ret = new ThreadMap(s);
     } else {
       casadi_error("class name '" + class_name + "' unknown.");
     }
+    // Batched evaluation as in init, also for streams written without it
+    ret->batch_ = ret->parallelization()=="serial" && ret->f_.is_a("SXFunction");
+    if (ret->batch_) ret->alloc_w(ret->f_.sz_w()*SXFunction::batch_size);
+    return ret;
   }
 
   Map::~Map() {
@@ -131,6 +132,10 @@ namespace casadi {
     alloc_res(f_.sz_res());
     alloc_w(f_.sz_w());
     alloc_iw(f_.sz_iw());
+
+    // Serial maps of SXFunctions evaluate several instances simultaneously
+    batch_ = parallelization()=="serial" && f_.is_a("SXFunction");
+    if (batch_) alloc_w(f_.sz_w()*SXFunction::batch_size);
   }
 
   template<typename T>
@@ -310,7 +315,30 @@ namespace casadi {
     return Function(name, arg, res, inames, onames, opts);
   }
 
+  int Map::eval_batch(const double** arg, double** res, double* w) const {
+    auto sxf = static_cast<const SXFunction*>(f_.get());
+    const double** arg1 = arg+n_in_;
+    copy_n(arg, n_in_, arg1);
+    double** res1 = res+n_out_;
+    copy_n(res, n_out_, res1);
+    for (casadi_int i=0; i<n_; i+=SXFunction::batch_size) {
+      casadi_int nb = std::min(SXFunction::batch_size, n_-i);
+      if (sxf->eval_batch(arg1, res1, w, nb)) return 1;
+      for (casadi_int j=0; j<n_in_; ++j) {
+        if (arg1[j]) arg1[j] += nb*f_.nnz_in(j);
+      }
+      for (casadi_int j=0; j<n_out_; ++j) {
+        if (res1[j]) res1[j] += nb*f_.nnz_out(j);
+      }
+    }
+    return 0;
+  }
+
   int Map::eval(const double** arg, double** res, casadi_int* iw, double* w, void* mem) const {
+    // Lane-batched evaluation of SXFunction instances
+    if (batch_ && static_cast<const SXFunction*>(f_.get())->has_eval_batch()) {
+      return eval_batch(arg, res, w);
+    }
     // This checkout/release dance is an optimization.
     // Could also use the thread-safe variant f_(arg1, res1, iw, w)
     // in Map::eval_gen
@@ -417,40 +445,31 @@ namespace casadi {
     clear_mem();
   }
 
-  void ThreadsWork(const Function& f, casadi_int i,
-      const double** arg, double** res,
-      casadi_int* iw, double* w,
-      casadi_int ind, int& ret) {
-
-    // Function dimensions
-    casadi_int n_in = f.n_in();
-    casadi_int n_out = f.n_out();
+  const Options ThreadMap::options_
+  = {{&FunctionInternal::options_},
+     {{"max_num_threads",
+       {OT_INT,
+        "Maximum number of concurrent worker threads "
+        "[default: hardware concurrency]"}}
+     }
+  };
 
-    // Function work sizes
-    size_t sz_arg, sz_res, sz_iw, sz_w;
-    f.sz_work(sz_arg, sz_res, sz_iw, sz_w);
-
-    // Input buffers
-    const double** arg1 = arg + n_in + i*sz_arg;
-    for (casadi_int j=0; j<n_in; ++j) {
-      arg1[j] = arg[j] ? arg[j] + i*f.nnz_in(j) : nullptr;
-    }
+  ThreadMap::ThreadMap(DeserializingStream& s) : Map(s) {
+    s.version("ThreadMap", 2);
+    s.unpack("ThreadMap::max_num_threads", max_num_threads_);
+    n_threads_ = std::min(max_num_threads_, n_);
+  }
 
-    // Output buffers
-    double** res1 = res + n_out + i*sz_res;
-    for (casadi_int j=0; j<n_out; ++j) {
-      res1[j] = res[j] ? res[j] + i*f.nnz_out(j) : nullptr;
-    }
+  void ThreadMap::serialize_body(SerializingStream &s) const {
+    Map::serialize_body(s);
+    s.version("ThreadMap", 2);
+    s.pack("ThreadMap::max_num_threads", max_num_threads_);
+  }
 
-    try {
-      ret = f(arg1, res1, iw + i*sz_iw, w + i*sz_w, ind);
-    } catch (std::exception& e) {
-      ret = 1;
-      casadi_warning("Exception raised: " + std::string(e.what()));
-    } catch (...) {
-      ret = 1;
-      casadi_warning("Uncaught exception.");
-    }
+  Dict ThreadMap::info() const {
+    Dict ret = Map::info();
+    ret["max_num_threads"] = max_num_threads_;
+    return ret;
   }
 
   int ThreadMap::eval(const double** arg, double** res, casadi_int* iw, double* w,
@@ -459,29 +478,42 @@ namespace casadi {
 #ifndef CASADI_WITH_THREAD
     return Map::eval(arg, res, iw, w, mem);
 #else // CASADI_WITH_THREAD
-    // Checkout memory objects
-    std::vector< scoped_checkout<Function> > ind; ind.reserve(n_);
-    for (casadi_int i=0; i<n_; ++i) ind.emplace_back(f_);
+    // Function work sizes
+    size_t sz_arg, sz_res, sz_iw, sz_w;
+    f_.sz_work(sz_arg, sz_res, sz_iw, sz_w);
 
-    // Allocate space for return values
-    std::vector<int> ret_values(n_);
+    // Checkout one memory object per worker
+    std::vector< scoped_checkout<Function> > ind; ind.reserve(n_threads_);
+    for (casadi_int k=0; k<n_threads_; ++k) ind.emplace_back(f_);
 
-    // Spawn threads
-    std::vector<std::thread> threads;
-    for (casadi_int i=0; i<n_; ++i) {
-      // Why the lambda function?
-      // Because it was the first iteration to pass tests on MingGW
-      // using mingw-std-threads.
-      threads.emplace_back(
-        [i](const Function& f, const double** arg, double** res,
-            casadi_int* iw, double* w, casadi_int ind, int& ret) {
-              ThreadsWork(f, i, arg, res, iw, w, ind, ret);
-            },
-        std::ref(f_), arg, res, iw, w, casadi_int(ind[i]), std::ref(ret_values[i]));
-    }
+    // Return values
+    std::vector<int> ret_values(n_, 0);
+
+    // Evaluate instance i using the work memory of worker k
+    auto task = [&](casadi_int k, casadi_int i) {
+      // Input buffers
+      const double** arg1 = arg + n_in_ + k*sz_arg;
+      for (casadi_int j=0; j<n_in_; ++j) {
+        arg1[j] = arg[j] ? arg[j] + i*f_.nnz_in(j) : nullptr;
+      }
+      // Output buffers
+      double** res1 = res + n_out_ + k*sz_res;
+      for (casadi_int j=0; j<n_out_; ++j) {
+        res1[j] = res[j] ? res[j] + i*f_.nnz_out(j) : nullptr;
+      }
+      try {
+        ret_values[i] = f_(arg1, res1, iw + k*sz_iw, w + k*sz_w, ind[k]);
+      } catch (std::exception& e) {
+        ret_values[i] = 1;
+        casadi_warning("Exception raised: " + std::string(e.what()));
+      } catch (...) {
+        ret_values[i] = 1;
+        casadi_warning("Uncaught exception.");
+      }
+    };
 
-    // Join threads
-    for (auto && th : threads) th.join();
+    // Distribute over the thread pool
+    ThreadPool::instance().run(n_, n_threads_, task);
 
     // Anticipate success
     int ret = 0;
@@ -505,14 +537,25 @@ namespace casadi {
     // Call the initialization method of the base class
     Map::init(opts);
 
-    // Allocate memory for holding memory object references
-    alloc_iw(n_, true);
+    // Default options
+    max_num_threads_ = ThreadPool::default_num_threads();
+
+    // Read options
+    for (auto&& op : opts) {
+      if (op.first=="max_num_threads") {
+        max_num_threads_ = op.second;
+      }
+    }
+    casadi_assert(max_num_threads_>=1, "Option 'max_num_threads' must be positive.");
+
+    // Number of workers
+    n_threads_ = std::min(max_num_threads_, n_);
 
     // Allocate sufficient memory for parallel evaluation
-    alloc_arg(f_.sz_arg() * n_);
-    alloc_res(f_.sz_res() * n_);
-    alloc_w(f_.sz_w() * n_);
-    alloc_iw(f_.sz_iw() * n_);
+    alloc_arg(f_.sz_arg() * n_threads_);
+    alloc_res(f_.sz_res() * n_threads_);
+    alloc_w(f_.sz_w() * n_threads_);
+    alloc_iw(f_.sz_iw() * n_threads_);
   }
 
 } // namespace casadi
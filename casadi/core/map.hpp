@@ -40,7 +40,7 @@ namespace casadi {
   public:
     // Create function (use instead of constructor)
     static Function create(const std::string& parallelization,
-                           const Function& f, casadi_int n);
+                           const Function& f, casadi_int n, const Dict& opts=Dict());
 
     /** \brief Destructor */
     ~Map() override;
@@ -168,6 +168,12 @@ namespace casadi {
 
     // Number of times to evaluate this function
     casadi_int n_;
+
+    // Evaluate an SXFunction at several points simultaneously
+    bool batch_;
+
+    // Evaluate using SXFunction::eval_batch
+    int eval_batch(const double** arg, double** res, double* w) const;
   };
 
   /** A map Evaluate in parallel using OpenMP
@@ -210,8 +216,8 @@ namespace casadi {
   };
 
   /** A map Evaluate in parallel using std::thread
-      Note: Do not use this class with much more than the intended number of
-      threads for the parallel evaluation as it will cause excessive memory use.
+      Evaluations are distributed in chunks over a process-wide pool of persistent
+      worker threads. Work memory is allocated per worker, not per evaluation.
 
       \author Joris Gillis
       \date 2018
@@ -234,6 +240,12 @@ namespace casadi {
     /// Evaluate the function numerically
     int eval(const double** arg, double** res, casadi_int* iw, double* w, void* mem) const override;
 
+    ///@{
+    /** \brief Options */
+    static const Options options_;
+    const Options& get_options() const override { return options_;}
+    ///@}
+
     /** \brief  Initialize */
     void init(const Dict& opts) override;
 
@@ -243,9 +255,21 @@ namespace casadi {
     /** \brief Generate code for the body of the C function */
     void codegen_body(CodeGenerator& g) const override;
 
+    /** Obtain information about node */
+    Dict info() const override;
+
+    /** \brief Serialize an object without type information */
+    void serialize_body(SerializingStream &s) const override;
+
   protected:
     /** \brief Deserializing constructor */
-    explicit ThreadMap(DeserializingStream& s) : Map(s) {}
+    explicit ThreadMap(DeserializingStream& s);
+
+    // Maximum number of concurrent workers
+    casadi_int max_num_threads_;
+
+    // Number of workers actually used (work memory is allocated for each)
+    casadi_int n_threads_;
   };
 
 } // namespace casadi
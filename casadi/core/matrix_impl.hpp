@@ -2580,6 +2580,13 @@ namespace casadi {
     casadi_error("'shared' not defined for " + type_name());
   }
 
+  template<typename Scalar>
+  std::vector<Matrix<Scalar> > Matrix<Scalar>::cse(const std::vector<Matrix<Scalar> >& ex,
+                                                   bool commutative) {
+    casadi_error("'cse' not defined for " + type_name());
+    return std::vector<Matrix<Scalar> >();
+  }
+
   template<typename Scalar>
   Matrix<Scalar> Matrix<Scalar>::poly_coeff(const Matrix<Scalar>& f,
                                                 const Matrix<Scalar>&x) {
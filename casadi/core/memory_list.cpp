@@ -0,0 +1,62 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "memory_list.hpp"
+#include "exception.hpp"
+
+namespace casadi {
+
+  MemoryList::MemoryList() : n_(0), head_(0) {
+    for (casadi_int s=0; s<max_seg; ++s) seg_[s] = nullptr;
+  }
+
+  MemoryList::~MemoryList() {
+    for (casadi_int s=0; s<max_seg; ++s) delete[] seg_[s].load();
+  }
+
+  casadi_int MemoryList::add(void* ptr) {
+    casadi_int ind = n_.load(std::memory_order_relaxed);
+    casadi_int s, k;
+    locate(ind, s, k);
+    casadi_assert(s<max_seg, "Too many memory objects");
+    // Allocate a new segment, if needed
+    Entry* seg = seg_[s].load(std::memory_order_relaxed);
+    if (seg==nullptr) {
+      seg = new Entry[first_seg << s];
+      seg_[s].store(seg, std::memory_order_release);
+    }
+    seg[k].ptr = ptr;
+    seg[k].next.store(0, std::memory_order_relaxed);
+    n_.store(ind+1, std::memory_order_release);
+    return ind;
+  }
+
+  void MemoryList::clear() {
+    n_ = 0;
+    head_ = 0;
+  }
+
+} // namespace casadi
@@ -0,0 +1,142 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#ifndef CASADI_MEMORY_LIST_HPP
+#define CASADI_MEMORY_LIST_HPP
+
+#include "casadi_common.hpp"
+#include <atomic>
+#include <cstdint>
+
+/// \cond INTERNAL
+
+namespace casadi {
+
+  /** \brief Indexed collection of memory objects with a lock-free free list
+
+      Entries are stored in segments of doubling size, so that existing entries
+      never move and can be accessed without locking. Unused entries are kept
+      in a stack (Treiber stack) whose head carries a version tag to avoid the
+      ABA problem. Only adding new entries requires external synchronization.
+  */
+  class CASADI_EXPORT MemoryList {
+  public:
+    /** \brief Constructor */
+    MemoryList();
+
+    /** \brief Destructor, does not free the memory objects */
+    ~MemoryList();
+
+    /** \brief Number of entries */
+    casadi_int size() const { return n_.load(std::memory_order_acquire);}
+
+    /** \brief Access an entry */
+    void* operator[](casadi_int ind) const {
+      casadi_int s, k;
+      locate(ind, s, k);
+      return seg_[s].load(std::memory_order_acquire)[k].ptr;
+    }
+
+    /** \brief Add a new entry, which is in use, and return its index
+        Calls must be serialized by the caller.
+    */
+    casadi_int add(void* ptr);
+
+    /** \brief Get an unused entry, -1 if there are none */
+    casadi_int pop() {
+      uint64_t head = head_.load(std::memory_order_acquire);
+      while (true) {
+        uint32_t top = static_cast<uint32_t>(head);
+        if (top==0) return -1;
+        uint64_t next = entry(top-1).next.load(std::memory_order_relaxed);
+        uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+        if (head_.compare_exchange_weak(head, new_head, std::memory_order_acquire,
+                                        std::memory_order_acquire)) return top-1;
+      }
+    }
+
+    /** \brief Mark an entry as unused */
+    void push(casadi_int ind) {
+      Entry& e = entry(ind);
+      uint64_t head = head_.load(std::memory_order_relaxed);
+      uint64_t new_head;
+      do {
+        e.next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        new_head = (((head >> 32) + 1) << 32) | static_cast<uint64_t>(ind+1);
+      } while (!head_.compare_exchange_weak(head, new_head, std::memory_order_release,
+                                            std::memory_order_relaxed));
+    }
+
+    /** \brief Remove all entries, not thread-safe */
+    void clear();
+
+#ifndef SWIG
+  private:
+    MemoryList(const MemoryList&) = delete;
+    MemoryList& operator=(const MemoryList&) = delete;
+
+    // An entry: memory object and next unused entry (index+1, 0 if none)
+    struct Entry {
+      void* ptr;
+      std::atomic<uint32_t> next;
+    };
+
+    // Size of the first segment, segment s has size first_seg << s
+    static const casadi_int first_seg = 8;
+
+    // Maximum number of segments
+    static const casadi_int max_seg = 28;
+
+    // Segment and offset of an entry
+    static void locate(casadi_int ind, casadi_int& s, casadi_int& k) {
+      casadi_int q = ind/first_seg + 1;
+      for (s=0; q>>(s+1); ++s) {}
+      k = ind - first_seg*((casadi_int(1) << s) - 1);
+    }
+
+    // Access an entry
+    Entry& entry(casadi_int ind) const {
+      casadi_int s, k;
+      locate(ind, s, k);
+      return seg_[s].load(std::memory_order_acquire)[k];
+    }
+
+    // Segments
+    std::atomic<Entry*> seg_[max_seg];
+
+    // Number of entries
+    std::atomic<casadi_int> n_;
+
+    // Head of the stack of unused entries: version tag (high bits), index+1 (low bits)
+    std::atomic<uint64_t> head_;
+#endif // SWIG
+  };
+
+} // namespace casadi
+
+/// \endcond
+
+#endif // CASADI_MEMORY_LIST_HPP
@@ -29,6 +29,7 @@
 #include "multiplication.hpp"
 #include "casadi_misc.hpp"
 #include "function_internal.hpp"
+#include "simd_kernels.hpp"
 #include "serializing_stream.hpp"
 
 using namespace std;
@@ -51,7 +52,11 @@ namespace casadi {
   }
 
   int Multiplication::eval(const double** arg, double** res, casadi_int* iw, double* w) const {
-    return eval_gen<double>(arg, res, iw, w);
+    if (arg[0]!=res[0]) copy(arg[0], arg[0]+dep(0).nnz(), res[0]);
+    simd_mtimes(arg[1], dep(1).sparsity(),
+                arg[2], dep(2).sparsity(),
+                res[0], sparsity(), w, false);
+    return 0;
   }
 
   int Multiplication::
@@ -132,6 +137,22 @@ namespace casadi {
     }
 
     casadi_int nrow_x = dep(1).size1(), nrow_y = dep(2).size1(), ncol_y = dep(2).size2();
+    if (g.blas && g.blas_threshold>=0 && g.casadi_real_type=="double"
+        && nrow_x*ncol_y*nrow_y>=g.blas_threshold) {
+      // Call the reference BLAS interface
+      g.add_external("void dgemm_(const char* transa, const char* transb, "
+                     "const int* m, const int* n, const int* k, const double* alpha, "
+                     "const double* a, const int* lda, const double* b, const int* ldb, "
+                     "const double* beta, double* c, const int* ldc);");
+      g << "{\n"
+        << "const int m=" << nrow_x << ", n=" << ncol_y << ", k=" << nrow_y << ";\n"
+        << "const double one=1;\n"
+        << "dgemm_(\"N\", \"N\", &m, &n, &k, &one, " << g.work(arg[1], dep(1).nnz())
+        << ", &m, " << g.work(arg[2], dep(2).nnz()) << ", &k, &one, "
+        << g.work(res[0], nnz()) << ", &m);\n"
+        << "}\n";
+      return;
+    }
     g.local("rr", "casadi_real", "*");
     g.local("ss", "casadi_real", "*");
     g.local("tt", "casadi_real", "*");
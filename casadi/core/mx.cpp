@@ -1653,6 +1653,17 @@ namespace casadi {
     }
   }
 
+  std::vector<MX> MX::cse(const std::vector<MX>& ex, bool commutative) {
+    try {
+      // Sort the expression
+      Function f("tmp", vector<MX>{}, ex);
+      casadi_int n_removed;
+      return f.get<MXFunction>()->cse_outputs(commutative, n_removed);
+    } catch (std::exception& e) {
+      CASADI_THROW_ERROR("cse", e.what());
+    }
+  }
+
   MX MX::jacobian(const MX &f, const MX &x, const Dict& opts) {
     try {
       Dict h_opts;
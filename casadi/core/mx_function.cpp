@@ -29,9 +29,15 @@
 #include "casadi_interrupt.hpp"
 #include "io_instruction.hpp"
 #include "serializing_stream.hpp"
+#include "thread_pool.hpp"
 
 #include <stack>
+#include <map>
+#include <iterator>
 #include <typeinfo>
+#include <atomic>
+#include <chrono>
+#include <exception>
 
 // Throw informative error message
 #define CASADI_THROW_ERROR(FNAME, WHAT) \
@@ -61,7 +67,25 @@ namespace casadi {
         "Default input values"}},
       {"live_variables",
        {OT_BOOL,
-        "Reuse variables in the work vector"}}
+        "Reuse variables in the work vector"}},
+      {"cse",
+       {OT_BOOL,
+        "Perform common subexpression elimination on the outputs at initialization"}},
+      {"cse_commutative",
+       {OT_BOOL,
+        "Treat the operands of commutative operations as unordered "
+        "in common subexpression elimination [default: true]"}},
+      {"eval_num_threads",
+       {OT_INT,
+        "Number of threads for evaluating independent function calls and linear solves "
+        "concurrently. Disables live_variables unless set explicitly. "
+        "With record_time, the time of each instruction is reported in the statistics. "
+        "[default: 1]"}},
+      {"alias_io",
+       {OT_BOOL,
+        "Let instructions read directly from the input buffers and write directly "
+        "to the output buffers, instead of copying via the work vector. "
+        "Requires input and output buffers not to overlap [default: true]"}}
      }
   };
 
@@ -69,6 +93,8 @@ namespace casadi {
     Dict opts = FunctionInternal::generate_options(is_temp);
     //opts["default_in"] = default_in_;
     opts["live_variables"] = live_variables_;
+    opts["eval_num_threads"] = eval_num_threads_;
+    opts["alias_io"] = alias_io_;
     return opts;
   }
 
@@ -103,6 +129,9 @@ namespace casadi {
 
     // Default (temporary) options
     live_variables_ = true;
+    eval_num_threads_ = 1;
+    alias_io_ = true;
+    bool cse = false, cse_commutative = true;
 
     // Read options
     for (auto&& op : opts) {
@@ -110,8 +139,22 @@ namespace casadi {
         default_in_ = op.second;
       } else if (op.first=="live_variables") {
         live_variables_ = op.second;
+      } else if (op.first=="cse") {
+        cse = op.second;
+      } else if (op.first=="cse_commutative") {
+        cse_commutative = op.second;
+      } else if (op.first=="eval_num_threads") {
+        eval_num_threads_ = op.second;
+      } else if (op.first=="alias_io") {
+        alias_io_ = op.second;
       }
     }
+    casadi_assert(eval_num_threads_>=1, "Option 'eval_num_threads' must be positive");
+
+    // Reusing work vector elements would serialize independent instructions
+    if (eval_num_threads_>1 && opts.find("live_variables")==opts.end()) {
+      live_variables_ = false;
+    }
 
     // Check/set default inputs
     if (default_in_.empty()) {
@@ -121,6 +164,15 @@ namespace casadi {
                             "Option 'default_in' has incorrect length");
     }
 
+    // Eliminate common subexpressions
+    if (cse) {
+      Function tmp("tmp", vector<MX>{}, out_);
+      casadi_int n_removed;
+      out_ = tmp.get<MXFunction>()->cse_outputs(cse_commutative, n_removed);
+      if (verbose_) casadi_message("Common subexpression elimination removed "
+                                   + str(n_removed) + " operations");
+    }
+
     // Stack used to sort the computational graph
     stack<MXNode*> s;
 
@@ -218,12 +270,51 @@ namespace casadi {
       }
     }
 
+    // Nodes that can be located in the user input and output buffers
+    vector<casadi_int> alias(nodes.size(), -1), alias_nz(nodes.size(), 0);
+    if (alias_io_) {
+      // Inputs are never modified, so all readers can use the input buffer directly
+      for (casadi_int ind=0; ind<in_.size(); ++ind) {
+        vector<MX> prim = in_[ind].primitives();
+        casadi_int nz_offset=0;
+        for (casadi_int p=0; p<prim.size(); ++p) {
+          casadi_int i = prim[p]->temp;
+          if (i<nodes.size() && nodes[i]==prim[p].get() && prim[p].nnz()>1) {
+            alias[i] = ind;
+            alias_nz[i] = nz_offset;
+          }
+          nz_offset += prim[p].nnz();
+        }
+      }
+      // Results of single-output instructions only needed by an output instruction
+      // can be written to the output buffer directly. If the output buffer is null,
+      // the instruction is skipped, so exclude instructions with side effects.
+      for (auto&& e : algorithm_) {
+        if (e.op!=OP_OUTPUT) continue;
+        casadi_int i = e.arg.front();
+        casadi_int op = nodes[i]->op();
+        if (refcount[i]==1 && alias[i]<0 && nodes[i]->nnz()>1 && op>=0
+            && op!=OP_PARAMETER && op!=OP_ASSERTION && op!=OP_MONITOR) {
+          alias[i] = n_in_ + e.data->ind();
+          alias_nz[i] = e.data->offset();
+        }
+      }
+    }
+
     // Place in the work vector for each of the nodes in the tree (overwrites the reference counter)
     vector<casadi_int>& place = place_in_alg; // Reuse memory as it is no longer needed
     place.resize(nodes.size());
+    work_alias_.clear();
+    work_alias_nz_.clear();
+
+    // Unused elements in the work vector, sorted by capacity (last in, first out among equals)
+    multimap<casadi_int, casadi_int> unused;
 
-    // Stack with unused elements in the work vector, sorted by sparsity pattern
-    SPARSITY_MAP<casadi_int, stack<casadi_int> > unused_all;
+    // Capacity (number of nonzeros) of each element in the work vector
+    vector<casadi_int> cap;
+
+    // Elements freed by arguments that may be overwritten in place, with their nonzeros
+    vector<pair<casadi_int, casadi_int> > inplace;
 
     // Work vector size
     casadi_int worksize = 0;
@@ -250,14 +341,15 @@ namespace casadi {
             // unused variables if the count hits zero
             casadi_int remaining = --refcount[ch_ind];
 
-            // Free variable for reuse
-            if (live_variables_ && remaining==0) {
-
-              // Get a pointer to the sparsity pattern of the argument that can be freed
-              casadi_int nnz = nodes[ch_ind]->sparsity().nnz();
-
-              // Add to the stack of unused work vector elements for the current sparsity
-              unused_all[nnz].push(place[ch_ind]);
+            // Free variable for reuse, unless located in a user buffer
+            if (live_variables_ && remaining==0 && alias[ch_ind]<0) {
+              if (task==0) {
+                // Candidate for in-place operation
+                inplace.push_back(make_pair(place[ch_ind], nodes[ch_ind]->sparsity().nnz()));
+              } else {
+                // Add to the unused work vector elements
+                unused.insert(make_pair(cap[place[ch_ind]], place[ch_ind]));
+              }
             }
 
             // Point to the place in the work vector instead of to the place in the list of nodes
@@ -276,29 +368,68 @@ namespace casadi {
         for (casadi_int c=0; c<e.res.size(); ++c) {
           if (e.res[c]>=0) {
 
+            // Number of nonzeros of the result
+            casadi_int nnz = e.data->sparsity(c).nnz();
+
+            // Dedicated element for a node in a user buffer
+            if (alias[e.res[c]]>=0) {
+              work_alias_.resize(worksize, -1);
+              work_alias_nz_.resize(worksize, 0);
+              work_alias_.push_back(alias[e.res[c]]);
+              work_alias_nz_.push_back(alias_nz[e.res[c]]);
+              cap.push_back(0);
+              e.res[c] = place[e.res[c]] = worksize++;
+              continue;
+            }
+
             // Are reuse of variables (live variables) enabled?
             if (live_variables_) {
-              // Get a pointer to the sparsity pattern node
-              casadi_int nnz = e.data->sparsity(c).nnz();
-
-              // Get a reference to the stack for the current sparsity
-              stack<casadi_int>& unused = unused_all[nnz];
+              // In-place operation, requires the same number of nonzeros (first argument first)
+              auto ip = inplace.rbegin();
+              while (ip!=inplace.rend() && ip->second!=nnz) ++ip;
+              if (ip!=inplace.rend()) {
+                e.res[c] = place[e.res[c]] = ip->first;
+                inplace.erase(next(ip).base());
+                continue; // Success, no new element needed in the work vector
+              }
 
-              // Try to reuse a variable from the stack if possible (last in, first out)
-              if (!unused.empty()) {
-                e.res[c] = place[e.res[c]] = unused.top();
-                unused.pop();
+              // Best fit: smallest unused element with sufficient capacity, unless
+              // more than twice as large as needed (different size class). Scalars
+              // are a size class of their own, as they become local variables in C
+              auto it = unused.lower_bound(nnz);
+              if (it!=unused.end() && it->first<=2*nnz && (it->first==1)==(nnz==1)) {
+                it = prev(unused.upper_bound(it->first));
+              } else if (it!=unused.begin() && 2*prev(it)->first>=nnz && prev(it)->first>1) {
+                // Otherwise, grow the largest smaller element in the same size class
+                it = prev(it);
+                cap[it->second] = nnz;
+              } else {
+                it = unused.end();
+              }
+              if (it!=unused.end()) {
+                e.res[c] = place[e.res[c]] = it->second;
+                unused.erase(it);
                 continue; // Success, no new element needed in the work vector
               }
             }
 
             // Allocate a new element in the work vector
+            cap.push_back(nnz);
             e.res[c] = place[e.res[c]] = worksize++;
           }
         }
+
+        // Arguments not overwritten can be reused by subsequent operations
+        for (auto&& ip : inplace) unused.insert(make_pair(cap[ip.first], ip.first));
+        inplace.clear();
       }
     }
 
+    if (!work_alias_.empty()) {
+      work_alias_.resize(worksize, -1);
+      work_alias_nz_.resize(worksize, 0);
+    }
+
     if (verbose_) {
       if (live_variables_) {
         casadi_message("Using live variables: work array is " + str(worksize)
@@ -308,10 +439,78 @@ namespace casadi {
       }
     }
 
+    // Dependency levels for concurrent evaluation
+    level_ptr_.clear();
+    level_ind_.clear();
+    off_arg_.clear();
+    off_res_.clear();
+    off_iw_.clear();
+    off_w_.clear();
+    size_t sz_w_levels = 0;
+    if (eval_num_threads_>1) {
+      // An instruction must come after the last write of its arguments and results,
+      // and after all reads of its results since then
+      vector<casadi_int> level(algorithm_.size());
+      vector<casadi_int> wlev(worksize, -1), rlev(worksize, -1);
+      casadi_int n_level = 0;
+      for (casadi_int k=0; k<algorithm_.size(); ++k) {
+        const AlgEl& e = algorithm_[k];
+        casadi_int lev = 0;
+        for (casadi_int a : e.arg) if (a>=0) lev = max(lev, wlev[a]+1);
+        for (casadi_int r : e.res) if (r>=0) lev = max(lev, max(wlev[r], rlev[r])+1);
+        for (casadi_int a : e.arg) if (a>=0) rlev[a] = max(rlev[a], lev);
+        for (casadi_int r : e.res) {
+          if (r>=0) {
+            wlev[r] = lev;
+            rlev[r] = -1;
+          }
+        }
+        level[k] = lev;
+        n_level = max(n_level, lev+1);
+      }
+
+      // Sort instructions by level
+      level_ptr_.resize(n_level+1, 0);
+      for (casadi_int lev : level) level_ptr_[lev+1]++;
+      for (casadi_int l=0; l<n_level; ++l) level_ptr_[l+1] += level_ptr_[l];
+      level_ind_.resize(algorithm_.size());
+      vector<casadi_int> pos(level_ptr_.begin(), level_ptr_.end()-1);
+      for (casadi_int k=0; k<algorithm_.size(); ++k) level_ind_[pos[level[k]]++] = k;
+
+      // Private scratch space for the instructions of a level
+      off_arg_.resize(algorithm_.size());
+      off_res_.resize(algorithm_.size());
+      off_iw_.resize(algorithm_.size());
+      off_w_.resize(algorithm_.size());
+      for (casadi_int l=0; l<n_level; ++l) {
+        size_t sz_arg=0, sz_res=0, sz_iw=0, sz_w=0;
+        for (casadi_int i=level_ptr_[l]; i<level_ptr_[l+1]; ++i) {
+          casadi_int k = level_ind_[i];
+          const MX& d = algorithm_[k].data;
+          off_arg_[k] = sz_arg;
+          off_res_[k] = sz_res;
+          off_iw_[k] = sz_iw;
+          off_w_[k] = sz_w;
+          sz_arg += d->sz_arg();
+          sz_res += d->sz_res();
+          sz_iw += d->sz_iw();
+          sz_w += d->sz_w();
+        }
+        alloc_arg(sz_arg);
+        alloc_res(sz_res);
+        alloc_iw(sz_iw);
+        sz_w_levels = max(sz_w_levels, sz_w);
+      }
+      if (verbose_) casadi_message(str(algorithm_.size()) + " instructions in "
+                                   + str(n_level) + " dependency levels");
+    }
+
     // Allocate work vectors (numeric)
     workloc_.resize(worksize+1);
     fill(workloc_.begin(), workloc_.end(), -1);
     size_t wind=0, sz_w=0;
+    casadi_int n_alias=0, nnz_alias=0;
+    sz_null_ = 0;
     for (auto&& e : algorithm_) {
       if (e.op!=OP_OUTPUT) {
         for (casadi_int c=0; c<e.res.size(); ++c) {
@@ -322,19 +521,40 @@ namespace casadi {
             sz_w = max(sz_w, e.data->sz_w());
             if (workloc_[e.res[c]] < 0) {
               workloc_[e.res[c]] = wind;
-              wind += e.data->sparsity(c).nnz();
+              if (is_alias(e.res[c])) {
+                casadi_int nnz = e.data->sparsity(c).nnz();
+                if (work_alias_[e.res[c]]<n_in_) sz_null_ = max(sz_null_, nnz);
+                n_alias++;
+                nnz_alias += nnz;
+              } else {
+                wind += cap[e.res[c]];
+              }
             }
           }
         }
       }
     }
     workloc_.back()=wind;
+    sz_w = max(sz_w, sz_w_levels);
+    // Substitute for null input buffers
+    w_null_ = sz_w;
+    sz_w += sz_null_;
     for (casadi_int i=0; i<workloc_.size(); ++i) {
       if (workloc_[i]<0) workloc_[i] = i==0 ? 0 : workloc_[i-1];
       workloc_[i] += sz_w;
     }
     sz_w += wind;
     alloc_w(sz_w);
+    if (verbose_ && n_alias>0) {
+      casadi_message(str(n_alias) + " work vector elements in input/output buffers, "
+                     + str(nnz_alias) + " nonzeros not copied");
+    }
+    if (verbose_) {
+      casadi_int used, total;
+      work_nnz(used, total);
+      casadi_message("Work vector: " + str(used*sizeof(double)) + " bytes, "
+                     + str(total*sizeof(double)) + " bytes without reuse");
+    }
 
     // Reset the temporary variables
     for (casadi_int i=0; i<nodes.size(); ++i) {
@@ -404,41 +624,121 @@ namespace casadi {
                    + str(free_vars_) + " are free.");
     }
 
+    // Timing of the individual instructions
+    auto m = static_cast<MXFunctionMemory*>(mem);
+    if (m && record_time_) m->t_node.assign(algorithm_.size(), 0);
+
+    // Zeros in place of null inputs read directly
+    clear_null(arg, w);
+
+    // Evaluate independent instructions concurrently
+    if (!level_ptr_.empty()) return eval_levels(arg, res, iw, w, m);
+
     // Evaluate all of the nodes of the algorithm:
     // should only evaluate nodes that have not yet been calculated!
-    for (auto&& e : algorithm_) {
-      if (e.op==OP_INPUT) {
-        // Pass an input
-        double *w1 = w+workloc_[e.res.front()];
-        casadi_int nnz=e.data.nnz();
-        casadi_int i=e.data->ind();
-        casadi_int nz_offset=e.data->offset();
-        if (arg[i]==nullptr) {
-          fill(w1, w1+nnz, 0);
-        } else {
-          copy(arg[i]+nz_offset, arg[i]+nz_offset+nnz, w1);
-        }
-      } else if (e.op==OP_OUTPUT) {
-        // Get an output
-        double *w1 = w+workloc_[e.arg.front()];
-        casadi_int nnz=e.data->dep().nnz();
-        casadi_int i=e.data->ind();
-        casadi_int nz_offset=e.data->offset();
-        if (res[i]) copy(w1, w1+nnz, res[i]+nz_offset);
+    for (casadi_int k=0; k<algorithm_.size(); ++k) {
+      if (m && record_time_) {
+        auto t0 = std::chrono::steady_clock::now();
+        if (eval_el(algorithm_[k], arg, res, arg1, res1, iw, w, w)) return 1;
+        m->t_node[k] = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
       } else {
-        // Point pointers to the data corresponding to the element
-        for (casadi_int i=0; i<e.arg.size(); ++i)
-          arg1[i] = e.arg[i]>=0 ? w+workloc_[e.arg[i]] : nullptr;
-        for (casadi_int i=0; i<e.res.size(); ++i)
-          res1[i] = e.res[i]>=0 ? w+workloc_[e.res[i]] : nullptr;
+        if (eval_el(algorithm_[k], arg, res, arg1, res1, iw, w, w)) return 1;
+      }
+    }
+    return 0;
+  }
 
-        // Evaluate
-        if (e.data->eval(arg1, res1, iw, w)) return 1;
+  int MXFunction::eval_el(const AlgEl& e, const double** arg, double** res,
+      const double** arg1, double** res1, casadi_int* iw, double* w_node, double* w) const {
+    if (e.op==OP_INPUT) {
+      // Nothing to do if read directly
+      if (is_alias(e.res.front())) return 0;
+      // Pass an input
+      double *w1 = w+workloc_[e.res.front()];
+      casadi_int nnz=e.data.nnz();
+      casadi_int i=e.data->ind();
+      casadi_int nz_offset=e.data->offset();
+      if (arg[i]==nullptr) {
+        fill(w1, w1+nnz, 0);
+      } else {
+        copy(arg[i]+nz_offset, arg[i]+nz_offset+nnz, w1);
+      }
+    } else if (e.op==OP_OUTPUT) {
+      // Nothing to do if written directly
+      if (is_alias_out(e.arg.front())) return 0;
+      // Get an output
+      const double *w1 = work_ptr(e.arg.front(), arg, res, w);
+      casadi_int nnz=e.data->dep().nnz();
+      casadi_int i=e.data->ind();
+      casadi_int nz_offset=e.data->offset();
+      if (res[i]) copy(w1, w1+nnz, res[i]+nz_offset);
+    } else {
+      // Point pointers to the data corresponding to the element
+      for (casadi_int i=0; i<e.arg.size(); ++i)
+        arg1[i] = e.arg[i]>=0 ? work_ptr(e.arg[i], arg, res, w) : nullptr;
+      for (casadi_int i=0; i<e.res.size(); ++i)
+        res1[i] = e.res[i]>=0 ? work_ptr(e.res[i], arg, res, w) : nullptr;
+
+      // Skip if only needed for a null output
+      if (e.res.size()==1 && res1[0]==nullptr && is_alias_out(e.res[0])) return 0;
+
+      // Evaluate
+      if (e.data->eval(arg1, res1, iw, w_node)) return 1;
+    }
+    return 0;
+  }
+
+  int MXFunction::eval_levels(const double** arg, double** res, casadi_int* iw, double* w,
+      MXFunctionMemory* m) const {
+    const double** arg1 = arg+n_in_;
+    double** res1 = res+n_out_;
+    bool timing = m && record_time_;
+    // Failure flag and first exception thrown, if any
+    std::atomic<bool> failed(false);
+    std::exception_ptr err;
+    // Evaluate one instruction, using its private scratch space
+    auto eval_k = [&](casadi_int k) {
+      std::chrono::steady_clock::time_point t0;
+      if (timing) t0 = std::chrono::steady_clock::now();
+      try {
+        if (eval_el(algorithm_[k], arg, res, arg1+off_arg_[k], res1+off_res_[k],
+                    iw+off_iw_[k], w+off_w_[k], w)) failed = true;
+      } catch (...) {
+        if (!failed.exchange(true)) err = std::current_exception();
+      }
+      if (timing) {
+        m->t_node[k] = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
       }
+    };
+    // Loop over dependency levels
+    for (casadi_int l=0; l+1<level_ptr_.size(); ++l) {
+      const casadi_int* ind = get_ptr(level_ind_) + level_ptr_[l];
+      casadi_int n = level_ptr_[l+1] - level_ptr_[l];
+      // Synchronization only pays off for several expensive instructions
+      casadi_int n_heavy = 0;
+      for (casadi_int i=0; i<n; ++i) {
+        casadi_int op = algorithm_[ind[i]].op;
+        if (op==OP_CALL || op==OP_SOLVE) n_heavy++;
+      }
+      if (n_heavy<2) {
+        for (casadi_int i=0; i<n && !failed; ++i) eval_k(ind[i]);
+      } else {
+        ThreadPool::instance().run(n, eval_num_threads_,
+          [&](casadi_int worker, casadi_int i) { if (!failed) eval_k(ind[i]);}, 1);
+      }
+      if (err) std::rethrow_exception(err);
+      if (failed) return 1;
     }
     return 0;
   }
 
+  int MXFunction::init_mem(void* mem) const {
+    if (XFunction<MXFunction, MX, MXNode>::init_mem(mem)) return 1;
+    auto m = static_cast<MXFunctionMemory*>(mem);
+    if (record_time_) m->t_node.resize(algorithm_.size(), 0);
+    return 0;
+  }
+
   string MXFunction::print(const AlgEl& el) const {
     stringstream s;
     if (el.op==OP_OUTPUT) {
@@ -499,9 +799,14 @@ namespace casadi {
     const bvec_t** arg1=arg+n_in_;
     bvec_t** res1=res+n_out_;
 
+    // Zeros in place of null inputs read directly
+    clear_null(arg, w);
+
     // Propagate sparsity forward
     for (auto&& e : algorithm_) {
       if (e.op==OP_INPUT) {
+        // Nothing to do if read directly
+        if (is_alias(e.res.front())) continue;
         // Pass input seeds
         casadi_int nnz=e.data.nnz();
         casadi_int i=e.data->ind();
@@ -514,19 +819,24 @@ namespace casadi {
           fill_n(w1, nnz, 0);
         }
       } else if (e.op==OP_OUTPUT) {
+        // Nothing to do if written directly
+        if (is_alias_out(e.arg.front())) continue;
         // Get the output sensitivities
         casadi_int nnz=e.data.dep().nnz();
         casadi_int i=e.data->ind();
         casadi_int nz_offset=e.data->offset();
         bvec_t* resi = res[i];
-        bvec_t* w1 = w + workloc_[e.arg.front()];
+        const bvec_t* w1 = work_ptr(e.arg.front(), arg, res, w);
         if (resi!=nullptr) copy(w1, w1+nnz, resi+nz_offset);
       } else {
         // Point pointers to the data corresponding to the element
         for (casadi_int i=0; i<e.arg.size(); ++i)
-          arg1[i] = e.arg[i]>=0 ? w+workloc_[e.arg[i]] : nullptr;
+          arg1[i] = e.arg[i]>=0 ? work_ptr(e.arg[i], arg, res, w) : nullptr;
         for (casadi_int i=0; i<e.res.size(); ++i)
-          res1[i] = e.res[i]>=0 ? w+workloc_[e.res[i]] : nullptr;
+          res1[i] = e.res[i]>=0 ? work_ptr(e.res[i], arg, res, w) : nullptr;
+
+        // Skip if only needed for a null output
+        if (e.res.size()==1 && res1[0]==nullptr && is_alias_out(e.res[0])) continue;
 
         // Propagate sparsity forwards
         if (e.data->sp_forward(arg1, res1, iw, w)) return 1;
@@ -548,6 +858,8 @@ namespace casadi {
     // Propagate sparsity backwards
     for (auto it=algorithm_.rbegin(); it!=algorithm_.rend(); it++) {
       if (it->op==OP_INPUT) {
+        // Nothing to do if read directly
+        if (is_alias(it->res.front())) continue;
         // Get the input sensitivities and clear it from the work vector
         casadi_int nnz=it->data.nnz();
         casadi_int i=it->data->ind();
@@ -557,12 +869,14 @@ namespace casadi {
         if (argi!=nullptr) for (casadi_int k=0; k<nnz; ++k) argi[nz_offset+k] |= w1[k];
         fill_n(w1, nnz, 0);
       } else if (it->op==OP_OUTPUT) {
+        // Nothing to do if written directly
+        if (is_alias_out(it->arg.front())) continue;
         // Pass output seeds
         casadi_int nnz=it->data.dep().nnz();
         casadi_int i=it->data->ind();
         casadi_int nz_offset=it->data->offset();
         bvec_t* resi = res[i] ? res[i] + nz_offset : nullptr;
-        bvec_t* w1 = w + workloc_[it->arg.front()];
+        bvec_t* w1 = work_ptr(it->arg.front(), arg, res, w);
         if (resi!=nullptr) {
           for (casadi_int k=0; k<nnz; ++k) w1[k] |= resi[k];
           fill_n(resi, nnz, 0);
@@ -571,9 +885,12 @@ namespace casadi {
       } else {
         // Point pointers to the data corresponding to the element
         for (casadi_int i=0; i<it->arg.size(); ++i)
-          arg1[i] = it->arg[i]>=0 ? w+workloc_[it->arg[i]] : nullptr;
+          arg1[i] = it->arg[i]>=0 ? work_ptr(it->arg[i], arg, res, w) : nullptr;
         for (casadi_int i=0; i<it->res.size(); ++i)
-          res1[i] = it->res[i]>=0 ? w+workloc_[it->res[i]] : nullptr;
+          res1[i] = it->res[i]>=0 ? work_ptr(it->res[i], arg, res, w) : nullptr;
+
+        // Skip if only needed for a null output
+        if (it->res.size()==1 && res1[0]==nullptr && is_alias_out(it->res[0])) continue;
 
         // Propagate sparsity backwards
         if (it->data->sp_reverse(arg1, res1, iw, w)) return 1;
@@ -674,6 +991,93 @@ namespace casadi {
     }
   }
 
+  std::vector<MX> MXFunction::cse_outputs(bool commutative, casadi_int& n_removed) const {
+    // Symbolic work vector, holding unique expressions only
+    vector<MX> swork(workloc_.size()-1);
+
+    // Symbolic primitives of the inputs
+    vector<vector<MX> > in_split(in_.size());
+    for (casadi_int i=0; i<in_.size(); ++i) in_split[i] = in_[i].primitives();
+
+    // Allocate storage for split outputs
+    vector<vector<MX> > res_split(out_.size());
+    for (casadi_int i=0; i<out_.size(); ++i) res_split[i].resize(out_[i].n_primitives());
+
+    // Unique single-output nodes, bucketed by operation, sparsity and operands
+    std::map<vector<uintptr_t>, vector<MX> > unique;
+    vector<uintptr_t> key;
+
+    // Loop over computational nodes in forward order
+    vector<MX> arg1, res1;
+    n_removed = 0;
+    for (auto&& e : algorithm_) {
+      if (e.op == OP_INPUT) {
+        swork[e.res.front()] = in_split.at(e.data->ind()).at(e.data->segment());
+      } else if (e.op==OP_OUTPUT) {
+        res_split.at(e.data->ind()).at(e.data->segment()) = swork[e.arg.front()];
+      } else if (e.op==OP_PARAMETER) {
+        swork[e.res.front()] = e.data;
+      } else {
+        // Arguments of the operation, after elimination
+        bool changed = false;
+        arg1.resize(e.arg.size());
+        for (casadi_int i=0; i<arg1.size(); ++i) {
+          arg1[i] = e.arg[i]<0 ? e.data->dep(i) : swork[e.arg[i]];
+          if (arg1[i].get()!=e.data->dep(i).get()) changed = true;
+        }
+
+        // Reuse the original node, unless its operands have been replaced
+        res1.resize(e.res.size());
+        if (changed) {
+          e.data->eval_mx(arg1, res1);
+        } else if (e.data->has_output()) {
+          for (casadi_int i=0; i<res1.size(); ++i) {
+            if (e.res[i]>=0) res1[i] = e.data.get_output(i);
+          }
+        } else {
+          res1[0] = e.data;
+        }
+
+        // Look for an equivalent node, nodes with multiple outputs are kept as is
+        if (res1.size()==1 && !res1[0]->has_output()) {
+          MX& r = res1[0];
+          casadi_int ndeps = r->n_dep();
+          if (ndeps>0 || r->op()==OP_CONST) {
+            key.resize(2 + ndeps);
+            key[0] = static_cast<uintptr_t>(r->op());
+            key[1] = reinterpret_cast<uintptr_t>(r->sparsity().get());
+            for (casadi_int i=0; i<ndeps; ++i) {
+              key[2+i] = reinterpret_cast<uintptr_t>(r->dep(i).get());
+            }
+            if (commutative && ndeps==2 && operation_checker<CommChecker>(r->op())
+                && key[3]<key[2]) std::swap(key[2], key[3]);
+            vector<MX>& bucket = unique[key];
+            bool found = false;
+            for (auto&& c : bucket) {
+              if (MX::is_equal(c, r, 1)) {
+                if (c.get()!=r.get()) n_removed++;
+                r = c;
+                found = true;
+                break;
+              }
+            }
+            if (!found) bucket.push_back(r);
+          }
+        }
+
+        // Get the result
+        for (casadi_int i=0; i<res1.size(); ++i) {
+          if (e.res[i]>=0) swork[e.res[i]] = res1[i];
+        }
+      }
+    }
+
+    // Join split outputs
+    vector<MX> ret(out_.size());
+    for (casadi_int i=0; i<ret.size(); ++i) ret[i] = out_[i].join_primitives(res_split[i]);
+    return ret;
+  }
+
   void MXFunction::ad_forward(const std::vector<std::vector<MX> >& fseed,
                                 std::vector<std::vector<MX> >& fsens) const {
     if (verbose_) casadi_message(name_ + "::ad_forward(" + str(fseed.size())+ ")");
@@ -1049,10 +1453,15 @@ namespace casadi {
     vector<const SXElem*> argp(sz_arg());
     vector<SXElem*> resp(sz_res());
 
+    // Zeros in place of null inputs read directly
+    clear_null(arg, w);
+
     // Evaluate all of the nodes of the algorithm:
     // should only evaluate nodes that have not yet been calculated!
     for (auto&& a : algorithm_) {
       if (a.op==OP_INPUT) {
+        // Nothing to do if read directly
+        if (is_alias(a.res.front())) continue;
         // Pass an input
         SXElem *w1 = w+workloc_[a.res.front()];
         casadi_int nnz=a.data.nnz();
@@ -1064,8 +1473,10 @@ namespace casadi {
           std::copy(arg[i]+nz_offset, arg[i]+nz_offset+nnz, w1);
         }
       } else if (a.op==OP_OUTPUT) {
+        // Nothing to do if written directly
+        if (is_alias_out(a.arg.front())) continue;
         // Get the outputs
-        SXElem *w1 = w+workloc_[a.arg.front()];
+        const SXElem *w1 = work_ptr(a.arg.front(), arg, res, w);
         casadi_int nnz=a.data.dep().nnz();
         casadi_int i=a.data->ind();
         casadi_int nz_offset=a.data->offset();
@@ -1075,9 +1486,12 @@ namespace casadi {
       } else {
         // Point pointers to the data corresponding to the element
         for (casadi_int i=0; i<a.arg.size(); ++i)
-          argp[i] = a.arg[i]>=0 ? w+workloc_[a.arg[i]] : nullptr;
+          argp[i] = a.arg[i]>=0 ? work_ptr(a.arg[i], arg, res, w) : nullptr;
         for (casadi_int i=0; i<a.res.size(); ++i)
-          resp[i] = a.res[i]>=0 ? w+workloc_[a.res[i]] : nullptr;
+          resp[i] = a.res[i]>=0 ? work_ptr(a.res[i], arg, res, w) : nullptr;
+
+        // Skip if only needed for a null output
+        if (a.res.size()==1 && resp[0]==nullptr && is_alias_out(a.res[0])) continue;
 
         // Evaluate
         if (a.data->eval_sx(get_ptr(argp), get_ptr(resp), iw, w)) return 1;
@@ -1123,13 +1537,25 @@ namespace casadi {
     bool first = true;
     for (casadi_int i=0; i<workloc_.size()-1; ++i) {
       casadi_int n=workloc_[i+1]-workloc_[i];
-      if (n==0) continue;
+      if (n==0 && !is_alias(i)) continue;
       if (first) {
         g << "casadi_real ";
         first = false;
       } else {
         g << ", ";
       }
+      // Located in a user buffer
+      if (is_alias(i)) {
+        casadi_int a = work_alias_[i];
+        string off = work_alias_nz_[i]==0 ? "" : "+" + str(work_alias_nz_[i]);
+        if (a<n_in_) {
+          g << "*w" << i << "=" << g.arg(a) << " ? (casadi_real*)" << g.arg(a) << off
+            << " : w+" << w_null_;
+        } else {
+          g << "*w" << i << "=" << g.res(a-n_in_) << " ? " << g.res(a-n_in_) << off << " : 0";
+        }
+        continue;
+      }
       /* Could use local variables for small work vector elements here, e.g.:
          ...
          } else if (n<10) {
@@ -1145,6 +1571,19 @@ namespace casadi {
     }
     if (!first) g << ";\n";
 
+    // Zeros in place of null inputs read directly
+    if (sz_null_>0) {
+      vector<bool> is_read(n_in_, false);
+      for (casadi_int a : work_alias_) if (a>=0 && a<n_in_) is_read[a] = true;
+      string cond;
+      for (casadi_int i=0; i<n_in_; ++i) {
+        if (!is_read[i]) continue;
+        if (!cond.empty()) cond += " || ";
+        cond += "!" + g.arg(i);
+      }
+      g << "if (" << cond << ") " << g.clear("w+" + str(w_null_), sz_null_) << "\n";
+    }
+
     // Operation number (for printing)
     casadi_int k=0;
 
@@ -1162,7 +1601,7 @@ namespace casadi {
       arg.resize(e.arg.size());
       for (casadi_int i=0; i<e.arg.size(); ++i) {
         casadi_int j=e.arg.at(i);
-        if (j>=0 && workloc_.at(j)!=workloc_.at(j+1)) {
+        if (j>=0 && (workloc_.at(j)!=workloc_.at(j+1) || is_alias(j))) {
           arg.at(i) = j;
         } else {
           arg.at(i) = -1;
@@ -1173,15 +1612,25 @@ namespace casadi {
       res.resize(e.res.size());
       for (casadi_int i=0; i<e.res.size(); ++i) {
         casadi_int j=e.res.at(i);
-        if (j>=0 && workloc_.at(j)!=workloc_.at(j+1)) {
+        if (j>=0 && (workloc_.at(j)!=workloc_.at(j+1) || is_alias(j))) {
           res.at(i) = j;
         } else {
           res.at(i) = -1;
         }
       }
 
-      // Generate operation
-      e.data->generate(g, arg, res);
+      // Inputs read and outputs written directly need no copying
+      if (e.op==OP_INPUT && is_alias(e.res.front())) continue;
+      if (e.op==OP_OUTPUT && is_alias_out(e.arg.front())) continue;
+
+      // Generate operation, skipped if only needed for a null output
+      if (res.size()==1 && is_alias_out(res[0])) {
+        g << "if (w" << res[0] << ") {\n";
+        e.data->generate(g, arg, res);
+        g << "}\n";
+      } else {
+        e.data->generate(g, arg, res);
+      }
     }
   }
 
@@ -1663,9 +2112,37 @@ namespace casadi {
     }
   }
 
+  void MXFunction::work_nnz(casadi_int& used, casadi_int& total) const {
+    used = workloc_.back() - workloc_.front();
+    total = 0;
+    for (auto&& e : algorithm_) {
+      if (e.op==OP_OUTPUT) continue;
+      for (casadi_int c=0; c<e.res.size(); ++c) {
+        if (e.res[c]>=0 && !is_alias(e.res[c])) total += e.data->sparsity(c).nnz();
+      }
+    }
+  }
+
   Dict MXFunction::get_stats(void* mem) const {
     Dict stats = XFunction::get_stats(mem);
 
+    // Work vector memory for the intermediate results, with and without reuse
+    casadi_int used, total;
+    work_nnz(used, total);
+    stats["w_bytes"] = static_cast<casadi_int>(used*sizeof(double));
+    stats["w_bytes_total"] = static_cast<casadi_int>(total*sizeof(double));
+
+    // Time and dependency level of each instruction
+    auto m = static_cast<MXFunctionMemory*>(mem);
+    if (record_time_) stats["t_wall_node"] = m->t_node;
+    if (!level_ptr_.empty()) {
+      vector<casadi_int> level(algorithm_.size());
+      for (casadi_int l=0; l+1<level_ptr_.size(); ++l) {
+        for (casadi_int i=level_ptr_[l]; i<level_ptr_[l+1]; ++i) level[level_ind_[i]] = l;
+      }
+      stats["level_node"] = level;
+    }
+
     Function dep;
     for (auto&& e : algorithm_) {
       if (e.op==OP_CALL) {
@@ -1683,7 +2160,7 @@ namespace casadi {
   void MXFunction::serialize_body(SerializingStream &s) const {
     XFunction<MXFunction, MX, MXNode>::serialize_body(s);
 
-    s.version("MXFunction", 1);
+    s.version("MXFunction", 3);
     s.pack("MXFunction::n_instr", algorithm_.size());
 
     // Loop over algorithm
@@ -1697,13 +2174,25 @@ namespace casadi {
     s.pack("MXFunction::free_vars", free_vars_);
     s.pack("MXFunction::default_in", default_in_);
     s.pack("MXFunction::live_variables", live_variables_);
+    s.pack("MXFunction::eval_num_threads", eval_num_threads_);
+    s.pack("MXFunction::level_ptr", level_ptr_);
+    s.pack("MXFunction::level_ind", level_ind_);
+    s.pack("MXFunction::off_arg", off_arg_);
+    s.pack("MXFunction::off_res", off_res_);
+    s.pack("MXFunction::off_iw", off_iw_);
+    s.pack("MXFunction::off_w", off_w_);
+    s.pack("MXFunction::alias_io", alias_io_);
+    s.pack("MXFunction::work_alias", work_alias_);
+    s.pack("MXFunction::work_alias_nz", work_alias_nz_);
+    s.pack("MXFunction::w_null", w_null_);
+    s.pack("MXFunction::sz_null", sz_null_);
 
     XFunction<MXFunction, MX, MXNode>::delayed_serialize_members(s);
   }
 
 
   MXFunction::MXFunction(DeserializingStream& s) : XFunction<MXFunction, MX, MXNode>(s) {
-    s.version("MXFunction", 1);
+    int version = s.version("MXFunction", 1, 3);
     size_t n_instructions;
     s.unpack("MXFunction::n_instr", n_instructions);
     algorithm_.resize(n_instructions);
@@ -1719,6 +2208,27 @@ namespace casadi {
     s.unpack("MXFunction::free_vars", free_vars_);
     s.unpack("MXFunction::default_in", default_in_);
     s.unpack("MXFunction::live_variables", live_variables_);
+    if (version>=2) {
+      s.unpack("MXFunction::eval_num_threads", eval_num_threads_);
+      s.unpack("MXFunction::level_ptr", level_ptr_);
+      s.unpack("MXFunction::level_ind", level_ind_);
+      s.unpack("MXFunction::off_arg", off_arg_);
+      s.unpack("MXFunction::off_res", off_res_);
+      s.unpack("MXFunction::off_iw", off_iw_);
+      s.unpack("MXFunction::off_w", off_w_);
+    } else {
+      eval_num_threads_ = 1;
+    }
+    if (version>=3) {
+      s.unpack("MXFunction::alias_io", alias_io_);
+      s.unpack("MXFunction::work_alias", work_alias_);
+      s.unpack("MXFunction::work_alias_nz", work_alias_nz_);
+      s.unpack("MXFunction::w_null", w_null_);
+      s.unpack("MXFunction::sz_null", sz_null_);
+    } else {
+      alias_io_ = false;
+      w_null_ = sz_null_ = 0;
+    }
 
     XFunction<MXFunction, MX, MXNode>::delayed_deserialize_members(s);
   }
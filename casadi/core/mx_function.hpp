@@ -53,6 +53,12 @@ namespace casadi {
     /// Work vector indices of the results
     std::vector<casadi_int> res;
   };
+
+  /** \brief Memory for MXFunction */
+  struct CASADI_EXPORT MXFunctionMemory : public FunctionMemory {
+    // Wall time of each instruction in the last call, if record_time is set
+    std::vector<double> t_node;
+  };
 #endif // SWIG
 
   /** \brief  Internal node class for MXFunction
@@ -80,6 +86,76 @@ namespace casadi {
     /// Live variables?
     bool live_variables_;
 
+    /// Number of threads for evaluating independent instructions concurrently
+    casadi_int eval_num_threads_;
+
+    /** \brief Dependency levels of the algorithm (compressed storage)
+
+        The instructions level_ind_[level_ptr_[l]], ..., level_ind_[level_ptr_[l+1]-1]
+        only depend on instructions in previous levels and may be evaluated concurrently.
+        Empty unless eval_num_threads_>1.
+    */
+    std::vector<casadi_int> level_ptr_, level_ind_;
+
+    /// Offsets of the private arg, res, iw and w scratch space of each instruction
+    std::vector<casadi_int> off_arg_, off_res_, off_iw_, off_w_;
+
+    /// Read inputs and write outputs in place, without copying through the work vector?
+    bool alias_io_;
+
+    /** \brief Work vector elements located in the user input and output buffers
+
+        Element i is stored in w if work_alias_[i]<0. Otherwise, it is read directly from
+        input work_alias_[i] (if less than n_in_) or written directly to output
+        work_alias_[i]-n_in_, at nonzero offset work_alias_nz_[i].
+        Empty if no element is aliased.
+    */
+    std::vector<casadi_int> work_alias_, work_alias_nz_;
+
+    /** \brief Substitute for a null input buffer
+
+        Offset in w of a block of size sz_null_, zero-filled and read in place of a null
+        input. In reverse mode, it receives the discarded sensitivities instead.
+        A null output buffer is represented by a null pointer; the instruction writing
+        it is skipped.
+    */
+    casadi_int w_null_, sz_null_;
+
+    /** \brief Location of work vector element i for given input and output buffers */
+    template<typename T, typename A>
+    T* work_ptr(casadi_int i, A** arg, T** res, T* w) const {
+      casadi_int a = work_alias_.empty() ? -1 : work_alias_[i];
+      if (a<0) return w + workloc_[i];
+      if (a<n_in_) {
+        if (arg[a]==nullptr) return w + w_null_;
+        return const_cast<T*>(arg[a]) + work_alias_nz_[i];
+      } else {
+        a -= n_in_;
+        if (res[a]==nullptr) return nullptr;
+        return res[a] + work_alias_nz_[i];
+      }
+    }
+
+    /** \brief Is work vector element i located in a user input or output buffer? */
+    bool is_alias(casadi_int i) const {
+      return i>=0 && !work_alias_.empty() && work_alias_[i]>=0;
+    }
+
+    /** \brief Is work vector element i written directly to an output buffer? */
+    bool is_alias_out(casadi_int i) const { return is_alias(i) && work_alias_[i]>=n_in_;}
+
+    /** \brief Zero-fill the substitute for null inputs, if needed */
+    template<typename A, typename T>
+    void clear_null(A** arg, T* w) const {
+      if (sz_null_==0) return;
+      for (casadi_int i=0; i<n_in_; ++i) {
+        if (arg[i]==nullptr) {
+          std::fill_n(w + w_null_, sz_null_, 0);
+          return;
+        }
+      }
+    }
+
     /** \brief Constructor */
     MXFunction(const std::string& name,
       const std::vector<MX>& input, const std::vector<MX>& output,
@@ -92,6 +168,26 @@ namespace casadi {
     /** \brief  Evaluate numerically, work vectors given */
     int eval(const double** arg, double** res, casadi_int* iw, double* w, void* mem) const override;
 
+    /** \brief Evaluate a single instruction numerically
+
+        w_node is the scratch space of the instruction, the work vector elements are in w.
+    */
+    int eval_el(const AlgEl& e, const double** arg, double** res, const double** arg1,
+                double** res1, casadi_int* iw, double* w_node, double* w) const;
+
+    /** \brief Evaluate numerically, independent instructions concurrently */
+    int eval_levels(const double** arg, double** res, casadi_int* iw, double* w,
+                    MXFunctionMemory* m) const;
+
+    /** \brief Create memory block */
+    void* alloc_mem() const override { return new MXFunctionMemory();}
+
+    /** \brief Initalize memory block */
+    int init_mem(void* mem) const override;
+
+    /** \brief Free memory block */
+    void free_mem(void *mem) const override { delete static_cast<MXFunctionMemory*>(mem);}
+
     /** \brief  Print description */
     void disp_more(std::ostream& stream) const override;
 
@@ -107,6 +203,12 @@ namespace casadi {
     const Options& get_options() const override { return options_;}
     ///@}
 
+    /** \brief Nonzeros in the work vector for the intermediate results
+
+        used: with reuse of elements (live variables), total: without reuse
+    */
+    void work_nnz(casadi_int& used, casadi_int& total) const;
+
     /// Get all statistics
     Dict get_stats(void* mem) const override;
 
@@ -128,6 +230,15 @@ namespace casadi {
     /** \brief Generate code for the body of the C function */
     void codegen_body(CodeGenerator& g) const override;
 
+    /** \brief Outputs after common subexpression elimination
+
+        Nodes with a single output that are structurally identical (same operation,
+        sparsity and operands after elimination) are replaced by a single node.
+        If commutative is set, the operands of commutative operations are treated
+        as unordered. The number of removed instructions is returned in n_removed.
+    */
+    std::vector<MX> cse_outputs(bool commutative, casadi_int& n_removed) const;
+
     /** \brief Serialize an object without type information */
     void serialize_body(SerializingStream &s) const override;
 
@@ -183,8 +183,9 @@ namespace casadi {
     // Number of inputs and outputs
     casadi_int n_in = f.n_in(), n_out = f.n_out();
 
-    // Prepare stats, start timer
-    ScopedTiming tic(fstats);
+    // Prepare stats, start timer. The proc time, which is costly to query
+    // for cheap functions called in a tight loop, requires record_time
+    ScopedTiming tic(fstats, record_time_);
 
     // Input buffers
     if (arg) {
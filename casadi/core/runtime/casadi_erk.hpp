@@ -0,0 +1,249 @@
+// NOLINT(legal/copyright)
+// SYMBOL "erk_mem"
+template<typename T1>
+struct casadi_erk_mem {
+  // Butcher tableau: stages, nodes, coefficients (row major), weights, error weights
+  casadi_int s;
+  const T1 *c, *a, *b, *e;
+  // Order of the error estimate, last stage evaluated at the new state?
+  casadi_int q, fsal;
+  // Dense output weights, polynomials in theta without constant term (s-by-nd),
+  // nd=0 if the scheme has none: steps are then shortened to end at tout
+  const T1* bd;
+  casadi_int nd;
+  // Number of states, of which the first nerr are error controlled
+  casadi_int n, nerr;
+  // Direction of integration: dy/dt = dir*f(t, y)
+  T1 dir;
+  // Tolerances
+  T1 abstol, reltol;
+  // End of the integration interval, never stepped past
+  T1 tend;
+  // Maximum number of steps
+  casadi_int max_num_steps;
+  // Current and previous time, step size, step size before shortening
+  T1 t, tp, h, hprop;
+  // Current and previous state and f(t, y)
+  T1 *y, *yp, *f, *fp;
+  // Stage derivatives (s-by-n), temporary state
+  T1 *k, *ytmp;
+  // Requested evaluation of f
+  T1 teval;
+  const T1* yeval;
+  T1* feval;
+  // Position in the algorithm
+  casadi_int next, stage, last, rejected;
+  // Counters
+  casadi_int nsteps, nrejects, nfevals;
+};
+
+// C-REPLACE "casadi_erk_mem<T1>" "struct casadi_erk_mem"
+// SYMBOL "erk_reset"
+template<typename T1>
+void casadi_erk_reset(casadi_erk_mem<T1>* m, T1 t) {
+  m->t = m->tp = t;
+  m->h = 0;
+  m->next = 0;
+  m->last = m->rejected = 0;
+  m->nsteps = m->nrejects = m->nfevals = 0;
+}
+
+// SYMBOL "erk_norm"
+template<typename T1>
+T1 casadi_erk_norm(const casadi_erk_mem<T1>* m, const T1* v, const T1* y1, const T1* y2) {
+  // Weighted root mean square norm
+  casadi_int i;
+  T1 r, sc, ay1, ay2;
+  r = 0;
+  for (i=0; i<m->nerr; ++i) {
+    ay1 = y1[i]<0 ? -y1[i] : y1[i];
+    ay2 = y2[i]<0 ? -y2[i] : y2[i];
+    sc = m->abstol + m->reltol*(ay1>ay2 ? ay1 : ay2);
+    r += (v[i]/sc)*(v[i]/sc);
+  }
+  return m->nerr>0 ? sqrt(r/m->nerr) : 0;
+}
+
+// SYMBOL "erk"
+template<typename T1>
+int casadi_erk(casadi_erk_mem<T1>* m, T1 tout) {
+  // Advance the solution until t reaches tout, with reverse communication:
+  // 1: evaluate f(teval, yeval) into feval and call again
+  // 2: step accepted (or initial point), y and f valid at t, call again
+  // 0: t has reached tout, -1: too many steps, -2: step size too small
+  casadi_int i, j, n;
+  T1 d0, d1, d2, h0, err, fac, hk, tstop;
+  n = m->n;
+  while (1) {
+    switch (m->next) {
+    case 0:
+      // Evaluate f at the initial point
+      m->teval = m->t;
+      m->yeval = m->y;
+      m->feval = m->f;
+      m->nfevals++;
+      m->next = 1;
+      return 1;
+    case 1:
+      // Initial point available
+      m->next = 2;
+      return 2;
+    case 2:
+      // Initial step size, first estimate
+      hk = m->dir*(m->tend - m->t);
+      if (hk<=0) {
+        m->next = 4;
+        break;
+      }
+      d0 = casadi_erk_norm(m, m->y, m->y, m->y);
+      d1 = casadi_erk_norm(m, m->f, m->y, m->y);
+      h0 = d0<1e-5 || d1<1e-5 ? 1e-6 : 0.01*d0/d1;
+      if (h0>hk) h0 = hk;
+      m->h = h0;
+      for (i=0; i<n; ++i) m->ytmp[i] = m->y[i] + h0*m->f[i];
+      m->teval = m->t + m->dir*h0;
+      m->yeval = m->ytmp;
+      m->feval = m->k;
+      m->nfevals++;
+      m->next = 3;
+      return 1;
+    case 3:
+      // Initial step size from the change in f
+      h0 = m->h;
+      for (i=0; i<n; ++i) m->k[i] -= m->f[i];
+      d1 = casadi_erk_norm(m, m->f, m->y, m->y);
+      d2 = casadi_erk_norm(m, m->k, m->y, m->y)/h0;
+      if (d2>d1) d1 = d2;
+      m->h = d1<=1e-15 ? (h0*1e-3>1e-6 ? h0*1e-3 : 1e-6) : pow(0.01/d1, 1./(m->q+1));
+      if (m->h>100*h0) m->h = 100*h0;
+      m->next = 4;
+      break;
+    case 4:
+      // Start of a step
+      if (m->dir*(tout - m->t)<=0) return 0;
+      if (m->nsteps>=m->max_num_steps) return -1;
+      // Do not step past the end of the interval, or past tout without dense output
+      tstop = m->nd==0 && m->dir*(m->tend - tout)>0 ? tout : m->tend;
+      hk = m->dir*(tstop - m->t);
+      m->last = m->h>=hk;
+      if (m->last) {
+        m->hprop = m->h;
+        m->h = hk;
+      }
+      if (m->h<=1e-14*(m->t<0 ? -m->t : m->t) || m->h<=0) return -2;
+      for (i=0; i<n; ++i) m->k[i] = m->f[i];
+      m->stage = 1;
+      m->next = 5;
+      break;
+    case 5:
+      // Intermediate stages
+      if (m->stage<m->s) {
+        for (i=0; i<n; ++i) m->ytmp[i] = m->y[i];
+        for (j=0; j<m->stage; ++j) {
+          fac = m->h*m->a[m->stage*m->s+j];
+          if (fac!=0) {
+            for (i=0; i<n; ++i) m->ytmp[i] += fac*m->k[j*n+i];
+          }
+        }
+        m->teval = m->t + m->dir*m->c[m->stage]*m->h;
+        m->yeval = m->ytmp;
+        m->feval = m->k + m->stage*n;
+        m->nfevals++;
+        m->stage++;
+        return 1;
+      }
+      // New state and error estimate, the latter stored in fp until acceptance
+      for (i=0; i<n; ++i) {
+        m->ytmp[i] = m->y[i];
+        m->fp[i] = 0;
+      }
+      for (j=0; j<m->s; ++j) {
+        fac = m->h*m->b[j];
+        if (fac!=0) {
+          for (i=0; i<n; ++i) m->ytmp[i] += fac*m->k[j*n+i];
+        }
+        fac = m->h*m->e[j];
+        if (fac!=0) {
+          for (i=0; i<n; ++i) m->fp[i] += fac*m->k[j*n+i];
+        }
+      }
+      err = casadi_erk_norm(m, m->fp, m->y, m->ytmp);
+      // Step size factor, smallest if the error estimate is not a number
+      fac = err>0 ? 0.9*pow(err, -1./(m->q+1)) : err==0 ? 5 : 0.2;
+      if (fac>5) fac = 5;
+      if (fac<0.2) fac = 0.2;
+      if (!(err<=1)) {
+        // Reject the step
+        m->h *= fac;
+        m->nrejects++;
+        m->rejected = 1;
+        m->next = 4;
+        break;
+      }
+      // Accept the step
+      if (m->rejected && fac>1) fac = 1;
+      m->rejected = 0;
+      tstop = m->nd==0 && m->dir*(m->tend - tout)>0 ? tout : m->tend;
+      m->tp = m->t;
+      m->t = m->last ? tstop : m->t + m->dir*m->h;
+      m->h *= fac;
+      // A shortened step does not limit the next one
+      if (m->last && fac>=1 && m->hprop>m->h) m->h = m->hprop;
+      m->nsteps++;
+      for (i=0; i<n; ++i) {
+        m->yp[i] = m->y[i];
+        m->fp[i] = m->f[i];
+        m->y[i] = m->ytmp[i];
+      }
+      m->next = 6;
+      if (m->fsal) {
+        for (i=0; i<n; ++i) m->f[i] = m->k[(m->s-1)*n+i];
+        break;
+      }
+      m->teval = m->t;
+      m->yeval = m->y;
+      m->feval = m->f;
+      m->nfevals++;
+      return 1;
+    case 6:
+      // Step accepted
+      m->next = 4;
+      return 2;
+    }
+  }
+}
+
+// SYMBOL "erk_dense"
+template<typename T1>
+void casadi_erk_dense(const casadi_erk_mem<T1>* m, casadi_int n, T1 theta, T1 h,
+                      const T1* y0, const T1* k, T1* r) {
+  // Dense output at t0 + dir*theta*h for a step of size h from y0 with stages k (s-by-n)
+  casadi_int i, j, l;
+  T1 w, p;
+  for (i=0; i<n; ++i) r[i] = y0[i];
+  for (j=0; j<m->s; ++j) {
+    w = 0;
+    p = h;
+    for (l=0; l<m->nd; ++l) {
+      p *= theta;
+      w += m->bd[j*m->nd+l]*p;
+    }
+    if (w!=0) {
+      for (i=0; i<n; ++i) r[i] += w*k[j*n+i];
+    }
+  }
+}
+
+// SYMBOL "erk_interp"
+template<typename T1>
+void casadi_erk_interp(const casadi_erk_mem<T1>* m, T1 tout, T1* r) {
+  // Dense output at tout, within the last accepted step
+  casadi_int i;
+  T1 h;
+  if (m->nsteps==0 || tout==m->t || m->nd==0) {
+    for (i=0; i<m->n; ++i) r[i] = m->y[i];
+  } else {
+    h = m->dir*(m->t - m->tp);
+    casadi_erk_dense(m, m->n, m->dir*(tout - m->tp)/h, h, m->yp, m->k, r);
+  }
+}
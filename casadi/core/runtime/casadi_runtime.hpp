@@ -215,6 +215,20 @@ namespace casadi {
   template<typename T1>
   int casadi_newton(const casadi_newton_mem<T1>* m);
 
+  template <class T1>
+  struct casadi_erk_mem;
+
+  // Embedded explicit Runge-Kutta integration
+  template<typename T1>
+  void casadi_erk_reset(casadi_erk_mem<T1>* m, T1 t);
+  template<typename T1>
+  int casadi_erk(casadi_erk_mem<T1>* m, T1 tout);
+  template<typename T1>
+  void casadi_erk_dense(const casadi_erk_mem<T1>* m, casadi_int n, T1 theta, T1 h,
+                        const T1* y0, const T1* k, T1* r);
+  template<typename T1>
+  void casadi_erk_interp(const casadi_erk_mem<T1>* m, T1 tout, T1* r);
+
   // Dense matrix multiplication
   #define CASADI_GEMM_NT(M, N, K, A, LDA, B, LDB, C, LDC) \
     for (i=0, rr=C; i<M; ++i) \
@@ -272,6 +286,7 @@ namespace casadi {
   #include "casadi_bfgs.hpp"
   #include "casadi_regularize.hpp"
   #include "casadi_newton.hpp"
+  #include "casadi_erk.hpp"
   #include "casadi_bound_consistency.hpp"
   #include "casadi_lsqr.hpp"
   #include "casadi_cache.hpp"
@@ -0,0 +1,342 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "simd_kernels.hpp"
+#include "casadi_misc.hpp"
+#include "exception.hpp"
+#include "global_options.hpp"
+#include "runtime/casadi_runtime.hpp"
+
+#include <algorithm>
+#include <limits>
+
+// Kernels for x86 processors, compiled for the target instruction set on a per-function basis
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CASADI_SIMD_X86
+#include <immintrin.h>
+#define CASADI_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define CASADI_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif // x86
+
+#ifdef CASADI_WITH_BLAS
+// Reference BLAS interface (Fortran calling convention)
+extern "C" {
+  void dgemm_(const char* transa, const char* transb, const int* m, const int* n, const int* k,
+              const double* alpha, const double* a, const int* lda, const double* b,
+              const int* ldb, const double* beta, double* c, const int* ldc);
+  void dgemv_(const char* trans, const int* m, const int* n, const double* alpha,
+              const double* a, const int* lda, const double* x, const int* incx,
+              const double* beta, double* y, const int* incy);
+}
+#endif // CASADI_WITH_BLAS
+
+using namespace std;
+
+namespace casadi {
+
+  // Cache blocking of the dense matrix-matrix product: rows and inner dimension
+  static const casadi_int GEMM_MB = 256, GEMM_KB = 128;
+
+  casadi_int simd_level_supported() {
+#ifdef CASADI_SIMD_X86
+    static const casadi_int level = []() -> casadi_int {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx512f")) return 2;
+      if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return 1;
+      return 0;
+    }();
+    return level;
+#else // CASADI_SIMD_X86
+    return 0;
+#endif // CASADI_SIMD_X86
+  }
+
+  casadi_int simd_level() {
+    casadi_int level = simd_level_supported();
+    if (GlobalOptions::simd_level>=0) level = min(level, GlobalOptions::simd_level);
+    return level;
+  }
+
+  bool blas_available() {
+#ifdef CASADI_WITH_BLAS
+    return true;
+#else // CASADI_WITH_BLAS
+    return false;
+#endif // CASADI_WITH_BLAS
+  }
+
+  bool use_blas(casadi_int m, casadi_int n, casadi_int k) {
+    if (!blas_available() || GlobalOptions::blas_threshold<0) return false;
+    // Fortran integers
+    if (max(m, max(n, k)) > numeric_limits<int>::max()) return false;
+    return m*n*k >= GlobalOptions::blas_threshold;
+  }
+
+  // Scalar versions
+  static void gemm_scalar(casadi_int m, casadi_int n, casadi_int k,
+                          const double* x, const double* y, double* z) {
+    for (casadi_int j=0; j<n; ++j) {
+      for (casadi_int l=0; l<k; ++l) {
+        casadi_axpy(m, y[l + j*k], x + l*m, z + j*m);
+      }
+    }
+  }
+
+#ifdef CASADI_SIMD_X86
+  CASADI_TARGET_AVX2
+  static double dot_avx2(casadi_int n, const double* x, const double* y) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    casadi_int i=0;
+    for (; i+8<=n; i+=8) {
+      s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x+i), _mm256_loadu_pd(y+i), s0);
+      s1 = _mm256_fmadd_pd(_mm256_loadu_pd(x+i+4), _mm256_loadu_pd(y+i+4), s1);
+    }
+    if (i+4<=n) {
+      s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x+i), _mm256_loadu_pd(y+i), s0);
+      i += 4;
+    }
+    double s[4];
+    _mm256_storeu_pd(s, _mm256_add_pd(s0, s1));
+    double r = (s[0]+s[1]) + (s[2]+s[3]);
+    for (; i<n; ++i) r += x[i]*y[i];
+    return r;
+  }
+
+  CASADI_TARGET_AVX512
+  static double dot_avx512(casadi_int n, const double* x, const double* y) {
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    casadi_int i=0;
+    for (; i+16<=n; i+=16) {
+      s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x+i), _mm512_loadu_pd(y+i), s0);
+      s1 = _mm512_fmadd_pd(_mm512_loadu_pd(x+i+8), _mm512_loadu_pd(y+i+8), s1);
+    }
+    if (i+8<=n) {
+      s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x+i), _mm512_loadu_pd(y+i), s0);
+      i += 8;
+    }
+    double s[8];
+    _mm512_storeu_pd(s, _mm512_add_pd(s0, s1));
+    double r = ((s[0]+s[1]) + (s[2]+s[3])) + ((s[4]+s[5]) + (s[6]+s[7]));
+    for (; i<n; ++i) r += x[i]*y[i];
+    return r;
+  }
+
+  CASADI_TARGET_AVX2
+  static void axpy_avx2(casadi_int n, double alpha, const double* x, double* y) {
+    __m256d a = _mm256_set1_pd(alpha);
+    casadi_int i=0;
+    for (; i+4<=n; i+=4) {
+      _mm256_storeu_pd(y+i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x+i), _mm256_loadu_pd(y+i)));
+    }
+    for (; i<n; ++i) y[i] += alpha*x[i];
+  }
+
+  CASADI_TARGET_AVX512
+  static void axpy_avx512(casadi_int n, double alpha, const double* x, double* y) {
+    __m512d a = _mm512_set1_pd(alpha);
+    casadi_int i=0;
+    for (; i+8<=n; i+=8) {
+      _mm512_storeu_pd(y+i, _mm512_fmadd_pd(a, _mm512_loadu_pd(x+i), _mm512_loadu_pd(y+i)));
+    }
+    for (; i<n; ++i) y[i] += alpha*x[i];
+  }
+
+  /* Register-blocked kernel: rows [i, i+8) and columns [j, j+4) of z,
+     inner dimension [l0, l1), with leading dimensions m (x and z) and k (y) */
+  CASADI_TARGET_AVX2
+  static void gemm_8x4_avx2(casadi_int m, casadi_int k, casadi_int l0, casadi_int l1,
+                            const double* x, const double* y, double* z) {
+    __m256d c[2][4];
+    for (casadi_int c1=0; c1<4; ++c1) {
+      c[0][c1] = _mm256_loadu_pd(z + c1*m);
+      c[1][c1] = _mm256_loadu_pd(z + c1*m + 4);
+    }
+    for (casadi_int l=l0; l<l1; ++l) {
+      __m256d a0 = _mm256_loadu_pd(x + l*m), a1 = _mm256_loadu_pd(x + l*m + 4);
+      for (casadi_int c1=0; c1<4; ++c1) {
+        __m256d b = _mm256_set1_pd(y[l + c1*k]);
+        c[0][c1] = _mm256_fmadd_pd(a0, b, c[0][c1]);
+        c[1][c1] = _mm256_fmadd_pd(a1, b, c[1][c1]);
+      }
+    }
+    for (casadi_int c1=0; c1<4; ++c1) {
+      _mm256_storeu_pd(z + c1*m, c[0][c1]);
+      _mm256_storeu_pd(z + c1*m + 4, c[1][c1]);
+    }
+  }
+
+  /* Register-blocked kernel: rows [i, i+16) and columns [j, j+4) of z */
+  CASADI_TARGET_AVX512
+  static void gemm_16x4_avx512(casadi_int m, casadi_int k, casadi_int l0, casadi_int l1,
+                               const double* x, const double* y, double* z) {
+    __m512d c[2][4];
+    for (casadi_int c1=0; c1<4; ++c1) {
+      c[0][c1] = _mm512_loadu_pd(z + c1*m);
+      c[1][c1] = _mm512_loadu_pd(z + c1*m + 8);
+    }
+    for (casadi_int l=l0; l<l1; ++l) {
+      __m512d a0 = _mm512_loadu_pd(x + l*m), a1 = _mm512_loadu_pd(x + l*m + 8);
+      for (casadi_int c1=0; c1<4; ++c1) {
+        __m512d b = _mm512_set1_pd(y[l + c1*k]);
+        c[0][c1] = _mm512_fmadd_pd(a0, b, c[0][c1]);
+        c[1][c1] = _mm512_fmadd_pd(a1, b, c[1][c1]);
+      }
+    }
+    for (casadi_int c1=0; c1<4; ++c1) {
+      _mm512_storeu_pd(z + c1*m, c[0][c1]);
+      _mm512_storeu_pd(z + c1*m + 8, c[1][c1]);
+    }
+  }
+#endif // CASADI_SIMD_X86
+
+  double simd_dot(casadi_int n, const double* x, const double* y) {
+#ifdef CASADI_SIMD_X86
+    switch (simd_level()) {
+      case 2: return dot_avx512(n, x, y);
+      case 1: return dot_avx2(n, x, y);
+      default: break;
+    }
+#endif // CASADI_SIMD_X86
+    return casadi_dot(n, x, y);
+  }
+
+  void simd_axpy(casadi_int n, double alpha, const double* x, double* y) {
+    if (!x || !y) return;
+#ifdef CASADI_SIMD_X86
+    switch (simd_level()) {
+      case 2: return axpy_avx512(n, alpha, x, y);
+      case 1: return axpy_avx2(n, alpha, x, y);
+      default: break;
+    }
+#endif // CASADI_SIMD_X86
+    casadi_axpy(n, alpha, x, y);
+  }
+
+  void simd_mv_dense(const double* x, casadi_int nrow_x, casadi_int ncol_x,
+                     const double* y, double* z, bool tr) {
+    if (!x || !y || !z) return;
+#ifdef CASADI_WITH_BLAS
+    if (use_blas(nrow_x, 1, ncol_x)) {
+      int m = nrow_x, n = ncol_x, inc = 1;
+      double one = 1;
+      dgemv_(tr ? "T" : "N", &m, &n, &one, x, &m, y, &inc, &one, z, &inc);
+      return;
+    }
+#endif // CASADI_WITH_BLAS
+    if (tr) {
+      for (casadi_int i=0; i<ncol_x; ++i) z[i] += simd_dot(nrow_x, x + i*nrow_x, y);
+    } else {
+      for (casadi_int i=0; i<ncol_x; ++i) simd_axpy(nrow_x, y[i], x + i*nrow_x, z);
+    }
+  }
+
+  void simd_gemm(casadi_int m, casadi_int n, casadi_int k,
+                 const double* x, const double* y, double* z) {
+#ifdef CASADI_WITH_BLAS
+    if (n>1 && use_blas(m, n, k)) {
+      int m1 = m, n1 = n, k1 = k;
+      double one = 1;
+      dgemm_("N", "N", &m1, &n1, &k1, &one, x, &m1, y, &k1, &one, z, &m1);
+      return;
+    }
+#endif // CASADI_WITH_BLAS
+    casadi_int level = simd_level();
+    if (level==0 || n==1) {
+      if (level==0) return gemm_scalar(m, n, k, x, y, z);
+      return simd_mv_dense(x, m, k, y, z, false);
+    }
+#ifdef CASADI_SIMD_X86
+    // Rows handled by the register-blocked kernel
+    casadi_int mr = level==2 ? 16 : 8;
+    // Loop over blocks of the inner dimension and the rows
+    for (casadi_int l0=0; l0<k; l0+=GEMM_KB) {
+      casadi_int l1 = min(l0+GEMM_KB, k);
+      for (casadi_int i0=0; i0<m; i0+=GEMM_MB) {
+        casadi_int i1 = min(i0+GEMM_MB, m);
+        casadi_int j=0;
+        for (; j+4<=n; j+=4) {
+          casadi_int i=i0;
+          for (; i+mr<=i1; i+=mr) {
+            if (level==2) {
+              gemm_16x4_avx512(m, k, l0, l1, x+i, y+j*k, z+i+j*m);
+            } else {
+              gemm_8x4_avx2(m, k, l0, l1, x+i, y+j*k, z+i+j*m);
+            }
+          }
+          // Remaining rows
+          if (i<i1) {
+            for (casadi_int c=j; c<j+4; ++c) {
+              for (casadi_int l=l0; l<l1; ++l) {
+                simd_axpy(i1-i, y[l+c*k], x+i+l*m, z+i+c*m);
+              }
+            }
+          }
+        }
+        // Remaining columns
+        for (; j<n; ++j) {
+          for (casadi_int l=l0; l<l1; ++l) {
+            simd_axpy(i1-i0, y[l+j*k], x+i0+l*m, z+i0+j*m);
+          }
+        }
+      }
+    }
+#endif // CASADI_SIMD_X86
+  }
+
+  // Is a compressed column storage pattern dense?
+  static bool is_dense(const casadi_int* sp) {
+    return sp[0]*sp[1] == sp[2+sp[1]];
+  }
+
+  void simd_mtimes(const double* x, const casadi_int* sp_x,
+                   const double* y, const casadi_int* sp_y,
+                   double* z, const casadi_int* sp_z, double* w, bool tr) {
+    casadi_int nrow_x = sp_x[0], ncol_x = sp_x[1], ncol_y = sp_y[1], nrow_z = sp_z[0];
+    if ((simd_level()>0 || use_blas(nrow_x, ncol_y, ncol_x))
+        && is_dense(sp_x) && is_dense(sp_z) && (!tr || is_dense(sp_y))) {
+      if (tr) {
+        // Inner products of the columns
+        for (casadi_int j=0; j<ncol_y; ++j) {
+          simd_mv_dense(x, nrow_x, ncol_x, y+j*nrow_x, z+j*nrow_z, true);
+        }
+      } else if (is_dense(sp_y)) {
+        // Dense product
+        simd_gemm(nrow_x, ncol_y, ncol_x, x, y, z);
+      } else {
+        // Linear combinations of the columns of x
+        const casadi_int *colind_y = sp_y+2, *row_y = sp_y+2+ncol_y+1;
+        for (casadi_int j=0; j<ncol_y; ++j) {
+          for (casadi_int kk=colind_y[j]; kk<colind_y[j+1]; ++kk) {
+            simd_axpy(nrow_x, y[kk], x+row_y[kk]*nrow_x, z+j*nrow_z);
+          }
+        }
+      }
+      return;
+    }
+    casadi_mtimes(x, sp_x, y, sp_y, z, sp_z, w, tr);
+  }
+
+} // namespace casadi
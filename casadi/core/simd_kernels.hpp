@@ -0,0 +1,92 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#ifndef CASADI_SIMD_KERNELS_HPP
+#define CASADI_SIMD_KERNELS_HPP
+
+#include "casadi_common.hpp"
+
+/// \cond INTERNAL
+
+namespace casadi {
+
+  /** \brief Vectorized numerical kernels for the in-process evaluation
+
+      Double precision variants of the runtime routines casadi_dot, casadi_axpy,
+      casadi_mv_dense and casadi_mtimes, with dense matrix-matrix products blocked
+      for cache and registers. The instruction set is selected at runtime:
+      0: scalar, 1: AVX2 with FMA, 2: AVX-512. The best supported one is used,
+      unless limited by GlobalOptions::simd_level.
+
+      When built with WITH_BLAS=ON, dense products above GlobalOptions::blas_threshold
+      are handed to the external BLAS routines dgemm and dgemv instead.
+
+      Generated code keeps using the portable C runtime, see the codegen option "blas".
+  */
+  ///@{
+  /** \brief Instruction set used by the kernels */
+  CASADI_EXPORT casadi_int simd_level();
+
+  /** \brief Best instruction set supported by the CPU */
+  CASADI_EXPORT casadi_int simd_level_supported();
+
+  /** \brief Has CasADi been built with an external BLAS */
+  CASADI_EXPORT bool blas_available();
+
+  /** \brief Should an m-by-k times k-by-n dense product be handed to the external BLAS */
+  CASADI_EXPORT bool use_blas(casadi_int m, casadi_int n, casadi_int k);
+
+  /** \brief Inner product */
+  CASADI_EXPORT double simd_dot(casadi_int n, const double* x, const double* y);
+
+  /** \brief AXPY: y <- a*x + y */
+  CASADI_EXPORT void simd_axpy(casadi_int n, double alpha, const double* x, double* y);
+
+  /** \brief Dense matrix-vector multiplication: z <- z + x*y, or z <- z + x'*y if tr */
+  CASADI_EXPORT void simd_mv_dense(const double* x, casadi_int nrow_x, casadi_int ncol_x,
+                                   const double* y, double* z, bool tr);
+
+  /** \brief Dense matrix-matrix multiplication: z <- z + x*y
+
+      x is m-by-k, y is k-by-n and z is m-by-n, all in column-major order
+  */
+  CASADI_EXPORT void simd_gemm(casadi_int m, casadi_int n, casadi_int k,
+                               const double* x, const double* y, double* z);
+
+  /** \brief Sparse matrix-matrix multiplication: z <- z + x*y, or z <- z + x'*y if tr
+
+      Products with dense x and z are vectorized, others use casadi_mtimes.
+      w is a work vector of length at least the number of rows of z (x if tr).
+  */
+  CASADI_EXPORT void simd_mtimes(const double* x, const casadi_int* sp_x,
+                                 const double* y, const casadi_int* sp_y,
+                                 double* z, const casadi_int* sp_z, double* w, bool tr);
+  ///@}
+
+} // namespace casadi
+/// \endcond
+
+#endif // CASADI_SIMD_KERNELS_HPP
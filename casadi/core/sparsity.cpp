@@ -726,11 +726,12 @@ namespace casadi {
     (*this)->get_nz(indices);
   }
 
-  Sparsity Sparsity::uni_coloring(const Sparsity& AT, casadi_int cutoff) const {
+  Sparsity Sparsity::uni_coloring(const Sparsity& AT, casadi_int cutoff,
+                                  casadi_int ordering, casadi_int num_threads) const {
     if (AT.is_null()) {
-      return (*this)->uni_coloring(T(), cutoff);
+      return (*this)->uni_coloring(T(), cutoff, ordering, num_threads);
     } else {
-      return (*this)->uni_coloring(AT, cutoff);
+      return (*this)->uni_coloring(AT, cutoff, ordering, num_threads);
     }
   }
 
@@ -746,6 +747,11 @@ namespace casadi {
     return (*this)->largest_first();
   }
 
+  std::vector<casadi_int> Sparsity::coloring_ordering(casadi_int ordering,
+                                                      const Sparsity& AT) const {
+    return (*this)->coloring_ordering(ordering, AT);
+  }
+
   Sparsity Sparsity::pmult(const std::vector<casadi_int>& p, bool permute_rows,
                             bool permute_columns, bool invert_permutation) const {
     return (*this)->pmult(p, permute_rows, permute_columns, invert_permutation);
@@ -796,9 +796,18 @@ namespace casadi {
 #endif // SWIG
 
     /** \brief Perform a unidirectional coloring: A greedy distance-2 coloring algorithm
-        (Algorithm 3.1 in A. H. GEBREMEDHIN, F. MANNE, A. POTHEN) */
+        (Algorithm 3.1 in A. H. GEBREMEDHIN, F. MANNE, A. POTHEN)
+
+        Ordering options, with respect to the column intersection graph:
+        None (0), largest first (1), smallest last (2), incidence degree (3)
+
+        With num_threads>1, fixed-size blocks of columns are colored speculatively
+        in parallel and conflicts between blocks are resolved in additional rounds.
+        The result does not depend on the number of threads, as long as it is above one.
+    */
     Sparsity uni_coloring(const Sparsity& AT=Sparsity(),
-                          casadi_int cutoff = std::numeric_limits<casadi_int>::max()) const;
+                          casadi_int cutoff = std::numeric_limits<casadi_int>::max(),
+                          casadi_int ordering = 0, casadi_int num_threads = 1) const;
 
     /** \brief Perform a star coloring of a symmetric matrix:
         A greedy distance-2 coloring algorithm
@@ -807,7 +816,8 @@ namespace casadi {
           A. H. GEBREMEDHIN, F. MANNE, A. POTHEN
           SIAM Rev., 47(4), 629–705 (2006)
 
-        Ordering options: None (0), largest first (1)
+        Ordering options: None (0), largest first (1), smallest last (2),
+        incidence degree (3)
     */
     Sparsity star_coloring(casadi_int ordering = 1,
                             casadi_int cutoff = std::numeric_limits<casadi_int>::max()) const;
@@ -819,7 +829,8 @@ namespace casadi {
           A. H. GEBREMEDHIN, A. TARAFDAR, F. MANNE, A. POTHEN
           SIAM J. SCI. COMPUT. Vol. 29, No. 3, pp. 1042–1072 (2007)
 
-        Ordering options: None (0), largest first (1)
+        Ordering options: None (0), largest first (1), smallest last (2),
+        incidence degree (3)
     */
     Sparsity star_coloring2(casadi_int ordering = 1,
                             casadi_int cutoff = std::numeric_limits<casadi_int>::max()) const;
@@ -827,6 +838,16 @@ namespace casadi {
     /** \brief Order the columns by decreasing degree */
     std::vector<casadi_int> largest_first() const;
 
+    /** \brief Vertex ordering for graph coloring
+
+        Ordering options: None (0), largest first (1), smallest last (2),
+        incidence degree (3). If AT is given, the ordering refers to the column
+        intersection graph (distance-2), otherwise to the adjacency graph of the
+        (symmetric) pattern.
+    */
+    std::vector<casadi_int> coloring_ordering(casadi_int ordering,
+                                              const Sparsity& AT=Sparsity()) const;
+
     /** \brief Permute rows and/or columns
         Multiply the sparsity with a permutation matrix from the left and/or from the right
         P * A * trans(P), A * trans(P) or A * trans(P) with P defined by an index vector
@@ -27,6 +27,7 @@
 #include "sparsity_internal.hpp"
 #include "casadi_misc.hpp"
 #include "global_options.hpp"
+#include "thread_pool.hpp"
 #include <climits>
 #include <cstdlib>
 #include <cmath>
@@ -2899,7 +2900,89 @@ namespace casadi {
     fill(it, indices.end(), -1);
   }
 
-  Sparsity SparsityInternal::uni_coloring(const Sparsity& AT, casadi_int cutoff) const {
+  namespace {
+    // Call f(w) for each neighbor w != v of vertex v in the graph used for coloring:
+    // the column intersection graph (distance-2) if AT_colind is given, otherwise
+    // the adjacency graph of a symmetric pattern (distance-1). Duplicates are
+    // skipped if a marker vector (initialized to -1) is provided.
+    template<typename F>
+    inline void coloring_neighbors(casadi_int v, const casadi_int* colind, const casadi_int* row,
+                                   const casadi_int* AT_colind, const casadi_int* AT_row,
+                                   casadi_int* mark, F f) {
+      for (casadi_int el=colind[v]; el<colind[v+1]; ++el) {
+        casadi_int r = row[el];
+        if (AT_colind) {
+          for (casadi_int el2=AT_colind[r]; el2<AT_colind[r+1]; ++el2) {
+            casadi_int w = AT_row[el2];
+            if (w==v) continue;
+            if (mark) {
+              if (mark[w]==v) continue;
+              mark[w] = v;
+            }
+            f(w);
+          }
+        } else if (r!=v) {
+          f(r);
+        }
+      }
+    }
+
+    // Vertices in doubly linked lists, bucketed by an integer key
+    struct ColoringBuckets {
+      std::vector<casadi_int> head, next, prev, key;
+      ColoringBuckets(casadi_int n, casadi_int max_key)
+        : head(max_key+1, -1), next(n, -1), prev(n, -1), key(n, -1) {}
+      void insert(casadi_int v, casadi_int k) {
+        key[v] = k;
+        prev[v] = -1;
+        next[v] = head[k];
+        if (head[k]>=0) prev[head[k]] = v;
+        head[k] = v;
+      }
+      void remove(casadi_int v) {
+        if (prev[v]>=0) {
+          next[prev[v]] = next[v];
+        } else {
+          head[key[v]] = next[v];
+        }
+        if (next[v]>=0) prev[next[v]] = prev[v];
+      }
+    };
+
+    // Sparsity pattern with the vertices of color c in column c
+    Sparsity coloring_pattern(const std::vector<casadi_int>& color, casadi_int num_colors) {
+      // Get the number of vertices for each color
+      std::vector<casadi_int> ret_colind(num_colors+1, 0), ret_row(color.size());
+      for (casadi_int c : color) ret_colind[c+1]++;
+      // Cumsum
+      for (casadi_int j=0; j<num_colors; ++j) ret_colind[j+1] += ret_colind[j];
+      // Get vertices for each color, in increasing order
+      std::vector<casadi_int> pos(ret_colind.begin(), ret_colind.end()-1);
+      for (casadi_int j=0; j<color.size(); ++j) ret_row[pos[color[j]]++] = j;
+      return Sparsity(color.size(), num_colors, ret_colind, ret_row);
+    }
+  } // namespace
+
+  Sparsity SparsityInternal::uni_coloring(const Sparsity& AT, casadi_int cutoff,
+                                          casadi_int ordering, casadi_int num_threads) const {
+    // Reorder, if necessary
+    if (ordering!=0) {
+      // Ordering
+      vector<casadi_int> ord = coloring_ordering(ordering, AT);
+
+      // Create a new sparsity pattern with permuted columns
+      Sparsity sp_permuted = pmult(ord, false, true, true);
+
+      // Unidirectional coloring for the permuted matrix
+      Sparsity ret_permuted = sp_permuted.uni_coloring(sp_permuted.T(), cutoff, 0, num_threads);
+      if (ret_permuted.is_null()) return ret_permuted;
+
+      // Permute result back
+      return ret_permuted.pmult(ord, true, false, false);
+    }
+
+    // Parallel coloring
+    if (num_threads>1) return uni_coloring_parallel(AT, cutoff, num_threads);
 
     // Allocate temporary vectors
     vector<casadi_int> forbiddenColors;
@@ -2958,34 +3041,107 @@ namespace casadi {
       }
     }
 
-    // Create return sparsity containing the coloring
-    vector<casadi_int> ret_colind(forbiddenColors.size()+1, 0), ret_row;
+    // Return the coloring
+    return coloring_pattern(color, forbiddenColors.size());
+  }
 
-    // Get the number of rows for each col
-    for (casadi_int i=0; i<color.size(); ++i) {
-      ret_colind[color[i]+1]++;
-    }
+  Sparsity SparsityInternal::uni_coloring_parallel(const Sparsity& AT, casadi_int cutoff,
+                                                   casadi_int num_threads) const {
+    // Columns per block, independent of the number of threads for reproducibility
+    const casadi_int block_size = 512;
 
-    // Cumsum
-    for (casadi_int j=0; j<forbiddenColors.size(); ++j) {
-      ret_colind[j+1] += ret_colind[j];
-    }
+    // Access the sparsity of the matrix and its transpose
+    const casadi_int* colind = this->colind();
+    const casadi_int* row = this->row();
+    const casadi_int* AT_colind = AT.colind();
+    const casadi_int* AT_row = AT.row();
 
-    // Get row for each col
-    ret_row.resize(color.size());
-    for (casadi_int j=0; j<ret_row.size(); ++j) {
-      ret_row[ret_colind[color[j]]++] = j;
-    }
+    // Color and block of each column, the block is -1 for columns with final colors
+    vector<casadi_int> color(size2(), -1), block(size2(), -1);
+
+    // Forbidden colors, for each worker
+    vector< vector<casadi_int> > forbiddenColors(num_threads);
 
-    // Swap index back one step
-    for (casadi_int j=ret_colind.size()-2; j>=0; --j) {
-      ret_colind[j+1] = ret_colind[j];
+    // Columns to be colored in the current round
+    vector<casadi_int> work = range(size2()), next;
+    vector<char> conflict;
+
+    // Offset making forbidden color markers unique across rounds
+    casadi_int offset = 0;
+
+    // Number of colors used by columns with final colors
+    casadi_int num_colors = 0;
+
+    while (!work.empty()) {
+      casadi_int n_work = work.size();
+      casadi_int n_block = (n_work+block_size-1)/block_size;
+      for (casadi_int k=0; k<n_work; ++k) {
+        block[work[k]] = k/block_size;
+        color[work[k]] = -1;
+      }
+
+      // Greedy coloring of each block, ignoring columns in other blocks
+      ThreadPool::instance().run(n_block, num_threads,
+        [&](casadi_int w, casadi_int b) {
+          vector<casadi_int>& fc = forbiddenColors[w];
+          casadi_int k_end = min(n_work, (b+1)*block_size);
+          for (casadi_int k=b*block_size; k<k_end; ++k) {
+            casadi_int v = work[k], marker = offset+k;
+            coloring_neighbors(v, colind, row, AT_colind, AT_row, nullptr,
+              [&](casadi_int u) {
+                if (block[u]>=0 && block[u]!=b) return;
+                casadi_int cu = color[u];
+                if (cu<0) return;
+                if (cu>=fc.size()) fc.resize(cu+1, -1);
+                fc[cu] = marker;
+              });
+            // Get the first nonforbidden color
+            casadi_int c;
+            for (c=0; c<fc.size(); ++c) {
+              if (fc[c]!=marker) break;
+            }
+            if (c==fc.size()) fc.push_back(-1);
+            color[v] = c;
+          }
+        }, 1);
+
+      // Detect conflicts with lower-numbered columns in other blocks
+      conflict.resize(n_work);
+      ThreadPool::instance().run(n_block, num_threads,
+        [&](casadi_int w, casadi_int b) {
+          casadi_int k_end = min(n_work, (b+1)*block_size);
+          for (casadi_int k=b*block_size; k<k_end; ++k) {
+            casadi_int v = work[k];
+            bool c = false;
+            coloring_neighbors(v, colind, row, AT_colind, AT_row, nullptr,
+              [&](casadi_int u) {
+                if (u<v && block[u]>=0 && block[u]!=b && color[u]==color[v]) c = true;
+              });
+            conflict[k] = c;
+          }
+        }, 1);
+
+      // Fix colors without conflicts, recolor the rest
+      next.clear();
+      for (casadi_int k=0; k<n_work; ++k) {
+        casadi_int v = work[k];
+        if (conflict[k]) {
+          next.push_back(v);
+        } else {
+          block[v] = -1;
+          num_colors = max(num_colors, color[v]+1);
+        }
+      }
+
+      // Cutoff if too many colors
+      if (num_colors>cutoff) return Sparsity();
+
+      offset += n_work;
+      work.swap(next);
     }
-    ret_colind[0] = 0;
 
     // Return the coloring
-    return Sparsity(size2(), forbiddenColors.size(), ret_colind, ret_row);
-;
+    return coloring_pattern(color, num_colors);
   }
 
   Sparsity SparsityInternal::star_coloring2(casadi_int ordering, casadi_int cutoff) const {
@@ -2999,16 +3155,15 @@ namespace casadi {
     const casadi_int* colind = this->colind();
     const casadi_int* row = this->row();
     if (ordering!=0) {
-      casadi_assert_dev(ordering==1);
-
       // Ordering
-      vector<casadi_int> ord = largest_first();
+      vector<casadi_int> ord = coloring_ordering(ordering, Sparsity());
 
       // Create a new sparsity pattern
       Sparsity sp_permuted = pmult(ord, true, true, true);
 
       // Star coloring for the permuted matrix
-      Sparsity ret_permuted = sp_permuted.star_coloring2(0);
+      Sparsity ret_permuted = sp_permuted.star_coloring2(0, cutoff);
+      if (ret_permuted.is_null()) return ret_permuted;
 
       // Permute result back
       return ret_permuted.pmult(ord, true, false, false);
@@ -3212,33 +3367,8 @@ namespace casadi {
 
     }
 
-    // Create return sparsity containing the coloring
-    vector<casadi_int> ret_colind(forbiddenColors.size()+1, 0), ret_row;
-
-    // Get the number of rows for each col
-    for (casadi_int i=0; i<color.size(); ++i) {
-      ret_colind[color[i]+1]++;
-    }
-
-    // Cumsum
-    for (casadi_int j=0; j<forbiddenColors.size(); ++j) {
-      ret_colind[j+1] += ret_colind[j];
-    }
-
-    // Get row for each col
-    ret_row.resize(color.size());
-    for (casadi_int j=0; j<ret_row.size(); ++j) {
-      ret_row[ret_colind[color[j]]++] = j;
-    }
-
-    // Swap index back one step
-    for (casadi_int j=ret_colind.size()-2; j>=0; --j) {
-      ret_colind[j+1] = ret_colind[j];
-    }
-    ret_colind[0] = 0;
-
     // Return the coloring
-    return Sparsity(size2(), forbiddenColors.size(), ret_colind, ret_row);
+    return coloring_pattern(color, forbiddenColors.size());
   }
 
   Sparsity SparsityInternal::star_coloring(casadi_int ordering, casadi_int cutoff) const {
@@ -3249,16 +3379,15 @@ namespace casadi {
 
     // Reorder, if necessary
     if (ordering!=0) {
-      casadi_assert_dev(ordering==1);
-
       // Ordering
-      vector<casadi_int> ord = largest_first();
+      vector<casadi_int> ord = coloring_ordering(ordering, Sparsity());
 
       // Create a new sparsity pattern
       Sparsity sp_permuted = pmult(ord, true, true, true);
 
       // Star coloring for the permuted matrix
-      Sparsity ret_permuted = sp_permuted.star_coloring(0);
+      Sparsity ret_permuted = sp_permuted.star_coloring(0, cutoff);
+      if (ret_permuted.is_null()) return ret_permuted;
 
       // Permute result back
       return ret_permuted.pmult(ord, true, false, false);
@@ -3350,8 +3479,8 @@ namespace casadi {
     // Number of colors used
     casadi_int num_colors = forbiddenColors.size();
 
-    // Return sparsity in sparse triplet format
-    return Sparsity::triplet(size2(), num_colors, range(color.size()), color);
+    // Return the coloring
+    return coloring_pattern(color, num_colors);
   }
 
   std::vector<casadi_int> SparsityInternal::largest_first() const {
@@ -3389,6 +3518,89 @@ namespace casadi {
     return reverse_ordering;
   }
 
+  std::vector<casadi_int> SparsityInternal::
+  coloring_ordering(casadi_int ordering, const Sparsity& AT) const {
+    casadi_int n = size2();
+    const casadi_int* colind = this->colind();
+    const casadi_int* row = this->row();
+    const casadi_int* AT_colind = AT.is_null() ? nullptr : AT.colind();
+    const casadi_int* AT_row = AT.is_null() ? nullptr : AT.row();
+
+    // Natural ordering
+    if (ordering==0) return range(n);
+    casadi_assert(ordering>=1 && ordering<=3,
+      "Coloring ordering must be none (0), largest first (1), smallest last (2) "
+      "or incidence degree (3), got " + str(ordering) + ".");
+
+    // Largest first with respect to the adjacency graph
+    if (ordering==1 && !AT_colind) return largest_first();
+
+    // Marker for visited neighbors
+    vector<casadi_int> mark(n, -1);
+    vector<casadi_int> ord(n);
+
+    if (ordering==3) {
+      // Incidence degree: next is the vertex with most already ordered neighbors
+      ColoringBuckets b(n, n);
+      for (casadi_int v=n-1; v>=0; --v) b.insert(v, 0);
+      vector<bool> ordered(n, false);
+      casadi_int max_key = 0;
+      for (casadi_int k=0; k<n; ++k) {
+        while (b.head[max_key]<0) max_key--;
+        casadi_int v = b.head[max_key];
+        b.remove(v);
+        ordered[v] = true;
+        ord[k] = v;
+        coloring_neighbors(v, colind, row, AT_colind, AT_row, get_ptr(mark),
+          [&](casadi_int w) {
+            if (ordered[w]) return;
+            b.remove(w);
+            b.insert(w, b.key[w]+1);
+            max_key = max(max_key, b.key[w]);
+          });
+      }
+      return ord;
+    }
+
+    // Degree of each vertex
+    vector<casadi_int> degree(n, 0);
+    for (casadi_int v=0; v<n; ++v) {
+      coloring_neighbors(v, colind, row, AT_colind, AT_row, get_ptr(mark),
+        [&](casadi_int) { degree[v]++; });
+    }
+
+    if (ordering==1) {
+      // Largest first: bucket sort by decreasing degree
+      vector<casadi_int> degree_count(n+1, 0);
+      for (casadi_int v=0; v<n; ++v) degree_count[n-1-degree[v]+1]++;
+      for (casadi_int d=0; d<n; ++d) degree_count[d+1] += degree_count[d];
+      for (casadi_int v=0; v<n; ++v) ord[degree_count[n-1-degree[v]]++] = v;
+      return ord;
+    }
+
+    // Smallest last: repeatedly remove a vertex of minimum degree, order reversed
+    ColoringBuckets b(n, n);
+    for (casadi_int v=n-1; v>=0; --v) b.insert(v, degree[v]);
+    vector<bool> removed(n, false);
+    fill(mark.begin(), mark.end(), -1);
+    casadi_int min_key = 0;
+    for (casadi_int k=n-1; k>=0; --k) {
+      while (b.head[min_key]<0) min_key++;
+      casadi_int v = b.head[min_key];
+      b.remove(v);
+      removed[v] = true;
+      ord[k] = v;
+      coloring_neighbors(v, colind, row, AT_colind, AT_row, get_ptr(mark),
+        [&](casadi_int w) {
+          if (removed[w]) return;
+          b.remove(w);
+          b.insert(w, b.key[w]-1);
+        });
+      if (min_key>0) min_key--;
+    }
+    return ord;
+  }
+
   Sparsity SparsityInternal::pmult(const std::vector<casadi_int>& p, bool permute_rows,
                                    bool permute_columns, bool invert_permutation) const {
     // Invert p, possibly
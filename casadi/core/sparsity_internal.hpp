@@ -587,7 +587,17 @@ namespace casadi {
      * A greedy distance-2 coloring algorithm
      * (Algorithm 3.1 in A. H. GEBREMEDHIN, F. MANNE, A. POTHEN)
      */
-    Sparsity uni_coloring(const Sparsity& AT, casadi_int cutoff) const;
+    Sparsity uni_coloring(const Sparsity& AT, casadi_int cutoff,
+                          casadi_int ordering, casadi_int num_threads) const;
+
+    /** \brief Speculative parallel variant of the unidirectional coloring
+     *
+     * Blocks of columns are colored concurrently, considering only colors
+     * that are final or belong to the same block. Columns that conflict with
+     * a lower-numbered column in another block are recolored in the next round.
+     */
+    Sparsity uni_coloring_parallel(const Sparsity& AT, casadi_int cutoff,
+                                   casadi_int num_threads) const;
 
     /** \brief A greedy distance-2 coloring algorithm
      * See description in public class.
@@ -602,6 +612,9 @@ namespace casadi {
     /// Order the columns by decreasing degree
     std::vector<casadi_int> largest_first() const;
 
+    /// Vertex ordering for graph coloring, see description in public class
+    std::vector<casadi_int> coloring_ordering(casadi_int ordering, const Sparsity& AT) const;
+
     /// Permute rows and/or columns
     Sparsity pmult(const std::vector<casadi_int>& p, bool permute_rows=true, bool permute_cols=true,
                    bool invert_permutation=false) const;
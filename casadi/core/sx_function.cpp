@@ -30,6 +30,8 @@
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <cstring>
+#include <unordered_map>
 #include "casadi_misc.hpp"
 #include "sx_node.hpp"
 #include "casadi_common.hpp"
@@ -53,6 +55,9 @@ namespace casadi {
     // Default (persistent) options
     just_in_time_opencl_ = false;
     just_in_time_sparsity_ = false;
+    compact_tape_ = false;
+    precision_ = PRECISION_DOUBLE;
+    precision_check_ = false;
   }
 
   SXFunction::~SXFunction() {
@@ -71,6 +76,21 @@ namespace casadi {
                    + str(free_vars_) + " are free.");
     }
 
+    // Evaluate in reduced precision, if requested
+    if (precision_check_) {
+      eval_precision_check(arg, res, w, static_cast<SXFunctionMemory*>(mem));
+      return 0;
+    } else if (precision_==PRECISION_SINGLE) {
+      eval_precision<float, float>(arg, res, reinterpret_cast<float*>(w));
+      return 0;
+    } else if (precision_==PRECISION_MIXED) {
+      eval_precision<float, double>(arg, res, reinterpret_cast<float*>(w));
+      return 0;
+    }
+
+    // Evaluate the compact bytecode, if requested
+    if (compact_tape_) return eval_bytecode(arg, res, w);
+
     // NOTE: The implementation of this function is very delicate. Small changes in the
     // class structure can cause large performance losses. For this reason,
     // the preprocessor macros are used below
@@ -90,6 +110,364 @@ namespace casadi {
     return 0;
   }
 
+  template<typename S, typename C>
+  void SXFunction::eval_precision(const double** arg, double** res, S* w) const {
+    for (auto&& e : algorithm_) {
+      switch (e.op) {
+      case OP_CONST: w[e.i0] = static_cast<S>(e.d); break;
+      case OP_INPUT: w[e.i0] = arg[e.i1]==nullptr ? 0 : static_cast<S>(arg[e.i1][e.i2]); break;
+      case OP_OUTPUT: if (res[e.i0]!=nullptr) res[e.i0][e.i2] = w[e.i1]; break;
+      default:
+        {
+          // Operate in C, store the result as S
+          C x = w[e.i1], y = w[e.i2], f;
+          switch (e.op) {
+            CASADI_MATH_FUN_BUILTIN(x, y, f)
+          default:
+            casadi_error("Unknown operation" + str(e.op));
+          }
+          w[e.i0] = static_cast<S>(f);
+        }
+      }
+    }
+  }
+
+  void SXFunction::eval_precision_check(const double** arg, double** res, double* w,
+                                        SXFunctionMemory* m) const {
+    // Results in reduced precision and in double precision
+    double** res_red = res + n_out_;
+    double** res_ref = res_red + n_out_;
+    double* r = w + worksize_;
+    for (casadi_int i=0; i<n_out_; ++i) {
+      res_red[i] = r;
+      r += nnz_out(i);
+    }
+    for (casadi_int i=0; i<n_out_; ++i) {
+      res_ref[i] = r;
+      r += nnz_out(i);
+    }
+    if (precision_==PRECISION_MIXED) {
+      eval_precision<float, double>(arg, res_red, reinterpret_cast<float*>(w));
+    } else {
+      eval_precision<float, float>(arg, res_red, reinterpret_cast<float*>(w));
+    }
+    eval_precision<double, double>(arg, res_ref, w);
+
+    for (casadi_int i=0; i<n_out_; ++i) {
+      // Largest relative deviation, absolute where the double precision result is zero
+      double dev = 0;
+      for (casadi_int k=0; k<nnz_out(i); ++k) {
+        double d = fabs(res_red[i][k] - res_ref[i][k]);
+        if (res_ref[i][k]!=0) d /= fabs(res_ref[i][k]);
+        if (!(d<=dev)) dev = d==d ? d : inf;
+      }
+      m->dev[i] = dev;
+      m->dev_max[i] = std::max(m->dev_max[i], dev);
+      // Return the result in the selected precision
+      if (res[i]) {
+        std::copy_n(precision_==PRECISION_DOUBLE ? res_ref[i] : res_red[i], nnz_out(i), res[i]);
+      }
+    }
+  }
+
+  int SXFunction::init_mem(void* mem) const {
+    if (XFunction<SXFunction, SX, SXNode>::init_mem(mem)) return 1;
+    auto m = static_cast<SXFunctionMemory*>(mem);
+    m->dev.resize(n_out_, 0);
+    m->dev_max.resize(n_out_, 0);
+    return 0;
+  }
+
+  Dict SXFunction::get_stats(void* mem) const {
+    Dict stats = XFunction::get_stats(mem);
+    auto m = static_cast<SXFunctionMemory*>(mem);
+    if (precision_check_) {
+      stats["precision_deviation"] = m->dev;
+      stats["precision_deviation_max"] = m->dev_max;
+    }
+    return stats;
+  }
+
+  const casadi_int SXFunction::batch_size;
+
+  bool SXFunction::has_eval_batch() const {
+    // Not when evaluation has been redirected or has side effects
+    return free_vars_.empty() && eval_==nullptr && !verbose_
+      && precision_==PRECISION_DOUBLE && !precision_check_
+      && !print_in_ && !print_out_ && !dump_in_ && !dump_out_ && !dump_;
+  }
+
+  int SXFunction::eval_batch(const double** arg, double** res, double* w,
+      casadi_int n) const {
+    casadi_assert_dev(n>=0 && n<=batch_size);
+
+    // Evaluate the algorithm, one instruction for all points at a time
+    for (auto&& e : algorithm_) {
+      switch (e.op) {
+      case OP_CONST:
+        std::fill_n(w + e.i0*batch_size, n, e.d);
+        break;
+      case OP_INPUT:
+        {
+          double* f = w + e.i0*batch_size;
+          const double* a = arg[e.i1];
+          if (a==nullptr) {
+            std::fill_n(f, n, 0.);
+          } else {
+            casadi_int stride = nnz_in(e.i1);
+            a += e.i2;
+            for (casadi_int k=0; k<n; ++k) f[k] = a[k*stride];
+          }
+        }
+        break;
+      case OP_OUTPUT:
+        if (res[e.i0]!=nullptr) {
+          const double* x = w + e.i1*batch_size;
+          double* r = res[e.i0] + e.i2;
+          casadi_int stride = nnz_out(e.i0);
+          for (casadi_int k=0; k<n; ++k) r[k*stride] = x[k];
+        }
+        break;
+      default:
+        casadi_math<double>::fun(e.op, w + e.i1*batch_size, w + e.i2*batch_size,
+                                 w + e.i0*batch_size, n);
+      }
+    }
+    return 0;
+  }
+
+  // Unary operations of the bytecode virtual machine
+#define CASADI_BYTECODE_UNARY(F) \
+  F(OP_ASSIGN) F(OP_NEG) F(OP_EXP) F(OP_LOG) F(OP_SQRT) F(OP_SQ) F(OP_TWICE) \
+  F(OP_SIN) F(OP_COS) F(OP_TAN) F(OP_ASIN) F(OP_ACOS) F(OP_ATAN) \
+  F(OP_FLOOR) F(OP_CEIL) F(OP_NOT) F(OP_ERF) F(OP_FABS) F(OP_SIGN) F(OP_INV) \
+  F(OP_SINH) F(OP_COSH) F(OP_TANH) F(OP_ASINH) F(OP_ACOSH) F(OP_ATANH) F(OP_ERFINV)
+
+  // Binary operations of the bytecode virtual machine
+#define CASADI_BYTECODE_BINARY(F) \
+  F(OP_ADD) F(OP_SUB) F(OP_MUL) F(OP_DIV) F(OP_POW) F(OP_CONSTPOW) \
+  F(OP_LT) F(OP_LE) F(OP_EQ) F(OP_NE) F(OP_AND) F(OP_OR) F(OP_IF_ELSE_ZERO) \
+  F(OP_COPYSIGN) F(OP_FMOD) F(OP_FMIN) F(OP_FMAX) F(OP_ATAN2) F(OP_PRINTME) F(OP_LIFT)
+
+  // Remaining instructions of the bytecode virtual machine
+#define CASADI_BYTECODE_OTHER(F) \
+  F(CONST)       /* [op, i0, k]: w[i0] = c[k] */ \
+  F(INPUT)       /* [op, i0, i1, i2]: w[i0] = arg[i1] ? arg[i1][i2] : 0 */ \
+  F(OUTPUT)      /* [op, i0, i1, i2]: if (res[i0]) res[i0][i2] = w[i1] */ \
+  F(FMA)         /* [op, i0, i1, i2, i3]: w[i0] = w[i1]*w[i2] + w[i3] */ \
+  F(ADD_C)       /* [op, i0, i1, k]: w[i0] = w[i1] + c[k] */ \
+  F(SUB_C)       /* [op, i0, i1, k]: w[i0] = w[i1] - c[k] */ \
+  F(C_SUB)       /* [op, i0, i1, k]: w[i0] = c[k] - w[i1] */ \
+  F(MUL_C)       /* [op, i0, i1, k]: w[i0] = w[i1] * c[k] */ \
+  F(DIV_C)       /* [op, i0, i1, k]: w[i0] = w[i1] / c[k] */ \
+  F(C_DIV)       /* [op, i0, i1, k]: w[i0] = c[k] / w[i1] */ \
+  F(UNARY_BINARY) /* [op, uop, bop, i0, i1, i2]: w[i0] = uop(bop(w[i1], w[i2])) */ \
+  F(END)         /* [op]: end of bytecode */
+
+  // Opcodes of the bytecode virtual machine
+  enum BytecodeOp {
+#define CASADI_BYTECODE_ENUM(OP) BC_##OP,
+    CASADI_BYTECODE_UNARY(CASADI_BYTECODE_ENUM)
+    CASADI_BYTECODE_BINARY(CASADI_BYTECODE_ENUM)
+    CASADI_BYTECODE_OTHER(CASADI_BYTECODE_ENUM)
+#undef CASADI_BYTECODE_ENUM
+    BC_NUM_OPS
+  };
+
+  // Bytecode opcode corresponding to a builtin operation
+  static int bytecode_op(int op) {
+    switch (op) {
+#define CASADI_BYTECODE_CASE(OP) case OP: return BC_##OP;
+      CASADI_BYTECODE_UNARY(CASADI_BYTECODE_CASE)
+      CASADI_BYTECODE_BINARY(CASADI_BYTECODE_CASE)
+#undef CASADI_BYTECODE_CASE
+      case OP_CONST: return BC_CONST;
+      case OP_INPUT: return BC_INPUT;
+      case OP_OUTPUT: return BC_OUTPUT;
+      default: casadi_error("Operation " + str(op) + " not supported in bytecode");
+    }
+    return -1;
+  }
+
+  void SXFunction::init_bytecode() {
+    casadi_int n_alg = algorithm_.size();
+
+    // Instruction that last wrote to each work vector location
+    std::vector<casadi_int> writer(worksize_, -1);
+
+    // For each instruction, the instructions that produced its operands
+    std::vector<casadi_int> dep1(n_alg, -1), dep2(n_alg, -1);
+
+    // Number of times the result of each instruction is read
+    std::vector<casadi_int> n_read(n_alg, 0);
+    for (casadi_int k=0; k<n_alg; ++k) {
+      const AlgEl& e = algorithm_[k];
+      if (e.op==OP_OUTPUT) {
+        dep1[k] = writer.at(e.i1);
+      } else if (e.op!=OP_CONST && e.op!=OP_INPUT) {
+        casadi_int ndeps = casadi_math<double>::ndeps(e.op);
+        if (ndeps>=1) dep1[k] = writer.at(e.i1);
+        if (ndeps==2) dep2[k] = writer.at(e.i2);
+      }
+      if (dep1[k]>=0) n_read[dep1[k]]++;
+      if (dep2[k]>=0) n_read[dep2[k]]++;
+      if (e.op!=OP_OUTPUT) writer.at(e.i0) = k;
+    }
+
+    // Instructions fused with the following instruction
+    std::vector<bool> fused(n_alg, false);
+    for (casadi_int k=0; k+1<n_alg; ++k) {
+      const AlgEl& e = algorithm_[k];
+      if (n_read[k]!=1 || !casadi_math<double>::is_binary(e.op)) continue;
+      const AlgEl& e_next = algorithm_[k+1];
+      if (e.op==OP_MUL && e_next.op==OP_ADD && (dep1[k+1]==k || dep2[k+1]==k)) {
+        // Multiply-add
+        fused[k++] = true;
+      } else if (casadi_math<double>::is_unary(e_next.op) && dep1[k+1]==k) {
+        // Unary operation of a binary operation
+        fused[k++] = true;
+      }
+    }
+
+    // Binary operations with a constant operand (1: second, 2: first)
+    std::vector<int> const_arg(n_alg, 0);
+    // Number of times the result of each constant is absorbed as a constant operand
+    std::vector<casadi_int> n_absorbed(n_alg, 0);
+    for (casadi_int k=0; k<n_alg; ++k) {
+      const AlgEl& e = algorithm_[k];
+      if (e.op!=OP_ADD && e.op!=OP_SUB && e.op!=OP_MUL && e.op!=OP_DIV) continue;
+      if (fused[k] || (k>0 && fused[k-1])) continue;
+      if (algorithm_[dep2[k]].op==OP_CONST) {
+        const_arg[k] = 1;
+        n_absorbed[dep2[k]]++;
+      } else if (algorithm_[dep1[k]].op==OP_CONST) {
+        const_arg[k] = 2;
+        n_absorbed[dep1[k]]++;
+      }
+    }
+
+    // Generate bytecode
+    bytecode_.clear();
+    bytecode_constants_.clear();
+    std::vector<int> const_ind(n_alg, -1);
+    for (casadi_int k=0; k<n_alg; ++k) {
+      const AlgEl& e = algorithm_[k];
+      if (e.op==OP_CONST) {
+        const_ind[k] = bytecode_constants_.size();
+        bytecode_constants_.push_back(e.d);
+        // Skip if all uses refer to the constant directly
+        if (n_absorbed[k]==n_read[k]) continue;
+        bytecode_.insert(bytecode_.end(), {BC_CONST, e.i0, const_ind[k]});
+      } else if (e.op==OP_INPUT || e.op==OP_OUTPUT) {
+        bytecode_.insert(bytecode_.end(), {bytecode_op(e.op), e.i0, e.i1, e.i2});
+      } else if (fused[k]) {
+        const AlgEl& e_next = algorithm_[++k];
+        if (e_next.op==OP_ADD) {
+          int i3 = dep1[k]==k-1 ? e_next.i2 : e_next.i1;
+          bytecode_.insert(bytecode_.end(), {BC_FMA, e_next.i0, e.i1, e.i2, i3});
+        } else {
+          bytecode_.insert(bytecode_.end(),
+            {BC_UNARY_BINARY, e_next.op, e.op, e_next.i0, e.i1, e.i2});
+        }
+      } else if (const_arg[k]==1) {
+        int op = e.op==OP_ADD ? BC_ADD_C : e.op==OP_SUB ? BC_SUB_C :
+                 e.op==OP_MUL ? BC_MUL_C : BC_DIV_C;
+        bytecode_.insert(bytecode_.end(), {op, e.i0, e.i1, const_ind[dep2[k]]});
+      } else if (const_arg[k]==2) {
+        int op = e.op==OP_ADD ? BC_ADD_C : e.op==OP_SUB ? BC_C_SUB :
+                 e.op==OP_MUL ? BC_MUL_C : BC_C_DIV;
+        bytecode_.insert(bytecode_.end(), {op, e.i0, e.i2, const_ind[dep1[k]]});
+      } else if (casadi_math<double>::is_binary(e.op)) {
+        bytecode_.insert(bytecode_.end(), {bytecode_op(e.op), e.i0, e.i1, e.i2});
+      } else {
+        bytecode_.insert(bytecode_.end(), {bytecode_op(e.op), e.i0, e.i1});
+      }
+    }
+    bytecode_.push_back(BC_END);
+
+    if (verbose_) {
+      casadi_message("Bytecode: " + str(bytecode_.size()) + " words for "
+                     + str(n_alg) + " elementary operations");
+    }
+  }
+
+  int SXFunction::eval_bytecode(const double** arg, double** res, double* w) const {
+    const int* p = get_ptr(bytecode_);
+    const double* c = get_ptr(bytecode_constants_);
+    double t;
+
+    // NOTE: As for eval, preprocessor macros are used to keep the dispatch tight
+#if defined(__GNUC__) && !defined(SWIG)
+    // Direct threading: each instruction jumps straight to the next handler
+    static const void* const labels[BC_NUM_OPS] = {
+#define CASADI_BYTECODE_LABEL(OP) &&L_BC_##OP,
+      CASADI_BYTECODE_UNARY(CASADI_BYTECODE_LABEL)
+      CASADI_BYTECODE_BINARY(CASADI_BYTECODE_LABEL)
+      CASADI_BYTECODE_OTHER(CASADI_BYTECODE_LABEL)
+#undef CASADI_BYTECODE_LABEL
+    };
+#define CASADI_BYTECODE_TARGET(OP) L_BC_##OP:
+#define CASADI_BYTECODE_NEXT goto *labels[*p]
+    CASADI_BYTECODE_NEXT;
+#else // __GNUC__
+#define CASADI_BYTECODE_TARGET(OP) case BC_##OP:
+#define CASADI_BYTECODE_NEXT continue
+    for (;;) switch (*p) {
+#endif // __GNUC__
+
+#define CASADI_BYTECODE_UNARY_HANDLER(OP) \
+    CASADI_BYTECODE_TARGET(OP) \
+      BinaryOperation<OP>::fcn(w[p[2]], w[p[2]], w[p[1]]); p += 3; CASADI_BYTECODE_NEXT;
+      CASADI_BYTECODE_UNARY(CASADI_BYTECODE_UNARY_HANDLER)
+#undef CASADI_BYTECODE_UNARY_HANDLER
+
+#define CASADI_BYTECODE_BINARY_HANDLER(OP) \
+    CASADI_BYTECODE_TARGET(OP) \
+      BinaryOperation<OP>::fcn(w[p[2]], w[p[3]], w[p[1]]); p += 4; CASADI_BYTECODE_NEXT;
+      CASADI_BYTECODE_BINARY(CASADI_BYTECODE_BINARY_HANDLER)
+#undef CASADI_BYTECODE_BINARY_HANDLER
+
+    CASADI_BYTECODE_TARGET(CONST)
+      w[p[1]] = c[p[2]]; p += 3; CASADI_BYTECODE_NEXT;
+    CASADI_BYTECODE_TARGET(INPUT)
+      w[p[1]] = arg[p[2]]==nullptr ? 0 : arg[p[2]][p[3]]; p += 4; CASADI_BYTECODE_NEXT;
+    CASADI_BYTECODE_TARGET(OUTPUT)
+      if (res[p[1]]!=nullptr) res[p[1]][p[3]] = w[p[2]];
+      p += 4; CASADI_BYTECODE_NEXT;
+    CASADI_BYTECODE_TARGET(FMA)
+      w[p[1]] = w[p[2]]*w[p[3]] + w[p[4]]; p += 5; CASADI_BYTECODE_NEXT;
+    CASADI_BYTECODE_TARGET(ADD_C)
+      w[p[1]] = w[p[2]] + c[p[3]]; p += 4; CASADI_BYTECODE_NEXT;
+    CASADI_BYTECODE_TARGET(SUB_C)
+      w[p[1]] = w[p[2]] - c[p[3]]; p += 4; CASADI_BYTECODE_NEXT;
+    CASADI_BYTECODE_TARGET(C_SUB)
+      w[p[1]] = c[p[3]] - w[p[2]]; p += 4; CASADI_BYTECODE_NEXT;
+    CASADI_BYTECODE_TARGET(MUL_C)
+      w[p[1]] = w[p[2]] * c[p[3]]; p += 4; CASADI_BYTECODE_NEXT;
+    CASADI_BYTECODE_TARGET(DIV_C)
+      w[p[1]] = w[p[2]] / c[p[3]]; p += 4; CASADI_BYTECODE_NEXT;
+    CASADI_BYTECODE_TARGET(C_DIV)
+      w[p[1]] = c[p[3]] / w[p[2]]; p += 4; CASADI_BYTECODE_NEXT;
+    CASADI_BYTECODE_TARGET(UNARY_BINARY)
+      switch (p[2]) {
+        CASADI_MATH_FUN_BUILTIN(w[p[4]], w[p[5]], t)
+      }
+      switch (p[1]) {
+        CASADI_MATH_FUN_BUILTIN(t, t, w[p[3]])
+      }
+      p += 6; CASADI_BYTECODE_NEXT;
+    CASADI_BYTECODE_TARGET(END)
+      return 0;
+#if !defined(__GNUC__) || defined(SWIG)
+    default:
+      casadi_error("Corrupt bytecode");
+    }
+#endif // __GNUC__
+#undef CASADI_BYTECODE_TARGET
+#undef CASADI_BYTECODE_NEXT
+    return 0;
+  }
+
   bool SXFunction::is_smooth() const {
     // Go through all nodes and check if any node is non-smooth
     for (auto&& a : algorithm_) {
@@ -151,33 +529,301 @@ namespace casadi {
   }
 
   void SXFunction::codegen_body(CodeGenerator& g) const {
+    CodegenDataFlow df;
+    codegen_data_flow(df);
+    std::vector<bool> in_w(worksize_, true);
+    codegen_range(g, df, 0, n_instructions(), in_w);
+  }
 
-    // Run the algorithm
-    for (auto&& a : algorithm_) {
-      if (a.op==OP_OUTPUT) {
-        g << "if (res[" << a.i0 << "]!=0) "
-          << g.res(a.i0) << "[" << a.i2 << "]=" << g.sx_work(a.i1);
-      } else {
+  // Number of work vector elements read by an instruction
+  static casadi_int codegen_n_read(const ScalarAtomic& a) {
+    if (a.op==OP_OUTPUT) return 1;
+    if (a.op==OP_CONST || a.op==OP_INPUT) return 0;
+    return casadi_math<double>::ndeps(a.op);
+  }
 
-        // Where to store the result
-        g << g.sx_work(a.i0) << "=";
+  void SXFunction::codegen_data_flow(CodegenDataFlow& df) const {
+    casadi_int n = n_instructions();
+    df.dep1.assign(n, -1);
+    df.dep2.assign(n, -1);
+    df.first_use.assign(n, -1);
+    df.last_use.assign(n, -1);
+    // Instruction that last assigned each work vector element
+    std::vector<casadi_int> def(worksize_, -1);
+    for (casadi_int k=0; k<n; ++k) {
+      const AlgEl& a = algorithm_[k];
+      casadi_int ndep = codegen_n_read(a);
+      for (casadi_int i=0; i<ndep; ++i) {
+        casadi_int d = def[i==0 ? a.i1 : a.i2];
+        (i==0 ? df.dep1 : df.dep2)[k] = d;
+        if (d<0) continue;
+        if (df.first_use[d]<0) df.first_use[d] = k;
+        df.last_use[d] = k;
+      }
+      if (a.op!=OP_OUTPUT) def[a.i0] = k;
+    }
+  }
+
+  void SXFunction::codegen_range(CodeGenerator& g, const CodegenDataFlow& df,
+                                 casadi_int begin, casadi_int end,
+                                 std::vector<bool>& in_w) const {
+    bool avoid_stack = g.avoid_stack();
+
+    // Read a work vector element, from a local variable if available
+    auto work = [&](casadi_int i) -> std::string {
+      if (avoid_stack || in_w[i]) return "w[" + str(i) + "]";
+      return g.sx_work(i);
+    };
+
+    // Window length for locating candidate loops, minimum number of rolled instructions
+    const casadi_int win = 8, min_rolled = 16;
+
+    // Hash of the instruction sequence starting at each position
+    std::vector<size_t> seq_hash;
+    std::unordered_map<size_t, std::vector<casadi_int> > seq_pos;
+    if (g.roll_loops && end-begin>=min_rolled) {
+      std::vector<size_t> h(end-begin);
+      for (casadi_int k=begin; k<end; ++k) {
+        const AlgEl& a = algorithm_[k];
+        size_t& hk = h[k-begin];
+        hk = a.op;
+        if (a.op==OP_CONST) hash_combine(hk, std::hash<double>()(a.d));
+        if (a.op==OP_INPUT) hash_combine(hk, a.i1);
+        if (a.op==OP_OUTPUT) hash_combine(hk, a.i0);
+        // Relative position of nearby arguments
+        for (casadi_int i=0; i<codegen_n_read(a); ++i) {
+          casadi_int d = i==0 ? df.dep1[k] : df.dep2[k];
+          hash_combine(hk, d>=0 && k-d<win ? k-d : 0);
+        }
+      }
+      seq_hash.resize(end-begin-win+1);
+      for (casadi_int k=0; k<seq_hash.size(); ++k) {
+        seq_hash[k] = 0;
+        for (casadi_int j=0; j<win; ++j) hash_combine(seq_hash[k], h[k+j]);
+        seq_pos[seq_hash[k]].push_back(begin+k);
+      }
+    }
+
+    // Is the sequence [t, t+len) an instance of the sequence [s, s+len)
+    auto is_repetition = [&](casadi_int s, casadi_int t, casadi_int len) {
+      for (casadi_int j=0; j<len; ++j) {
+        const AlgEl& a = algorithm_[s+j];
+        const AlgEl& b = algorithm_[t+j];
+        if (a.op!=b.op) return false;
+        if (a.op==OP_CONST && !(a.d==b.d)) return false;
+        if (a.op==OP_INPUT && a.i1!=b.i1) return false;
+        if (a.op==OP_OUTPUT && a.i0!=b.i0) return false;
+        // Arguments are either in the same relative position or common to both
+        for (casadi_int i=0; i<codegen_n_read(a); ++i) {
+          casadi_int da = i==0 ? df.dep1[s+j] : df.dep2[s+j];
+          casadi_int db = i==0 ? df.dep1[t+j] : df.dep2[t+j];
+          if (da>=s ? db-t!=da-s : db!=da) return false;
+        }
+      }
+      return true;
+    };
+
+    // Index tables, local to the function (or part) being generated
+    std::map<std::vector<casadi_int>, std::string> tables;
+
+    // Index expression for a loop iteration k
+    auto index = [&](const std::vector<casadi_int>& v) -> std::string {
+      casadi_int step = v[1]-v[0];
+      for (casadi_int k=2; k<v.size(); ++k) {
+        // Use an index table if not affine
+        if (v[k]-v[k-1]!=step) {
+          auto it = tables.find(v);
+          if (it==tables.end()) {
+            std::string name = "ind" + str(tables.size());
+            g.local(name + "[" + str(v.size()) + "]", "static const casadi_int");
+            g.init_local(name + "[" + str(v.size()) + "]", g.initializer(v));
+            it = tables.insert(std::make_pair(v, name)).first;
+          }
+          return it->second + "[k]";
+        }
+      }
+      std::string ret = str(v[0]);
+      if (step==0) return ret;
+      std::string term = (std::abs(step)==1 ? "" : str(std::abs(step)) + "*") + "k";
+      if (v[0]==0) return step>0 ? term : "-" + term;
+      return ret + (step>0 ? "+" : "-") + term;
+    };
+
+    casadi_int k = begin;
+    while (k<end) {
+      // Find the longest repetition of an instruction sequence starting at k
+      casadi_int best_len = 0, best_n = 0;
+      if (!seq_hash.empty() && k-begin<seq_hash.size()) {
+        const std::vector<casadi_int>& pos = seq_pos[seq_hash[k-begin]];
+        auto it = std::upper_bound(pos.begin(), pos.end(), k);
+        for (casadi_int c=0; c<8 && it!=pos.end(); ++c, ++it) {
+          casadi_int len = *it - k;
+          if (k+2*len>end) break;
+          casadi_int n = 0;
+          while (k+(n+1)*len<=end && (n==0 || is_repetition(k, k+n*len, len))) n++;
+          if (n>=2 && n*len>best_n*best_len) {
+            best_len = len;
+            best_n = n;
+          }
+        }
+      }
+
+      if (best_n*best_len<min_rolled) {
+        // Generate a single instruction
+        const AlgEl& a = algorithm_[k];
+        if (a.op==OP_OUTPUT) {
+          g << "if (res[" << a.i0 << "]!=0) "
+            << g.res(a.i0) << "[" << a.i2 << "]=" << work(a.i1);
+        } else {
+          // What to store
+          std::string rhs;
+          if (a.op==OP_CONST) {
+            rhs = g.constant(a.d);
+          } else if (a.op==OP_INPUT) {
+            rhs = g.arg(a.i1) + "? " + g.arg(a.i1) + "[" + str(a.i2) + "] : 0";
+          } else {
+            casadi_int ndep = casadi_math<double>::ndeps(a.op);
+            casadi_assert_dev(ndep>0);
+            if (ndep==1) rhs = g.print_op(a.op, work(a.i1));
+            if (ndep==2) rhs = g.print_op(a.op, work(a.i1), work(a.i2));
+          }
+          // Where to store the result: local if read before end, work vector if read after
+          bool local = !avoid_stack && df.first_use[k]<end;
+          if (local) g << g.sx_work(a.i0) << "=";
+          if (!local || df.last_use[k]>=end) g << "w[" << a.i0 << "]=";
+          g << rhs;
+          in_w[a.i0] = !local;
+        }
+        g << ";\n";
+        k++;
+        continue;
+      }
 
-        // What to store
+      // Generate a loop over the repetitions
+      casadi_int len = best_len, n = best_n, loop_begin = k, loop_end = k + n*len;
+      // Results read within an iteration and after the loop
+      std::vector<bool> used(len, false), escapes(len, false);
+      for (casadi_int j=0; j<len; ++j) {
+        for (casadi_int i=0; i<codegen_n_read(algorithm_[k+j]); ++i) {
+          casadi_int d = i==0 ? df.dep1[k+j] : df.dep2[k+j];
+          if (d>=k) used[d-k] = true;
+        }
+        for (casadi_int r=0; r<n; ++r) {
+          if (df.last_use[k+r*len+j]>=loop_end) escapes[j] = true;
+        }
+      }
+      // Varying work vector index (i0) or input/output nonzero (i2) of an instruction
+      auto field = [&](casadi_int j, bool nz) {
+        std::vector<casadi_int> v(n);
+        for (casadi_int r=0; r<n; ++r) {
+          const AlgEl& e = algorithm_[k+r*len+j];
+          v[r] = nz ? e.i2 : e.i0;
+        }
+        return index(v);
+      };
+      // Results local to an iteration
+      auto value = [&](casadi_int j) -> std::string {
+        if (avoid_stack) return "w[" + field(j, false) + "]";
+        return "t" + str(j);
+      };
+      // Arguments, from the same iteration or from before the loop
+      auto arg = [&](casadi_int j, casadi_int i) -> std::string {
+        casadi_int d = i==0 ? df.dep1[k+j] : df.dep2[k+j];
+        if (d>=k) return value(d-k);
+        return work(i==0 ? algorithm_[k+j].i1 : algorithm_[k+j].i2);
+      };
+      g.local("k", "casadi_int");
+      g << "for (k=0; k<" << n << "; ++k) {\n";
+      if (!avoid_stack) {
+        std::string decl;
+        for (casadi_int j=0; j<len; ++j) {
+          if (used[j]) decl += (decl.empty() ? "casadi_real " : ", ") + value(j);
+        }
+        if (!decl.empty()) g << decl << ";\n";
+      }
+      for (casadi_int j=0; j<len; ++j) {
+        const AlgEl& a = algorithm_[k+j];
+        if (a.op==OP_OUTPUT) {
+          g << "if (res[" << a.i0 << "]!=0) "
+            << g.res(a.i0) << "[" << field(j, true) << "]=" << arg(j, 0) << ";\n";
+          continue;
+        }
+        // Skip results that are never read
+        if (!avoid_stack && !used[j] && !escapes[j]) continue;
         if (a.op==OP_CONST) {
-          g << g.constant(a.d);
-        } else if (a.op==OP_INPUT) {
-          g << g.arg(a.i1) << "? " << g.arg(a.i1) << "[" << a.i2 << "] : 0";
+          if (avoid_stack || used[j]) g << value(j) << "=";
+          if (!avoid_stack && escapes[j]) g << "w[" << field(j, false) << "]=";
+          g << g.constant(a.d) << ";\n";
+          continue;
+        }
+        std::string rhs;
+        if (a.op==OP_INPUT) {
+          rhs = g.arg(a.i1) + "? " + g.arg(a.i1) + "[" + field(j, true) + "] : 0";
         } else {
           casadi_int ndep = casadi_math<double>::ndeps(a.op);
           casadi_assert_dev(ndep>0);
-          if (ndep==1) g << g.print_op(a.op, g.sx_work(a.i1));
-          if (ndep==2) g << g.print_op(a.op, g.sx_work(a.i1), g.sx_work(a.i2));
+          if (ndep==1) rhs = g.print_op(a.op, arg(j, 0));
+          if (ndep==2) rhs = g.print_op(a.op, arg(j, 0), arg(j, 1));
         }
+        if (avoid_stack || used[j]) g << value(j) << "=";
+        if (!avoid_stack && escapes[j]) g << "w[" << field(j, false) << "]=";
+        g << rhs << ";\n";
+      }
+      g << "}\n";
+      // Results read after the loop are in the work vector
+      for (; k<loop_end; ++k) {
+        if (algorithm_[k].op!=OP_OUTPUT) in_w[algorithm_[k].i0] = escapes[(k-loop_begin)%len];
       }
-      g  << ";\n";
     }
   }
 
+  casadi_int SXFunction::codegen_n_part(const CodeGenerator& g) const {
+    if (g.max_body_size==0) return 1;
+    return std::max(casadi_int(1), (n_instructions()+g.max_body_size-1)/g.max_body_size);
+  }
+
+  size_t SXFunction::codegen_sz_w(const CodeGenerator& g) const {
+    // Local variables, unless avoiding the stack or passing values between parts or loops
+    if (!g.avoid_stack() && !g.roll_loops && codegen_n_part(g)==1) return 0;
+    return sz_w();
+  }
+
+  void SXFunction::codegen(CodeGenerator& g, const std::string& fname) const {
+    casadi_int n_part = codegen_n_part(g);
+    if (n_part==1) return FunctionInternal::codegen(g, fname);
+    casadi_int n = n_instructions(), part_size = g.max_body_size;
+    CodegenDataFlow df;
+    codegen_data_flow(df);
+
+    // Generate the parts: values are local within a part and passed via w across parts
+    std::vector<std::string> part_names(n_part);
+    for (casadi_int p=0; p<n_part; ++p) {
+      part_names[p] = g.shorthand(codegen_name(g, false) + "_" + str(p+1), true);
+      std::string sig = "void " + part_names[p]
+        + "(const casadi_real** arg, casadi_real** res, casadi_real* w)";
+      g.add_external((g.split_files ? "" : "static ") + sig + ";");
+      std::stringstream code;
+      g << "/* " << definition() << ", part " << (p+1) << " of " << n_part << " */\n";
+      g << (g.split_files ? "" : "static ") << sig << " {\n";
+      g.flush(code);
+      g.scope_enter();
+      std::vector<bool> in_w(worksize_, true);
+      codegen_range(g, df, p*part_size, std::min(n, (p+1)*part_size), in_w);
+      g.scope_exit(code);
+      g << "}\n\n";
+      g.flush(code);
+      g.add_part(code.str());
+    }
+
+    // Define the function, calling the parts in order
+    g << "/* " << definition() << " */\n";
+    g << "static " << signature(fname) << " {\n";
+    for (auto&& pn : part_names) g << pn << "(arg, res, w);\n";
+    g << "return 0;\n";
+    g << "}\n\n";
+    g.flush(g.body);
+  }
+
   const Options SXFunction::options_
   = {{&FunctionInternal::options_},
      {{"default_in",
@@ -192,7 +838,27 @@ namespace casadi {
         "Just-in-time compilation for numeric evaluation using OpenCL (experimental)"}},
       {"live_variables",
        {OT_BOOL,
-        "Reuse variables in the work vector"}}
+        "Reuse variables in the work vector"}},
+      {"compact_tape",
+       {OT_BOOL,
+        "Evaluate numerically using a compact bytecode with fused instructions "
+        "and direct threaded dispatch, generated at initialization"}},
+      {"cse",
+       {OT_BOOL,
+        "Perform common subexpression elimination on the outputs at initialization"}},
+      {"cse_commutative",
+       {OT_BOOL,
+        "Treat the operands of commutative operations as unordered "
+        "in common subexpression elimination [default: true]"}},
+      {"precision",
+       {OT_STRING,
+        "Floating point precision of the numerical evaluation: 'double' [default], "
+        "'single' or 'mixed' (single precision storage, double precision operations)"}},
+      {"precision_check",
+       {OT_BOOL,
+        "Evaluate both in reduced precision ('mixed' if selected, otherwise 'single') "
+        "and in double precision, reporting the largest relative deviation for each "
+        "output in the statistics. The result of the selected precision is returned."}}
      }
   };
 
@@ -200,8 +866,12 @@ namespace casadi {
     Dict opts = FunctionInternal::generate_options(is_temp);
     //opts["default_in"] = default_in_;
     opts["live_variables"] = live_variables_;
+    opts["compact_tape"] = compact_tape_;
     opts["just_in_time_sparsity"] = just_in_time_sparsity_;
     opts["just_in_time_opencl"] = just_in_time_opencl_;
+    opts["precision"] = precision_==PRECISION_SINGLE ? "single" :
+      precision_==PRECISION_MIXED ? "mixed" : "double";
+    opts["precision_check"] = precision_check_;
     return opts;
   }
 
@@ -212,6 +882,7 @@ namespace casadi {
 
     // Default (temporary) options
     live_variables_ = true;
+    bool cse = false, cse_commutative = true;
 
     // Read options
     for (auto&& op : opts) {
@@ -219,12 +890,34 @@ namespace casadi {
         default_in_ = op.second;
       } else if (op.first=="live_variables") {
         live_variables_ = op.second;
+      } else if (op.first=="cse") {
+        cse = op.second;
+      } else if (op.first=="cse_commutative") {
+        cse_commutative = op.second;
       } else if (op.first=="just_in_time_opencl") {
         just_in_time_opencl_ = op.second;
       } else if (op.first=="just_in_time_sparsity") {
         just_in_time_sparsity_ = op.second;
+      } else if (op.first=="compact_tape") {
+        compact_tape_ = op.second;
+      } else if (op.first=="precision") {
+        std::string precision = op.second;
+        if (precision=="double") {
+          precision_ = PRECISION_DOUBLE;
+        } else if (precision=="single") {
+          precision_ = PRECISION_SINGLE;
+        } else if (precision=="mixed") {
+          precision_ = PRECISION_MIXED;
+        } else {
+          casadi_error("Unknown precision '" + precision + "', "
+                       "expected 'double', 'single' or 'mixed'");
+        }
+      } else if (op.first=="precision_check") {
+        precision_check_ = op.second;
       }
     }
+    casadi_assert(!compact_tape_ || (precision_==PRECISION_DOUBLE && !precision_check_),
+                  "Option 'compact_tape' requires double precision evaluation");
 
     // Check/set default inputs
     if (default_in_.empty()) {
@@ -234,6 +927,15 @@ namespace casadi {
                             "Option 'default_in' has incorrect length");
     }
 
+    // Eliminate common subexpressions
+    if (cse) {
+      Function tmp("tmp", vector<SX>(), out_);
+      casadi_int n_removed;
+      out_ = tmp.get<SXFunction>()->cse_outputs(cse_commutative, n_removed);
+      if (verbose_) casadi_message("Common subexpression elimination removed "
+                                   + str(n_removed) + " operations");
+    }
+
     // Stack used to sort the computational graph
     stack<SXNode*> s;
 
@@ -415,6 +1117,12 @@ namespace casadi {
     // Allocate work vectors (symbolic/numeric)
     alloc_w(worksize_);
 
+    // Results in reduced and double precision, for comparison
+    if (precision_check_) {
+      alloc_w(worksize_ + 2*nnz_out());
+      alloc_res(2*n_out_);
+    }
+
     // Reset the temporary variables
     for (casadi_int i=0; i<nodes.size(); ++i) {
       if (nodes[i]) {
@@ -470,10 +1178,107 @@ namespace casadi {
       casadi_error("OpenCL is not supported in this version of CasADi");
     }
 
+    // Generate compact bytecode
+    if (compact_tape_ && free_vars_.empty()) init_bytecode();
+
     // Print
     if (verbose_) casadi_message(str(algorithm_.size()) + " elementary operations");
   }
 
+  namespace {
+    // Operation and unique operands of a node, for hash-consing
+    struct CseKey {
+      casadi_int op;
+      const SXNode* x;
+      const SXNode* y;
+      bool operator==(const CseKey& k) const { return op==k.op && x==k.x && y==k.y;}
+    };
+
+    struct CseKeyHash {
+      size_t operator()(const CseKey& k) const {
+        size_t seed = 0;
+        hash_combine(seed, k.op);
+        hash_combine(seed, reinterpret_cast<uintptr_t>(k.x));
+        hash_combine(seed, reinterpret_cast<uintptr_t>(k.y));
+        return seed;
+      }
+    };
+  } // namespace
+
+  std::vector<SX> SXFunction::cse_outputs(bool commutative, casadi_int& n_removed) const {
+    // Return values, same sparsity as the outputs
+    vector<SX> ret(out_.size());
+    for (casadi_int i=0; i<ret.size(); ++i) ret[i] = SX::zeros(out_[i].sparsity());
+
+    // Symbolic work vector, holding unique expressions only
+    vector<SXElem> w(worksize_);
+
+    // Unique operations and constants
+    unordered_map<CseKey, SXElem, CseKeyHash> unique_op;
+    unordered_map<uint64_t, SXElem> unique_const;
+
+    // Iterators to the operations, constants and free variables
+    vector<SXElem>::const_iterator b_it = operations_.begin();
+    vector<SXElem>::const_iterator c_it = constants_.begin();
+    vector<SXElem>::const_iterator p_it = free_vars_.begin();
+
+    // Evaluate the algorithm, replacing each node with its unique counterpart
+    n_removed = 0;
+    for (auto&& a : algorithm_) {
+      switch (a.op) {
+      case OP_INPUT:
+        w[a.i0] = in_[a.i1]->at(a.i2);
+        break;
+      case OP_OUTPUT:
+        ret[a.i0]->at(a.i2) = w[a.i1];
+        break;
+      case OP_CONST:
+        {
+          // Constants are unique by value (bit pattern)
+          uint64_t bits;
+          memcpy(&bits, &a.d, sizeof(bits));
+          auto it = unique_const.insert(make_pair(bits, *c_it));
+          if (!it.second) n_removed++;
+          w[a.i0] = it.first->second;
+          c_it++;
+        }
+        break;
+      case OP_PARAMETER:
+        w[a.i0] = *p_it++;
+        break;
+      default:
+        {
+          const SXElem& orig = *b_it++;
+          casadi_int ndeps = casadi_math<double>::ndeps(a.op);
+          SXElem x = w[a.i1], y = ndeps==2 ? w[a.i2] : SXElem();
+          // Operation and unique operands
+          CseKey key = {a.op, x.get(), ndeps==2 ? y.get() : nullptr};
+          if (commutative && ndeps==2 && operation_checker<CommChecker>(a.op)
+              && key.y < key.x) std::swap(key.x, key.y);
+          auto it = unique_op.find(key);
+          if (it!=unique_op.end()) {
+            // Duplicate
+            w[a.i0] = it->second;
+            n_removed++;
+          } else {
+            // Reuse the original node, unless its operands have been replaced
+            SXElem r;
+            if (orig.dep(0).get()==x.get() && (ndeps<2 || orig.dep(1).get()==y.get())) {
+              r = orig;
+            } else {
+              switch (a.op) {
+                CASADI_MATH_FUN_BUILTIN(x, y, r)
+              }
+            }
+            unique_op.insert(make_pair(key, r));
+            w[a.i0] = r;
+          }
+        }
+      }
+    }
+    return ret;
+  }
+
   SX SXFunction::instructions_sx() const {
     std::vector<SXElem> ret(algorithm_.size(), casadi_limits<SXElem>::nan);
 
@@ -965,7 +1770,7 @@ namespace casadi {
 
   SXFunction::SXFunction(DeserializingStream& s) :
     XFunction<SXFunction, SX, SXNode>(s) {
-    s.version("SXFunction", 1);
+    int version = s.version("SXFunction", 1, 3);
     size_t n_instructions;
     s.unpack("SXFunction::n_instr", n_instructions);
 
@@ -989,13 +1794,28 @@ namespace casadi {
     just_in_time_sparsity_ = false;
 
     s.unpack("SXFunction::live_variables", live_variables_);
+    if (version>=2) {
+      s.unpack("SXFunction::compact_tape", compact_tape_);
+    } else {
+      compact_tape_ = false;
+    }
+    if (version>=3) {
+      int precision;
+      s.unpack("SXFunction::precision", precision);
+      precision_ = static_cast<Precision>(precision);
+      s.unpack("SXFunction::precision_check", precision_check_);
+    } else {
+      precision_ = PRECISION_DOUBLE;
+      precision_check_ = false;
+    }
+    if (compact_tape_ && free_vars_.empty()) init_bytecode();
 
     XFunction<SXFunction, SX, SXNode>::delayed_deserialize_members(s);
   }
 
   void SXFunction::serialize_body(SerializingStream &s) const {
     XFunction<SXFunction, SX, SXNode>::serialize_body(s);
-    s.version("SXFunction", 1);
+    s.version("SXFunction", 3);
     s.pack("SXFunction::n_instr", algorithm_.size());
 
     s.pack("SXFunction::worksize", worksize_);
@@ -1013,6 +1833,9 @@ namespace casadi {
     }
 
     s.pack("SXFunction::live_variables", live_variables_);
+    s.pack("SXFunction::compact_tape", compact_tape_);
+    s.pack("SXFunction::precision", static_cast<int>(precision_));
+    s.pack("SXFunction::precision_check", precision_check_);
 
     XFunction<SXFunction, SX, SXNode>::delayed_serialize_members(s);
   }
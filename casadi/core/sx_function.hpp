@@ -41,6 +41,13 @@ namespace casadi {
     };
   };
 
+  /** \brief Memory for SXFunction */
+  struct CASADI_EXPORT SXFunctionMemory : public FunctionMemory {
+    // Largest relative deviation between reduced and double precision results
+    // for each output, in the last call and over all calls
+    std::vector<double> dev, dev_max;
+  };
+
 /** \brief  Internal node class for SXFunction
     Do not use any internal class directly - always use the public Function
     \author Joel Andersson
@@ -66,6 +73,43 @@ class CASADI_EXPORT SXFunction :
   int eval_sx(const SXElem** arg, SXElem** res,
               casadi_int* iw, SXElem* w, void* mem) const override;
 
+  /** \brief Number of evaluation points handled simultaneously by eval_batch */
+  static const casadi_int batch_size = 8;
+
+  /** \brief Can eval_batch be used in place of repeated calls to eval? */
+  bool has_eval_batch() const;
+
+  /** \brief  Evaluate numerically at n<=batch_size points simultaneously
+
+      Each instruction is applied to all points before moving to the next one.
+      The nonzeros of point k are located at arg[i]+k*nnz_in(i) and res[i]+k*nnz_out(i).
+      The work vector holds sz_w()*batch_size entries, stored structure-of-arrays.
+  */
+  int eval_batch(const double** arg, double** res, double* w, casadi_int n) const;
+
+  /** \brief  Evaluate numerically using the compact bytecode */
+  int eval_bytecode(const double** arg, double** res, double* w) const;
+
+  /** \brief  Evaluate numerically, storing intermediate results as S and operating in C */
+  template<typename S, typename C>
+  void eval_precision(const double** arg, double** res, S* w) const;
+
+  /** \brief  Evaluate numerically in reduced and double precision, recording the deviation */
+  void eval_precision_check(const double** arg, double** res, double* w,
+                            SXFunctionMemory* m) const;
+
+  /** \brief Create memory block */
+  void* alloc_mem() const override { return new SXFunctionMemory();}
+
+  /** \brief Initalize memory block */
+  int init_mem(void* mem) const override;
+
+  /** \brief Free memory block */
+  void free_mem(void *mem) const override { delete static_cast<SXFunctionMemory*>(mem);}
+
+  /** \brief Get all statistics */
+  Dict get_stats(void* mem) const override;
+
   /** Inline calls? */
   bool should_inline(bool always_inline, bool never_inline) const override {
     return true;
@@ -182,6 +226,19 @@ class CASADI_EXPORT SXFunction :
   /// Default input values
   std::vector<double> default_in_;
 
+  /** \brief Compact bytecode, generated from algorithm_
+
+      Variable-length instructions of packed 32-bit words, with fused
+      instructions for multiply-add, constant operands and unary-of-binary
+  */
+  std::vector<int> bytecode_;
+
+  /// Constants referenced by bytecode_
+  std::vector<double> bytecode_constants_;
+
+  /// Generate bytecode_ from algorithm_
+  void init_bytecode();
+
     /** \brief Serialize an object without type information */
   void serialize_body(SerializingStream &s) const override;
 
@@ -206,6 +263,35 @@ class CASADI_EXPORT SXFunction :
   /** \brief Generate code for the body of the C function */
   void codegen_body(CodeGenerator& g) const override;
 
+  /** \brief Generate code, splitting the body into parts if large */
+  void codegen(CodeGenerator& g, const std::string& fname) const override;
+
+  /** \brief Number of parts of the generated body */
+  casadi_int codegen_n_part(const CodeGenerator& g) const;
+
+  /** \brief Length of the work vector required by the generated code */
+  size_t codegen_sz_w(const CodeGenerator& g) const override;
+
+  /** \brief Data flow of the algorithm, for code generation */
+  struct CodegenDataFlow {
+    // Positions of the instructions defining the arguments, -1 if none
+    std::vector<casadi_int> dep1, dep2;
+    // Positions of the first and last instructions reading the result, -1 if none
+    std::vector<casadi_int> first_use, last_use;
+  };
+
+  /** \brief Analyze the data flow of the algorithm */
+  void codegen_data_flow(CodegenDataFlow& df) const;
+
+  /** \brief Generate code for the instructions in [begin, end)
+
+      Results read after end are (also) written to the work vector. in_w marks
+      the work vector elements currently held in the work vector rather than
+      in local variables.
+  */
+  void codegen_range(CodeGenerator& g, const CodegenDataFlow& df,
+                     casadi_int begin, casadi_int end, std::vector<bool>& in_w) const;
+
   /** \brief  Propagate sparsity forward */
   int sp_forward(const bvec_t** arg, bvec_t** res,
                   casadi_int* iw, bvec_t* w, void* mem) const override;
@@ -222,6 +308,15 @@ class CASADI_EXPORT SXFunction :
   /** *\brief get SX expression associated with instructions */
   SX instructions_sx() const override;
 
+  /** \brief Outputs after common subexpression elimination
+
+      Structurally identical operations (same operation, same operands after
+      elimination) and constants with the same value are replaced by a single
+      node. If commutative is set, the operands of commutative operations are
+      treated as unordered. The number of removed instructions is returned in n_removed.
+  */
+  std::vector<SX> cse_outputs(bool commutative, casadi_int& n_removed) const;
+
   /** \brief Get default input value */
   double get_default_in(casadi_int ind) const override { return default_in_.at(ind);}
 
@@ -238,6 +333,16 @@ class CASADI_EXPORT SXFunction :
   /// Live variables?
   bool live_variables_;
 
+  /// Evaluate numerically using the compact bytecode?
+  bool compact_tape_;
+
+  /// Floating point precision of the numerical evaluation
+  enum Precision {PRECISION_DOUBLE, PRECISION_SINGLE, PRECISION_MIXED};
+  Precision precision_;
+
+  /// Evaluate also in double precision and record the deviation?
+  bool precision_check_;
+
 protected:
   /** \brief Deserializing constructor */
   explicit SXFunction(DeserializingStream& s);
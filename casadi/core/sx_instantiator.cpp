@@ -861,6 +861,14 @@ namespace casadi {
     copy(vdef.begin(), vdef.end(), vdef_sx.begin());
   }
 
+  template<>
+  vector<SX> CASADI_EXPORT SX::cse(const vector<SX>& ex, bool commutative) {
+    // Sort the expression
+    Function f("tmp", vector<SX>(), ex);
+    casadi_int n_removed;
+    return f.get<SXFunction>()->cse_outputs(commutative, n_removed);
+  }
+
   template<>
   SX CASADI_EXPORT SX::poly_coeff(const SX& ex, const SX& x) {
     casadi_assert_dev(ex.is_scalar());
@@ -39,6 +39,7 @@ namespace casadi {
   SXNode::SXNode() {
     count = 0;
     temp = 0;
+    pooled = SXNodePool::from_pool(this);
   }
 
   SXNode::~SXNode() {
@@ -50,6 +51,8 @@ namespace casadi {
                    "Possible cause: Circular dependency in user code." << std::endl;
     }
     #endif // WITH_REFCOUNT_WARNINGS
+    // Return the memory to the pool in the operator delete that follows
+    if (pooled) SXNodePool::to_pool(this);
   }
 
   double SXNode::to_double() const {
@@ -33,6 +33,7 @@
 
 /** \brief  Scalar expression (which also works as a smart pointer class to this class) */
 #include "sx_elem.hpp"
+#include "sx_node_pool.hpp"
 
 
 /// \cond INTERNAL
@@ -54,6 +55,12 @@ namespace casadi {
     /** \brief  destructor  */
     virtual ~SXNode();
 
+    ///@{
+    /** \brief  Allocation, optionally from a pool (cf. GlobalOptions::sx_node_pool) */
+    static void* operator new(std::size_t sz) { return SXNodePool::allocate(sz);}
+    static void operator delete(void* p) { SXNodePool::deallocate(p);}
+    ///@}
+
     ///@{
     /** \brief  check properties of a node */
     virtual bool is_constant() const { return false; }
@@ -131,7 +138,10 @@ namespace casadi {
     mutable int temp;
 
     // Reference counter -- counts the number of parents of the node
-    unsigned int count;
+    unsigned int count : 31;
+
+    // Was the node allocated from the pool
+    unsigned int pooled : 1;
 
     /** \brief Serialize an object */
     void serialize(SerializingStream& s) const;
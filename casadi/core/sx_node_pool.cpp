@@ -0,0 +1,231 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "sx_node_pool.hpp"
+#include "global_options.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif // _WIN32
+
+namespace casadi {
+
+  namespace {
+    // Size of a chunk, chunks are aligned to their size
+    const size_t chunk_size = size_t(1) << 18;
+
+    // Slot sizes are multiples of the granularity
+    const size_t granularity = 16;
+
+    // Number of size classes: slots of 16, 32, 48 and 64 bytes
+    const size_t n_class = 4;
+
+    // Chunk header, placed at the beginning of the chunk
+    struct Chunk {
+      // Slot size
+      size_t slot;
+      // Number of slots in use
+      casadi_int n_live;
+      // Singly linked list of freed slots
+      void* free;
+      // Start of the never used slots and end of the chunk
+      char *bump, *end;
+      // Neighbors in the list of chunks with unused slots
+      Chunk *prev, *next;
+      // Is the chunk in the list of chunks with unused slots
+      bool partial;
+    };
+
+    // Offset of the first slot, keeps the slots aligned
+    const size_t header_size = ((sizeof(Chunk) + 63)/64)*64;
+
+    struct Pool {
+      // Spin lock, protects everything below
+      std::atomic_flag lock;
+      // Chunks with unused slots, for each size class
+      Chunk* partial[n_class];
+      // Statistics
+      casadi_int n_live;
+      size_t reserved;
+
+      Pool() : n_live(0), reserved(0) {
+        lock.clear();
+        for (size_t c=0; c<n_class; ++c) partial[c] = nullptr;
+      }
+    };
+
+    // Last slot handed out by the pool, and pooled slot about to be freed, by this thread
+    thread_local const void* last_allocated = nullptr;
+    thread_local const void* next_freed = nullptr;
+
+    // The pool is never destroyed, since nodes may be freed during static destruction
+    Pool& pool() {
+      static Pool* p = new Pool();
+      return *p;
+    }
+
+    class PoolLock {
+    public:
+      explicit PoolLock(Pool& p) : p_(p) {
+        while (p_.lock.test_and_set(std::memory_order_acquire)) {}
+      }
+      ~PoolLock() { p_.lock.clear(std::memory_order_release);}
+    private:
+      Pool& p_;
+    };
+
+    void* aligned_alloc_chunk() {
+#ifdef _WIN32
+      void* r = _aligned_malloc(chunk_size, chunk_size);
+#else // _WIN32
+      void* r = nullptr;
+      if (posix_memalign(&r, chunk_size, chunk_size)) r = nullptr;
+#endif // _WIN32
+      if (r==nullptr) throw std::bad_alloc();
+      return r;
+    }
+
+    void aligned_free_chunk(void* p) {
+#ifdef _WIN32
+      _aligned_free(p);
+#else // _WIN32
+      free(p);
+#endif // _WIN32
+    }
+
+    // Insert a chunk at the front of the list of chunks with unused slots
+    void link(Pool& p, Chunk* ch, size_t c) {
+      ch->prev = nullptr;
+      ch->next = p.partial[c];
+      if (ch->next) ch->next->prev = ch;
+      p.partial[c] = ch;
+      ch->partial = true;
+    }
+
+    // Remove a chunk from the list of chunks with unused slots
+    void unlink(Pool& p, Chunk* ch, size_t c) {
+      if (ch->prev) {
+        ch->prev->next = ch->next;
+      } else {
+        p.partial[c] = ch->next;
+      }
+      if (ch->next) ch->next->prev = ch->prev;
+      ch->prev = ch->next = nullptr;
+      ch->partial = false;
+    }
+  } // namespace
+
+  void* SXNodePool::allocate(size_t sz) {
+    // Size class
+    size_t c = (sz + granularity - 1)/granularity;
+    if (!GlobalOptions::sx_node_pool || c==0 || c>n_class) return ::operator new(sz);
+    c--;
+    Pool& p = pool();
+    PoolLock lock(p);
+    Chunk* ch = p.partial[c];
+    // Allocate a new chunk, if needed
+    if (ch==nullptr) {
+      char* mem = static_cast<char*>(aligned_alloc_chunk());
+      p.reserved += chunk_size;
+      ch = reinterpret_cast<Chunk*>(mem);
+      ch->slot = (c+1)*granularity;
+      ch->n_live = 0;
+      ch->free = nullptr;
+      ch->bump = mem + header_size;
+      ch->end = mem + chunk_size;
+      link(p, ch, c);
+    }
+    // Reuse a freed slot or take a new one
+    void* r;
+    if (ch->free) {
+      r = ch->free;
+      ch->free = *static_cast<void**>(r);
+    } else {
+      r = ch->bump;
+      ch->bump += ch->slot;
+    }
+    ch->n_live++;
+    p.n_live++;
+    // Chunk full?
+    if (ch->free==nullptr && ch->bump + ch->slot > ch->end) unlink(p, ch, c);
+    last_allocated = r;
+    return r;
+  }
+
+  bool SXNodePool::from_pool(const void* p) {
+    bool ret = p==last_allocated;
+    last_allocated = nullptr;
+    return ret;
+  }
+
+  void SXNodePool::to_pool(const void* p) {
+    next_freed = p;
+  }
+
+  void SXNodePool::deallocate(void* ptr) {
+    // Nodes not announced by to_pool are on the heap
+    if (ptr==nullptr || ptr!=next_freed) {
+      ::operator delete(ptr);
+      return;
+    }
+    next_freed = nullptr;
+    // The chunk header holds the size class
+    uintptr_t base = reinterpret_cast<uintptr_t>(ptr) & ~uintptr_t(chunk_size-1);
+    Chunk* ch = reinterpret_cast<Chunk*>(base);
+    size_t c = ch->slot/granularity - 1;
+    Pool& p = pool();
+    PoolLock lock(p);
+    *static_cast<void**>(ptr) = ch->free;
+    ch->free = ptr;
+    ch->n_live--;
+    p.n_live--;
+    if (!ch->partial) link(p, ch, c);
+    // Release the chunk if empty, unless it is the only one with unused slots
+    if (ch->n_live==0 && (ch->prev || ch->next)) {
+      unlink(p, ch, c);
+      p.reserved -= chunk_size;
+      aligned_free_chunk(ch);
+    }
+  }
+
+  casadi_int SXNodePool::n_live() {
+    Pool& p = pool();
+    PoolLock lock(p);
+    return p.n_live;
+  }
+
+  size_t SXNodePool::reserved() {
+    Pool& p = pool();
+    PoolLock lock(p);
+    return p.reserved;
+  }
+
+} // namespace casadi
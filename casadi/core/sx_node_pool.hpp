@@ -0,0 +1,75 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#ifndef CASADI_SX_NODE_POOL_HPP
+#define CASADI_SX_NODE_POOL_HPP
+
+#include "casadi_common.hpp"
+
+/// \cond INTERNAL
+
+namespace casadi {
+
+  /** \brief Pool allocator for scalar expression nodes
+
+      When GlobalOptions::sx_node_pool is set, small nodes are carved out of
+      large aligned chunks, one size class per chunk, instead of being allocated
+      individually on the heap. A chunk is handed back to the system as soon as
+      all of its nodes have been freed, so that the memory of an expression graph
+      is released in bulk when the graph dies. One empty chunk per size class is
+      retained to avoid thrashing.
+
+      Nodes allocated with the pool disabled (or too large for the pool) are
+      allocated on the heap as usual, so the option can be toggled at any time.
+      A node records where it came from: its constructor asks from_pool, and its
+      destructor announces a pooled node with to_pool before the memory is freed.
+  */
+  class CASADI_EXPORT SXNodePool {
+  public:
+    /** \brief Allocate memory for a node */
+    static void* allocate(size_t sz);
+
+    /** \brief Free memory of a node */
+    static void deallocate(void* p);
+
+    /** \brief Is p the last allocation from the pool by this thread, consumes the answer */
+    static bool from_pool(const void* p);
+
+    /** \brief Have the next deallocation of p by this thread return it to the pool */
+    static void to_pool(const void* p);
+
+    /** \brief Number of nodes currently allocated from the pool */
+    static casadi_int n_live();
+
+    /** \brief Number of bytes currently reserved by the pool */
+    static size_t reserved();
+  };
+
+} // namespace casadi
+
+/// \endcond
+
+#endif // CASADI_SX_NODE_POOL_HPP
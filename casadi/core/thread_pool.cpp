@@ -0,0 +1,179 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "thread_pool.hpp"
+#include "exception.hpp"
+
+#ifdef CASADI_WITH_THREAD
+#include <atomic>
+#endif // CASADI_WITH_THREAD
+
+using namespace std;
+
+namespace casadi {
+
+#ifdef CASADI_WITH_THREAD
+  struct ThreadPool::Job {
+    // Task to be executed
+    const Task* task;
+    // Number of tasks and chunk size
+    casadi_int n, chunk;
+    // Maximum number of participating workers
+    casadi_int n_workers;
+    // Next worker index to be handed out
+    std::atomic<casadi_int> next_worker;
+    // Start of the next unclaimed chunk
+    std::atomic<casadi_int> next;
+    // Number of tasks finished
+    casadi_int done;
+    // Protects done
+    std::mutex mtx;
+    // Signals completion
+    std::condition_variable cv;
+  };
+#endif // CASADI_WITH_THREAD
+
+  ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  casadi_int ThreadPool::default_num_threads() {
+#ifdef CASADI_WITH_THREAD
+    casadi_int n = std::thread::hardware_concurrency();
+    return n>0 ? n : 1;
+#else // CASADI_WITH_THREAD
+    return 1;
+#endif // CASADI_WITH_THREAD
+  }
+
+  casadi_int ThreadPool::size() const {
+#ifdef CASADI_WITH_THREAD
+    std::lock_guard<std::mutex> lock(mtx_);
+    return threads_.size();
+#else // CASADI_WITH_THREAD
+    return 0;
+#endif // CASADI_WITH_THREAD
+  }
+
+  ThreadPool::~ThreadPool() {
+#ifdef CASADI_WITH_THREAD
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto&& th : threads_) th.join();
+#endif // CASADI_WITH_THREAD
+  }
+
+  void ThreadPool::run(casadi_int n, casadi_int n_workers, const Task& task,
+      casadi_int chunk) {
+    casadi_assert_dev(n_workers>=1);
+    if (n<=0) return;
+#ifdef CASADI_WITH_THREAD
+    // No more workers than tasks
+    n_workers = std::min(n_workers, n);
+    // Default chunking: a few chunks per worker for load balancing
+    if (chunk<=0) chunk = std::max(casadi_int(1), n/(4*n_workers));
+    // Quick return if serial
+    if (n_workers==1 || chunk>=n) {
+      for (casadi_int i=0; i<n; ++i) task(0, i);
+      return;
+    }
+    // Shared job description, kept alive by tickets still in the queue
+    auto job = std::make_shared<Job>();
+    job->task = &task;
+    job->n = n;
+    job->chunk = chunk;
+    job->n_workers = n_workers;
+    job->next_worker = 0;
+    job->next = 0;
+    job->done = 0;
+    // Hand out participation tickets to the worker threads
+    reserve(n_workers-1);
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      for (casadi_int k=1; k<n_workers; ++k) queue_.push_back(job);
+    }
+    cv_.notify_all();
+    // The calling thread participates as well, which guarantees progress
+    // also when all worker threads are busy (e.g. nested parallel maps)
+    participate(*job);
+    // Wait for chunks claimed by other workers
+    std::unique_lock<std::mutex> lock(job->mtx);
+    job->cv.wait(lock, [&job]() { return job->done==job->n; });
+#else // CASADI_WITH_THREAD
+    for (casadi_int i=0; i<n; ++i) task(0, i);
+#endif // CASADI_WITH_THREAD
+  }
+
+#ifdef CASADI_WITH_THREAD
+  void ThreadPool::reserve(casadi_int n) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    while (threads_.size()<n) {
+      threads_.emplace_back([this]() { work(); });
+    }
+  }
+
+  void ThreadPool::work() {
+    while (true) {
+      std::shared_ptr<Job> job;
+      {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+        if (stop_) return;
+        job = queue_.front();
+        queue_.pop_front();
+      }
+      participate(*job);
+    }
+  }
+
+  void ThreadPool::participate(Job& job) {
+    // Quick return if all chunks have been claimed already
+    if (job.next>=job.n) return;
+    // Get a worker index
+    casadi_int w = job.next_worker++;
+    if (w>=job.n_workers) return;
+    // Claim chunks until exhausted
+    casadi_int n_done = 0;
+    while (true) {
+      casadi_int start = job.next.fetch_add(job.chunk);
+      if (start>=job.n) break;
+      casadi_int stop = std::min(start+job.chunk, job.n);
+      for (casadi_int i=start; i<stop; ++i) (*job.task)(w, i);
+      n_done += stop-start;
+    }
+    // Report finished tasks
+    if (n_done>0) {
+      std::lock_guard<std::mutex> lock(job.mtx);
+      job.done += n_done;
+      if (job.done==job.n) job.cv.notify_all();
+    }
+  }
+#endif // CASADI_WITH_THREAD
+
+} // namespace casadi
@@ -0,0 +1,127 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef CASADI_THREAD_POOL_HPP
+#define CASADI_THREAD_POOL_HPP
+
+#include "casadi_common.hpp"
+#include <functional>
+#include <memory>
+
+#ifdef CASADI_WITH_THREAD
+#ifdef CASADI_WITH_THREAD_MINGW
+#include <mingw.thread.h>
+#include <mingw.mutex.h>
+#include <mingw.condition_variable.h>
+#else // CASADI_WITH_THREAD_MINGW
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif // CASADI_WITH_THREAD_MINGW
+#include <deque>
+#endif // CASADI_WITH_THREAD
+
+/// \cond INTERNAL
+
+namespace casadi {
+
+  /** \brief Process-wide pool of persistent worker threads
+
+      Tasks are split into chunks of consecutive indices. Participating workers
+      (including the calling thread) repeatedly claim the next unprocessed chunk
+      until all chunks are done, so that uneven workloads are balanced automatically.
+      Worker threads are created on demand and kept alive until program exit.
+
+      Without WITH_THREAD=ON, all tasks are executed by the calling thread.
+  */
+  class CASADI_EXPORT ThreadPool {
+  public:
+    /** \brief Task callback: (worker index, task index)
+
+        The worker index is unique among the concurrently active workers
+        and lies in [0, n_workers). Must not throw.
+     */
+    typedef std::function<void(casadi_int, casadi_int)> Task;
+
+    /** \brief Access the process-wide instance */
+    static ThreadPool& instance();
+
+    /** \brief Default number of workers (hardware concurrency) */
+    static casadi_int default_num_threads();
+
+    /** \brief Evaluate task(worker, i) for i in [0, n)
+
+        Uses at most n_workers concurrent workers, the calling thread being one of them.
+        Indices are handed out in chunks of size chunk (0: automatic).
+        Returns when all tasks have finished.
+     */
+    void run(casadi_int n, casadi_int n_workers, const Task& task, casadi_int chunk=0);
+
+    /** \brief Number of worker threads currently alive */
+    casadi_int size() const;
+
+    /** \brief Destructor: stops and joins all worker threads */
+    ~ThreadPool();
+
+#ifndef SWIG
+  private:
+    ThreadPool() {}
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+#ifdef CASADI_WITH_THREAD
+    struct Job;
+
+    // Make sure that at least n worker threads are alive
+    void reserve(casadi_int n);
+
+    // Worker thread main loop
+    void work();
+
+    // Participate in a job
+    static void participate(Job& job);
+
+    // Worker threads
+    std::vector<std::thread> threads_;
+
+    // Pending participation tickets
+    std::deque< std::shared_ptr<Job> > queue_;
+
+    // Protects threads_, queue_ and stop_
+    mutable std::mutex mtx_;
+
+    // Signals new tickets or shutdown
+    std::condition_variable cv_;
+
+    // Shutdown flag
+    bool stop_ = false;
+#endif // CASADI_WITH_THREAD
+#endif // SWIG
+  };
+
+} // namespace casadi
+/// \endcond
+
+#endif // CASADI_THREAD_POOL_HPP
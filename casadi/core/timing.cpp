@@ -37,27 +37,29 @@ namespace casadi {
     t_proc = 0;
   }
 
-  void FStats::tic() {
-    start_proc = std::clock();
+  void FStats::tic(bool proc) {
+    proc_ = proc;
+    if (proc_) start_proc = std::clock();
     start_wall= high_resolution_clock::now();
   }
 
   void FStats::toc() {
     // First get the time points
-    stop_proc = std::clock();
+    if (proc_) stop_proc = std::clock();
     stop_wall = high_resolution_clock::now();
 
     // Process them
-    double proc = static_cast<double>(stop_proc - start_proc) / static_cast<double>(CLOCKS_PER_SEC);
-    t_proc += proc;
+    if (proc_) {
+      t_proc += static_cast<double>(stop_proc - start_proc) / static_cast<double>(CLOCKS_PER_SEC);
+    }
     double wall = duration<double>(stop_wall - start_wall).count();
     t_wall += wall;
     n_call +=1;
 
   }
 
-  ScopedTiming::ScopedTiming(FStats& f) : f_(f) {
-    f_.tic();
+  ScopedTiming::ScopedTiming(FStats& f, bool proc) : f_(f) {
+    f_.tic(proc);
   }
 
   ScopedTiming::~ScopedTiming() {
@@ -58,6 +58,9 @@ namespace casadi {
       /// Time point used for proc time computation
       std::clock_t stop_proc;
 
+      /// Is proc time being measured (std::clock is a system call)
+      bool proc_ = true;
+
     public:
       /// Constructor
       FStats();
@@ -65,8 +68,8 @@ namespace casadi {
       /// Reset the statistics
       void reset();
 
-      /// Start timing
-      void tic();
+      /// Start timing, the proc time is skipped if proc is false
+      void tic(bool proc=true);
 
       /// Stop timing
       void toc();
@@ -84,7 +87,7 @@ namespace casadi {
 
   class CASADI_EXPORT ScopedTiming {
     public:
-      ScopedTiming(FStats& f);
+      ScopedTiming(FStats& f, bool proc=true);
       ~ScopedTiming();
     private:
       FStats& f_;
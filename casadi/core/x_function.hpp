@@ -27,6 +27,7 @@
 #define CASADI_X_FUNCTION_HPP
 
 #include <stack>
+#include <type_traits>
 #include "function_internal.hpp"
 #include "factory.hpp"
 #include "serializing_stream.hpp"
@@ -455,6 +456,79 @@ namespace casadi {
       // Sparsity of the seeds
       vector<casadi_int> seed_col, seed_row;
 
+      // Forward seed for direction d
+      auto get_fseed = [&](casadi_int d, std::vector<MatType>& seed) {
+        // Nonzeros of the seed matrix
+        seed_col.clear();
+        seed_row.clear();
+
+        // For all the directions
+        for (casadi_int el = D1.colind(d); el<D1.colind(d+1); ++el) {
+
+          // Get the direction
+          casadi_int c = D1.row(el);
+
+          // Give a seed in the direction
+          seed_col.push_back(input_col[c]);
+          seed_row.push_back(input_row[c]);
+        }
+
+        // initialize to zero
+        seed.resize(n_in_);
+        for (casadi_int ind=0; ind<seed.size(); ++ind) {
+          casadi_int nrow = size1_in(ind), ncol = size2_in(ind); // Input dimensions
+          if (ind==iind) {
+            seed[ind] = MatType::ones(Sparsity::triplet(nrow, ncol, seed_row, seed_col));
+          } else {
+            seed[ind] = MatType(nrow, ncol);
+          }
+        }
+      };
+
+      // Adjoint seed for direction d
+      auto get_aseed = [&](casadi_int d, std::vector<MatType>& seed) {
+        // Nonzeros of the seed matrix
+        seed_col.clear();
+        seed_row.clear();
+
+        // For all the directions
+        for (casadi_int el = D2.colind(d); el<D2.colind(d+1); ++el) {
+
+          // Get the direction
+          casadi_int c = D2.row(el);
+
+          // Give a seed in the direction
+          seed_col.push_back(output_col[c]);
+          seed_row.push_back(output_row[c]);
+        }
+
+        //initialize to zero
+        seed.resize(n_out_);
+        for (casadi_int ind=0; ind<seed.size(); ++ind) {
+          casadi_int nrow = size1_out(ind), ncol = size2_out(ind); // Output dimensions
+          if (ind==oind) {
+            seed[ind] = MatType::ones(Sparsity::triplet(nrow, ncol, seed_row, seed_col));
+          } else {
+            seed[ind] = MatType(nrow, ncol);
+          }
+        }
+      };
+
+      // Evaluate the sweeps concurrently, by calling mapped derivative functions (MX only)
+      bool concurrent = std::is_same<MatType, MX>::value && jac_num_threads_>1 && nsweep>1;
+      std::vector<std::vector<MatType> > fsens_all, asens_all;
+      if (concurrent) {
+        if (verbose_) casadi_message("Evaluating " + str(nsweep) + " sweeps concurrently");
+        // Seeds for all directions
+        fseed.resize(nfdir);
+        for (casadi_int d=0; d<nfdir; ++d) get_fseed(d, fseed[d]);
+        aseed.resize(nadir);
+        for (casadi_int d=0; d<nadir; ++d) get_aseed(d, aseed[d]);
+        // Sensitivities for all directions
+        call_forward_batches(in_, out_, fseed, fsens_all);
+        call_reverse_batches(in_, out_, aseed, asens_all);
+      }
+
       // Evaluate until everything has been determined
       for (casadi_int s=0; s<nsweep; ++s) {
         // Print progress
@@ -471,64 +545,14 @@ namespace casadi {
         casadi_int nfdir_batch = std::min(nfdir - offset_nfdir, max_nfdir);
         casadi_int nadir_batch = std::min(nadir - offset_nadir, max_nadir);
 
-        // Forward seeds
-        fseed.resize(nfdir_batch);
-        for (casadi_int d=0; d<nfdir_batch; ++d) {
-          // Nonzeros of the seed matrix
-          seed_col.clear();
-          seed_row.clear();
-
-          // For all the directions
-          for (casadi_int el = D1.colind(offset_nfdir+d); el<D1.colind(offset_nfdir+d+1); ++el) {
-
-            // Get the direction
-            casadi_int c = D1.row(el);
-
-            // Give a seed in the direction
-            seed_col.push_back(input_col[c]);
-            seed_row.push_back(input_row[c]);
-          }
-
-          // initialize to zero
-          fseed[d].resize(n_in_);
-          for (casadi_int ind=0; ind<fseed[d].size(); ++ind) {
-            casadi_int nrow = size1_in(ind), ncol = size2_in(ind); // Input dimensions
-            if (ind==iind) {
-              fseed[d][ind] = MatType::ones(Sparsity::triplet(nrow, ncol, seed_row, seed_col));
-            } else {
-              fseed[d][ind] = MatType(nrow, ncol);
-            }
-          }
-        }
+        if (!concurrent) {
+          // Forward seeds
+          fseed.resize(nfdir_batch);
+          for (casadi_int d=0; d<nfdir_batch; ++d) get_fseed(offset_nfdir+d, fseed[d]);
 
-        // Adjoint seeds
-        aseed.resize(nadir_batch);
-        for (casadi_int d=0; d<nadir_batch; ++d) {
-          // Nonzeros of the seed matrix
-          seed_col.clear();
-          seed_row.clear();
-
-          // For all the directions
-          for (casadi_int el = D2.colind(offset_nadir+d); el<D2.colind(offset_nadir+d+1); ++el) {
-
-            // Get the direction
-            casadi_int c = D2.row(el);
-
-            // Give a seed in the direction
-            seed_col.push_back(output_col[c]);
-            seed_row.push_back(output_row[c]);
-          }
-
-          //initialize to zero
-          aseed[d].resize(n_out_);
-          for (casadi_int ind=0; ind<aseed[d].size(); ++ind) {
-            casadi_int nrow = size1_out(ind), ncol = size2_out(ind); // Output dimensions
-            if (ind==oind) {
-              aseed[d][ind] = MatType::ones(Sparsity::triplet(nrow, ncol, seed_row, seed_col));
-            } else {
-              aseed[d][ind] = MatType(nrow, ncol);
-            }
-          }
+          // Adjoint seeds
+          aseed.resize(nadir_batch);
+          for (casadi_int d=0; d<nadir_batch; ++d) get_aseed(offset_nadir+d, aseed[d]);
         }
 
         // Forward sensitivities
@@ -552,7 +576,13 @@ namespace casadi {
         }
 
         // Evaluate symbolically
-        if (!fseed.empty()) {
+        if (concurrent) {
+          // Already calculated
+          std::copy(fsens_all.begin()+offset_nfdir,
+                    fsens_all.begin()+offset_nfdir+nfdir_batch, fsens.begin());
+          std::copy(asens_all.begin()+offset_nadir,
+                    asens_all.begin()+offset_nadir+nadir_batch, asens.begin());
+        } else if (!fseed.empty()) {
           casadi_assert_dev(aseed.empty());
           if (verbose_) casadi_message("Calling 'ad_forward'");
           static_cast<const DerivedType*>(this)->ad_forward(fseed, fsens);
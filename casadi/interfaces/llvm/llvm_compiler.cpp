@@ -0,0 +1,395 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "llvm_compiler.hpp"
+#include "casadi/core/casadi_misc.hpp"
+#include "casadi/core/casadi_meta.hpp"
+#include "casadi/core/calculus.hpp"
+
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <map>
+#include <mutex>
+
+using namespace std;
+namespace casadi {
+
+  extern "C"
+  int CASADI_IMPORTER_LLVM_EXPORT
+  casadi_register_importer_llvm(ImporterInternal::Plugin* plugin) {
+    plugin->creator = LlvmCompiler::creator;
+    plugin->name = "llvm";
+    plugin->doc = LlvmCompiler::meta_doc.c_str();
+    plugin->version = CASADI_VERSION;
+    plugin->options = &LlvmCompiler::options_;
+    return 0;
+  }
+
+  extern "C"
+  void CASADI_IMPORTER_LLVM_EXPORT casadi_load_importer_llvm() {
+    ImporterInternal::registerPlugin(casadi_register_importer_llvm);
+  }
+
+  /// Compiled code, shared between importers with identical instructions
+  struct LlvmModule {
+    // JIT instance owning the machine code
+    std::unique_ptr<llvm::orc::LLJIT> jit;
+  };
+
+  // Scalar operations without a native IR counterpart are evaluated by calling back
+  extern "C" double casadi_llvm_fun(casadi_int op, double x, double y) {
+    double f;
+    casadi_math<double>::fun(static_cast<unsigned char>(op), x, y, f);
+    return f;
+  }
+
+  namespace {
+    // Turn an LLVM error into a CasADi exception
+    template<typename T>
+    T llvm_check(llvm::Expected<T> e, const std::string& what) {
+      if (!e) casadi_error(what + ": " + llvm::toString(e.takeError()));
+      return std::move(*e);
+    }
+
+    // Process-wide cache of compiled modules
+    std::mutex cache_mtx;
+    std::map<std::string, std::weak_ptr<LlvmModule> > cache;
+
+    // Append the binary representation of a value to a cache key
+    template<typename T>
+    void key_append(std::string& key, const T& v) {
+      key.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+  } // namespace
+
+  LlvmCompiler::LlvmCompiler(const std::string& name) :
+    ImporterInternal(name) {
+    opt_level_ = 2;
+  }
+
+  LlvmCompiler::~LlvmCompiler() {
+  }
+
+  const Options LlvmCompiler::options_
+  = {{&ImporterInternal::options_},
+     {{"function",
+       {OT_FUNCTION,
+        "SXFunction to be compiled [required]"}},
+      {"opt_level",
+       {OT_INT,
+        "Optimization level for the IR passes and the code generator (0-3). Default: 2"}}
+     }
+  };
+
+  void LlvmCompiler::init(const Dict& opts) {
+    // Base class
+    ImporterInternal::init(opts);
+
+    // Read options
+    Function f;
+    for (auto&& op : opts) {
+      if (op.first=="function") {
+        f = op.second;
+      } else if (op.first=="opt_level") {
+        opt_level_ = op.second;
+      }
+    }
+
+    // Sanity checks
+    casadi_assert(!f.is_null(), "The llvm compiler requires option 'function'.");
+    casadi_assert(f.is_a("SXFunction"),
+      "The llvm compiler only supports SXFunction, got '" + f.class_name() + "'.");
+    casadi_assert(!f.has_free(),
+      "Cannot JIT '" + f.name() + "' since variables " + str(f.get_free()) + " are free.");
+    casadi_assert(opt_level_>=0 && opt_level_<=3,
+      "Option 'opt_level' must be in the range 0-3, got " + str(opt_level_) + ".");
+
+    // Get a compiled module, possibly from the process cache
+    module_ = compile(f, opt_level_, verbose_);
+  }
+
+  std::shared_ptr<LlvmModule> LlvmCompiler::
+  compile(const Function& f, casadi_int opt_level, bool verbose) {
+    casadi_int n_instr = f.n_instructions();
+    casadi_int n_in = f.n_in(), n_out = f.n_out();
+
+    // Key identifying the compiled code
+    std::string key = f.name();
+    key.push_back('\0');
+    key_append(key, opt_level);
+    for (casadi_int i=0; i<n_in; ++i) key_append(key, f.nnz_in(i));
+    for (casadi_int i=0; i<n_out; ++i) key_append(key, f.nnz_out(i));
+    for (casadi_int k=0; k<n_instr; ++k) {
+      key_append(key, f.instruction_id(k));
+      for (casadi_int e : f.instruction_input(k)) key_append(key, e);
+      for (casadi_int e : f.instruction_output(k)) key_append(key, e);
+      if (f.instruction_id(k)==OP_CONST) key_append(key, f.instruction_constant(k));
+    }
+
+    // Cache lookup
+    std::lock_guard<std::mutex> lock(cache_mtx);
+    auto it = cache.find(key);
+    if (it!=cache.end()) {
+      std::shared_ptr<LlvmModule> ret = it->second.lock();
+      if (ret) {
+        if (verbose) casadi_message("Reusing compiled code for '" + f.name() + "'.");
+        return ret;
+      }
+    }
+
+    // One-time initialization of the native target
+    static bool target_initialized = !llvm::InitializeNativeTarget()
+      && !llvm::InitializeNativeTargetAsmPrinter();
+    casadi_assert(target_initialized, "Failed to initialize the LLVM native target.");
+
+    // Target machine for the host, including CPU features
+    llvm::orc::JITTargetMachineBuilder jtmb =
+      llvm_check(llvm::orc::JITTargetMachineBuilder::detectHost(), "Cannot detect host");
+    const llvm::CodeGenOpt::Level cg_level[] = {llvm::CodeGenOpt::None,
+      llvm::CodeGenOpt::Less, llvm::CodeGenOpt::Default, llvm::CodeGenOpt::Aggressive};
+    jtmb.setCodeGenOptLevel(cg_level[opt_level]);
+
+    // Create module
+    auto ctx = std::make_unique<llvm::LLVMContext>();
+    auto mod = std::make_unique<llvm::Module>(f.name(), *ctx);
+    mod->setDataLayout(llvm_check(jtmb.getDefaultDataLayoutForTarget(), "No data layout"));
+    mod->setTargetTriple(jtmb.getTargetTriple().str());
+
+    // Types
+    llvm::Type* t_d = llvm::Type::getDoubleTy(*ctx);
+    llvm::Type* t_pd = llvm::PointerType::getUnqual(t_d);
+    llvm::Type* t_ppd = llvm::PointerType::getUnqual(t_pd);
+    llvm::IntegerType* t_int = llvm::IntegerType::get(*ctx, 8*sizeof(casadi_int));
+    llvm::Type* t_i32 = llvm::Type::getInt32Ty(*ctx);
+
+    // int f(const double** arg, double** res, casadi_int* iw, double* w, int mem)
+    llvm::FunctionType* t_eval = llvm::FunctionType::get(t_i32,
+      {t_ppd, t_ppd, llvm::PointerType::getUnqual(t_int), t_pd, t_i32}, false);
+    llvm::Function* fcn = llvm::Function::Create(t_eval, llvm::Function::ExternalLinkage,
+      symbol(f.name()), mod.get());
+    fcn->setDoesNotThrow();
+    llvm::Value* arg = fcn->getArg(0);
+    llvm::Value* res = fcn->getArg(1);
+
+    // Call-back for operations not lowered to native IR
+    llvm::FunctionType* t_fun = llvm::FunctionType::get(t_d, {t_int, t_d, t_d}, false);
+    llvm::Constant* p_fun = llvm::ConstantExpr::getIntToPtr(
+      llvm::ConstantInt::get(llvm::Type::getInt64Ty(*ctx),
+        reinterpret_cast<uint64_t>(&casadi_llvm_fun)),
+      llvm::PointerType::getUnqual(t_fun));
+
+    // Zeros, read in place of missing inputs
+    casadi_int max_nnz_in = 1;
+    for (casadi_int i=0; i<n_in; ++i) max_nnz_in = std::max(max_nnz_in, f.nnz_in(i));
+    llvm::ArrayType* t_zeros = llvm::ArrayType::get(t_d, max_nnz_in);
+    llvm::GlobalVariable* zeros = new llvm::GlobalVariable(*mod, t_zeros, true,
+      llvm::GlobalValue::PrivateLinkage, llvm::ConstantAggregateZero::get(t_zeros), "zeros");
+
+    // All instructions go in a single basic block
+    llvm::BasicBlock* entry = llvm::BasicBlock::Create(*ctx, "entry", fcn);
+    llvm::IRBuilder<> b(entry);
+    llvm::Value* zeros_ptr = b.CreateConstInBoundsGEP2_64(t_zeros, zeros, 0, 0);
+    llvm::Constant* zero = llvm::ConstantFP::get(t_d, 0.);
+    llvm::Constant* one = llvm::ConstantFP::get(t_d, 1.);
+
+    // Helpers
+    auto intrinsic = [&](llvm::Intrinsic::ID id, const std::vector<llvm::Value*>& x) {
+      return b.CreateCall(llvm::Intrinsic::getDeclaration(mod.get(), id, {t_d}), x);
+    };
+    auto nonzero = [&](llvm::Value* x) { return b.CreateFCmpUNE(x, zero);};
+    auto to_double = [&](llvm::Value* x) { return b.CreateUIToFP(x, t_d);};
+
+    // Input pointers, with missing inputs redirected to zeros
+    std::vector<llvm::Value*> in_ptr(n_in, nullptr);
+    // Output nonzeros, (index, value) pairs
+    std::vector<std::vector<std::pair<casadi_int, llvm::Value*> > > out_nz(n_out);
+    // SSA values corresponding to the work vector entries
+    std::vector<llvm::Value*> w(f.sz_w(), nullptr);
+
+    // Lower the instructions
+    for (casadi_int k=0; k<n_instr; ++k) {
+      casadi_int op = f.instruction_id(k);
+      std::vector<casadi_int> o = f.instruction_output(k);
+      std::vector<casadi_int> i = f.instruction_input(k);
+      if (op==OP_INPUT) {
+        llvm::Value*& p = in_ptr[i[0]];
+        if (!p) {
+          p = b.CreateLoad(t_pd, b.CreateConstInBoundsGEP1_64(t_pd, arg, i[0]));
+          p = b.CreateSelect(b.CreateIsNull(p), zeros_ptr, p);
+        }
+        w[o[0]] = b.CreateLoad(t_d, b.CreateConstInBoundsGEP1_64(t_d, p, i[1]));
+        continue;
+      } else if (op==OP_OUTPUT) {
+        out_nz[o[0]].push_back(std::make_pair(o[1], w[i[0]]));
+        continue;
+      } else if (op==OP_CONST) {
+        w[o[0]] = llvm::ConstantFP::get(t_d, f.instruction_constant(k));
+        continue;
+      }
+      llvm::Value* x = w[i.at(0)];
+      llvm::Value* y = i.size()>1 ? w[i[1]] : x;
+      llvm::Value* r;
+      switch (op) {
+        case OP_ASSIGN: r = x; break;
+        case OP_ADD: r = b.CreateFAdd(x, y); break;
+        case OP_SUB: r = b.CreateFSub(x, y); break;
+        case OP_MUL: r = b.CreateFMul(x, y); break;
+        case OP_DIV: r = b.CreateFDiv(x, y); break;
+        case OP_NEG: r = b.CreateFNeg(x); break;
+        case OP_TWICE: r = b.CreateFAdd(x, x); break;
+        case OP_SQ: r = b.CreateFMul(x, x); break;
+        case OP_INV: r = b.CreateFDiv(one, x); break;
+        case OP_LT: r = to_double(b.CreateFCmpOLT(x, y)); break;
+        case OP_LE: r = to_double(b.CreateFCmpOLE(x, y)); break;
+        case OP_EQ: r = to_double(b.CreateFCmpOEQ(x, y)); break;
+        case OP_NE: r = to_double(b.CreateFCmpUNE(x, y)); break;
+        case OP_NOT: r = to_double(b.CreateFCmpOEQ(x, zero)); break;
+        case OP_AND: r = to_double(b.CreateAnd(nonzero(x), nonzero(y))); break;
+        case OP_OR: r = to_double(b.CreateOr(nonzero(x), nonzero(y))); break;
+        case OP_IF_ELSE_ZERO: r = b.CreateSelect(nonzero(x), y, zero); break;
+        case OP_SQRT: r = intrinsic(llvm::Intrinsic::sqrt, {x}); break;
+        case OP_FABS: r = intrinsic(llvm::Intrinsic::fabs, {x}); break;
+        case OP_FLOOR: r = intrinsic(llvm::Intrinsic::floor, {x}); break;
+        case OP_CEIL: r = intrinsic(llvm::Intrinsic::ceil, {x}); break;
+        case OP_EXP: r = intrinsic(llvm::Intrinsic::exp, {x}); break;
+        case OP_LOG: r = intrinsic(llvm::Intrinsic::log, {x}); break;
+        case OP_SIN: r = intrinsic(llvm::Intrinsic::sin, {x}); break;
+        case OP_COS: r = intrinsic(llvm::Intrinsic::cos, {x}); break;
+        case OP_POW:
+        case OP_CONSTPOW: r = intrinsic(llvm::Intrinsic::pow, {x, y}); break;
+        case OP_FMIN: r = intrinsic(llvm::Intrinsic::minnum, {x, y}); break;
+        case OP_FMAX: r = intrinsic(llvm::Intrinsic::maxnum, {x, y}); break;
+        case OP_COPYSIGN: r = intrinsic(llvm::Intrinsic::copysign, {x, y}); break;
+        default:
+          r = b.CreateCall(t_fun, p_fun, {llvm::ConstantInt::get(t_int, op), x, y});
+      }
+      w[o[0]] = r;
+    }
+
+    // Write outputs, skipping null pointers
+    for (casadi_int i=0; i<n_out; ++i) {
+      if (out_nz[i].empty()) continue;
+      llvm::Value* r = b.CreateLoad(t_pd, b.CreateConstInBoundsGEP1_64(t_pd, res, i));
+      llvm::BasicBlock* store = llvm::BasicBlock::Create(*ctx, "store_" + str(i), fcn);
+      llvm::BasicBlock* next = llvm::BasicBlock::Create(*ctx, "next_" + str(i), fcn);
+      b.CreateCondBr(b.CreateIsNull(r), next, store);
+      b.SetInsertPoint(store);
+      for (auto&& e : out_nz[i]) {
+        b.CreateStore(e.second, b.CreateConstInBoundsGEP1_64(t_d, r, e.first));
+      }
+      b.CreateBr(next);
+      b.SetInsertPoint(next);
+    }
+    b.CreateRet(llvm::ConstantInt::get(t_i32, 0));
+
+    // Verify the generated IR
+    std::string err;
+    llvm::raw_string_ostream err_stream(err);
+    casadi_assert(!llvm::verifyFunction(*fcn, &err_stream),
+      "Invalid IR generated for '" + f.name() + "': " + err_stream.str());
+    if (verbose) casadi_message("Lowered " + str(n_instr) + " instructions of '"
+                                + f.name() + "' to LLVM IR.");
+
+    // IR optimization
+    if (opt_level>0) {
+      std::unique_ptr<llvm::TargetMachine> tm =
+        llvm_check(jtmb.createTargetMachine(), "Cannot create target machine");
+      llvm::LoopAnalysisManager lam;
+      llvm::FunctionAnalysisManager fam;
+      llvm::CGSCCAnalysisManager cgam;
+      llvm::ModuleAnalysisManager mam;
+      llvm::PassBuilder pb(tm.get());
+      pb.registerModuleAnalyses(mam);
+      pb.registerCGSCCAnalyses(cgam);
+      pb.registerFunctionAnalyses(fam);
+      pb.registerLoopAnalyses(lam);
+      pb.crossRegisterProxies(lam, fam, cgam, mam);
+      const llvm::OptimizationLevel ir_level[] = {llvm::OptimizationLevel::O0,
+        llvm::OptimizationLevel::O1, llvm::OptimizationLevel::O2,
+        llvm::OptimizationLevel::O3};
+      llvm::ModulePassManager mpm = pb.buildPerModuleDefaultPipeline(ir_level[opt_level]);
+      mpm.run(*mod, mam);
+    }
+
+    // Create the JIT, resolving math functions in the current process
+    auto ret = std::make_shared<LlvmModule>();
+    ret->jit = llvm_check(llvm::orc::LLJITBuilder()
+      .setJITTargetMachineBuilder(std::move(jtmb)).create(), "Cannot create JIT");
+    ret->jit->getMainJITDylib().addGenerator(llvm_check(
+      llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+        ret->jit->getDataLayout().getGlobalPrefix()), "Cannot resolve process symbols"));
+    llvm::Error e = ret->jit->addIRModule(
+      llvm::orc::ThreadSafeModule(std::move(mod), std::move(ctx)));
+    if (e) casadi_error("Cannot add module: " + llvm::toString(std::move(e)));
+
+    // Materialize the machine code right away
+    llvm_check(ret->jit->lookup(symbol(f.name())), "Cannot compile '" + f.name() + "'");
+    if (verbose) casadi_message("Compiled '" + f.name() + "' to machine code.");
+
+    // Store in the cache, dropping expired entries
+    for (auto it = cache.begin(); it!=cache.end();) {
+      if (it->second.expired()) {
+        it = cache.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    cache[key] = ret;
+    return ret;
+  }
+
+  casadi_int LlvmCompiler::cache_size() {
+    std::lock_guard<std::mutex> lock(cache_mtx);
+    casadi_int ret = 0;
+    for (auto&& e : cache) if (!e.second.expired()) ret++;
+    return ret;
+  }
+
+  signal_t LlvmCompiler::get_function(const std::string& symname) {
+    auto sym = module_->jit->lookup(symbol(symname));
+    if (!sym) {
+      llvm::consumeError(sym.takeError());
+      return nullptr;
+    }
+#if LLVM_VERSION_MAJOR>=15
+    return reinterpret_cast<signal_t>(sym->getValue());
+#else
+    return reinterpret_cast<signal_t>(sym->getAddress());
+#endif
+  }
+
+} // namespace casadi
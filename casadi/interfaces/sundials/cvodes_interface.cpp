@@ -122,6 +122,11 @@ namespace casadi {
       casadi_error("Unknown nonlinear solver iteration: " + nonlinear_solver_iteration);
     }
 
+    // Checkpointing within a memory budget
+    checkpoint_budget(max_order_ ? max_order_ : lmm_==CV_ADAMS ? 12 : 5,
+                      interp_==SD_HERMITE ? 2 : 1);
+    seg_sz_ = nx_ + nq_;
+
     // Attach functions for jacobian information
     if (newton_scheme_!=SD_DIRECT || (ns_>0 && second_order_correction_)) {
       create_function("jtimesF", {"t", "x", "p", "fwd:x"}, {"fwd:ode"});
@@ -260,6 +265,29 @@ namespace casadi {
 
     // Set the stop time of the integration -- don't integrate past this point
     if (stop_at_end_) setStopTime(m, grid_.back());
+
+    // Initial state of the first segment
+    if (nrx_>0 && steps_per_segment_>0) save_segment(m);
+  }
+
+  void CvodesInterface::save_segment(CvodesMemory* m) const {
+    m->seg_t.push_back(m->t);
+    m->seg_tout.push_back(m->t);
+    m->seg_data.insert(m->seg_data.end(), NV_DATA_S(m->xz), NV_DATA_S(m->xz)+nx_);
+    m->seg_data.insert(m->seg_data.end(), NV_DATA_S(m->q), NV_DATA_S(m->q)+nq_);
+    m->seg_steps = 0;
+    m->nsegments++;
+  }
+
+  void CvodesInterface::restart_segment(CvodesMemory* m, casadi_int k) const {
+    const double* d = get_ptr(m->seg_data) + k*seg_sz_;
+    m->t = m->seg_t.at(k);
+    casadi_copy(d, nx_, NV_DATA_S(m->xz));
+    casadi_copy(d+nx_, nq_, NV_DATA_S(m->q));
+    THROWING(CVodeReInit, m->mem, m->t, m->xz);
+    if (nq_>0) THROWING(CVodeQuadReInit, m->mem, m->q);
+    THROWING(CVodeAdjReInit, m->mem);
+    if (stop_at_end_) setStopTime(m, grid_.back());
   }
 
   void CvodesInterface::advance(IntegratorMemory* mem, double t, double* x,
@@ -276,7 +304,30 @@ namespace casadi {
 
     // Integrate, unless already at desired time
     const double ttol = 1e-9;
-    if (fabs(m->t-t)>=ttol) {
+    if (nrx_>0 && steps_per_segment_>0) {
+      // Step past t with taping, restarting for every segment. No stop times
+      // other than tf, so that the steps are reproduced when recomputing
+      while (m->t<t) {
+        if (m->seg_steps==steps_per_segment_) {
+          // Keep the counters, start a new segment
+          THROWING(CVodeGetIntegratorStats, m->mem, &m->nsteps, &m->nfevals, &m->nlinsetups,
+                   &m->netfails, &m->qlast, &m->qcur, &m->hinused,
+                   &m->hlast, &m->hcur, &m->tcur);
+          THROWING(CVodeGetNonlinSolvStats, m->mem, &m->nniters, &m->nncfails);
+          segment_stats(m, false, true);
+          save_segment(m);
+          restart_segment(m, m->seg_t.size()-1);
+        }
+        // The output time passed for the first step determines its step size
+        if (m->seg_steps==0) m->seg_tout.back() = t;
+        THROWING(CVodeF, m->mem, t, m->xz, &m->t, CV_ONE_STEP, &m->ncheck);
+        if (nq_>0) {
+          double tret;
+          THROWING(CVodeGetQuad, m->mem, &tret, m->q);
+        }
+        m->seg_steps++;
+      }
+    } else if (fabs(m->t-t)>=ttol) {
       // Integrate forward ...
       if (nrx_>0) {
         // ... with taping
@@ -294,14 +345,25 @@ namespace casadi {
     }
 
     // Set function outputs
-    casadi_copy(NV_DATA_S(m->xz), nx_, x);
-    casadi_copy(NV_DATA_S(m->q), nq_, q);
+    if (nrx_>0 && steps_per_segment_>0 && m->t!=t) {
+      // Interpolate, keeping the state at the last step
+      THROWING(CVodeGetDky, m->mem, t, 0, m->xz_dky);
+      casadi_copy(NV_DATA_S(m->xz_dky), nx_, x);
+      if (nq_>0) {
+        THROWING(CVodeGetQuadDky, m->mem, t, 0, m->q_dky);
+        casadi_copy(NV_DATA_S(m->q_dky), nq_, q);
+      }
+    } else {
+      casadi_copy(NV_DATA_S(m->xz), nx_, x);
+      casadi_copy(NV_DATA_S(m->q), nq_, q);
+    }
 
     // Get stats
     THROWING(CVodeGetIntegratorStats, m->mem, &m->nsteps, &m->nfevals, &m->nlinsetups,
              &m->netfails, &m->qlast, &m->qcur, &m->hinused,
              &m->hlast, &m->hcur, &m->tcur);
     THROWING(CVodeGetNonlinSolvStats, m->mem, &m->nniters, &m->nncfails);
+    segment_stats(m, false, false);
   }
 
   void CvodesInterface::resetB(IntegratorMemory* mem, double t, const double* rx,
@@ -359,7 +421,46 @@ namespace casadi {
                                 double* rx, double* rz, double* rq) const {
     auto m = to_mem(mem);
     // Integrate, unless already at desired time
-    if (t<m->t) {
+    if (t<m->t && steps_per_segment_>0) {
+      // Segment by segment, only the last one is taped
+      while (true) {
+        casadi_int k = m->seg_t.size()-1;
+        double tk = std::max(t, m->seg_t[k]);
+        THROWING(CVodeB, m->mem, tk, CV_NORMAL);
+        THROWING(CVodeGetB, m->mem, m->whichB, &m->t, m->rxz);
+        if (nrq_>0) {
+          THROWING(CVodeGetQuadB, m->mem, m->whichB, &m->t, m->rq);
+        }
+        if (tk==t) break;
+
+        // Keep the counters of the backward problem
+        CVodeMem cv_mem = static_cast<CVodeMem>(m->mem);
+        CVodeMem cvB_mem = cv_mem->cv_adj_mem->cvB_mem->cv_mem;
+        THROWING(CVodeGetIntegratorStats, cvB_mem, &m->nstepsB,
+               &m->nfevalsB, &m->nlinsetupsB, &m->netfailsB, &m->qlastB,
+               &m->qcurB, &m->hinusedB, &m->hlastB, &m->hcurB, &m->tcurB);
+        THROWING(CVodeGetNonlinSolvStats, cvB_mem, &m->nnitersB, &m->nncfailsB);
+        segment_stats(m, true, true);
+
+        // Drop the consumed segment, tape the previous one again with the same steps
+        double tB = m->t;
+        m->seg_t.pop_back();
+        m->seg_tout.pop_back();
+        m->seg_data.resize(k*seg_sz_);
+        restart_segment(m, k-1);
+        double tout = m->seg_tout[k-1];
+        while (m->t<tB) {
+          THROWING(CVodeF, m->mem, tout, m->xz, &m->t, CV_ONE_STEP, &m->ncheck);
+          tout = tB;
+          m->nrecompute++;
+        }
+
+        // Continue the backward problem from the end of the segment
+        THROWING(CVodeReInitB, m->mem, m->whichB, tB, m->rxz);
+        THROWING(CVodeQuadReInitB, m->mem, m->whichB, m->rq);
+        m->t = tB;
+      }
+    } else if (t<m->t) {
       THROWING(CVodeB, m->mem, t, CV_NORMAL);
       THROWING(CVodeGetB, m->mem, m->whichB, &m->t, m->rxz);
       if (nrq_>0) {
@@ -379,6 +480,7 @@ namespace casadi {
            &m->nfevalsB, &m->nlinsetupsB, &m->netfailsB, &m->qlastB,
            &m->qcurB, &m->hinusedB, &m->hlastB, &m->hcurB, &m->tcurB);
     THROWING(CVodeGetNonlinSolvStats, cvB_mem->cv_mem, &m->nnitersB, &m->nncfailsB);
+    segment_stats(m, true, false);
   }
 
   void CvodesInterface::cvodes_error(const char* module, int flag) {
@@ -639,18 +741,44 @@ namespace casadi {
       // Store gamma for later
       m->gamma = gamma;
 
-      // Calculate Jacobian
-      double d1 = -gamma, d2 = 1.;
-      m->arg[0] = &t;
-      m->arg[1] = NV_DATA_S(x);
-      m->arg[2] = m->p;
-      m->arg[3] = &d1;
-      m->arg[4] = &d2;
-      m->res[0] = m->jac;
-      if (s.calc_function(m, "jacF")) casadi_error("'jacF' calculation failed");
+      if (s.reuse_jacobian_) {
+        // Reevaluate the Jacobian only if rejected by CVODES or too old
+        auto cv_mem = static_cast<CVodeMem>(m->mem);
+        if (!jok || cv_mem->cv_nst >= m->nstlj + s.max_jacobian_age_) {
+          double d1 = 1., d2 = 0.;
+          m->arg[0] = &t;
+          m->arg[1] = NV_DATA_S(x);
+          m->arg[2] = m->p;
+          m->arg[3] = &d1;
+          m->arg[4] = &d2;
+          m->res[0] = m->jac0;
+          if (s.calc_function(m, "jacF")) casadi_error("'jacF' calculation failed");
+          m->nstlj = cv_mem->cv_nst;
+          m->njevals++;
+          *jcurPtr = TRUE;
+        } else {
+          *jcurPtr = FALSE;
+        }
+
+        // Newton matrix I - gamma*J
+        s.jac_from_saved(m, -gamma, 1.);
+      } else {
+        // Calculate Jacobian
+        double d1 = -gamma, d2 = 1.;
+        m->arg[0] = &t;
+        m->arg[1] = NV_DATA_S(x);
+        m->arg[2] = m->p;
+        m->arg[3] = &d1;
+        m->arg[4] = &d2;
+        m->res[0] = m->jac;
+        if (s.calc_function(m, "jacF")) casadi_error("'jacF' calculation failed");
+        m->njevals++;
+        *jcurPtr = TRUE;
+      }
 
       // Prepare the solution of the linear system (e.g. factorize)
       if (s.linsolF_.nfact(m->jac, m->mem_linsolF)) casadi_error("'jacF' factorization failed");
+      m->nfacts++;
 
       return 0;
     } catch(int flag) { // recoverable error
@@ -681,9 +809,12 @@ namespace casadi {
       m->arg[6] = &one;
       m->res[0] = m->jacB;
       if (s.calc_function(m, "jacB")) casadi_error("'jacB' calculation failed");
+      m->njevalsB++;
+      *jcurPtrB = TRUE;
 
       // Prepare the solution of the linear system (e.g. factorize)
       if (s.linsolB_.nfact(m->jacB, m->mem_linsolB)) casadi_error("'jacB' factorization failed");
+      m->nfactsB++;
 
       return 0;
     } catch(int flag) { // recoverable error
@@ -707,8 +838,12 @@ namespace casadi {
       // Scaling factor before J
       double gamma = cv_mem->cv_gamma;
 
+      // Can the Jacobian be reused? Same test as in the CVDLS linear solvers
+      booleantype jok = cv_mem->cv_nst>0 && convfail!=CV_FAIL_OTHER
+        && !(convfail==CV_FAIL_BAD_J && fabs(gamma/cv_mem->cv_gammap - 1) < 0.2);
+
       // Call the preconditioner setup function (which sets up the linear solver)
-      if (psetup(t, x, xdot, FALSE, jcurPtr,
+      if (psetup(t, x, xdot, jok, jcurPtr,
                  gamma, static_cast<void*>(m), vtemp1, vtemp2, vtemp3)) return 1;
 
       return 0;
@@ -128,6 +128,12 @@ namespace casadi {
     void advance(IntegratorMemory* mem, double t, double* x,
                          double* z, double* q) const override;
 
+    /** \brief Store the current state as the initial state of a new segment */
+    void save_segment(CvodesMemory* m) const;
+
+    /** \brief Reinitialize the forward problem and its taping at the start of segment k */
+    void restart_segment(CvodesMemory* m, casadi_int k) const;
+
     /** \brief  Reset the backward problem and take time to tf */
     void resetB(IntegratorMemory* mem, double t,
                         const double* rx, const double* rz, const double* rp) const override;
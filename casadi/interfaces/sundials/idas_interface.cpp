@@ -157,6 +157,11 @@ namespace casadi {
       + str(y_c_.size()) + " and nx+nz = " + str(nx_+nz_) + ".");
 
 
+    // Checkpointing within a memory budget
+    checkpoint_budget(max_order_ ? max_order_ : max_multistep_order_,
+                      interp_==SD_HERMITE ? 2 : 1);
+    seg_sz_ = 2*(nx_+nz_) + nq_;
+
     // Attach functions for jacobian information
     if (newton_scheme_!=SD_DIRECT || (ns_>0 && second_order_correction_)) {
       create_function("jtimesF",
@@ -429,6 +434,31 @@ namespace casadi {
 
     // Set the stop time of the integration -- don't integrate past this point
     if (stop_at_end_) setStopTime(m, grid_.back());
+
+    // Initial state of the first segment
+    if (nrx_>0 && steps_per_segment_>0) save_segment(m);
+  }
+
+  void IdasInterface::save_segment(IdasMemory* m) const {
+    m->seg_t.push_back(m->t);
+    m->seg_tout.push_back(m->t);
+    m->seg_data.insert(m->seg_data.end(), NV_DATA_S(m->xz), NV_DATA_S(m->xz)+nx_+nz_);
+    m->seg_data.insert(m->seg_data.end(), NV_DATA_S(m->xzdot), NV_DATA_S(m->xzdot)+nx_+nz_);
+    m->seg_data.insert(m->seg_data.end(), NV_DATA_S(m->q), NV_DATA_S(m->q)+nq_);
+    m->seg_steps = 0;
+    m->nsegments++;
+  }
+
+  void IdasInterface::restart_segment(IdasMemory* m, casadi_int k) const {
+    const double* d = get_ptr(m->seg_data) + k*seg_sz_;
+    m->t = m->seg_t.at(k);
+    casadi_copy(d, nx_+nz_, NV_DATA_S(m->xz));
+    casadi_copy(d+nx_+nz_, nx_+nz_, NV_DATA_S(m->xzdot));
+    casadi_copy(d+2*(nx_+nz_), nq_, NV_DATA_S(m->q));
+    THROWING(IDAReInit, m->mem, m->t, m->xz, m->xzdot);
+    if (nq_>0) THROWING(IDAQuadReInit, m->mem, m->q);
+    THROWING(IDAAdjReInit, m->mem);
+    if (stop_at_end_) setStopTime(m, grid_.back());
   }
 
   void IdasInterface::
@@ -445,7 +475,30 @@ namespace casadi {
 
     // Integrate, unless already at desired time
     double ttol = 1e-9;   // tolerance
-    if (fabs(m->t-t)>=ttol) {
+    if (nrx_>0 && steps_per_segment_>0) {
+      // Step past t with taping, restarting for every segment. No stop times
+      // other than tf, so that the steps are reproduced when recomputing
+      while (m->t<t) {
+        if (m->seg_steps==steps_per_segment_) {
+          // Keep the counters, start a new segment
+          THROWING(IDAGetIntegratorStats, m->mem, &m->nsteps, &m->nfevals, &m->nlinsetups,
+                   &m->netfails, &m->qlast, &m->qcur, &m->hinused,
+                   &m->hlast, &m->hcur, &m->tcur);
+          THROWING(IDAGetNonlinSolvStats, m->mem, &m->nniters, &m->nncfails);
+          segment_stats(m, false, true);
+          save_segment(m);
+          restart_segment(m, m->seg_t.size()-1);
+        }
+        // The output time passed for the first step determines its step size
+        if (m->seg_steps==0) m->seg_tout.back() = t;
+        THROWING(IDASolveF, m->mem, t, &m->t, m->xz, m->xzdot, IDA_ONE_STEP, &m->ncheck);
+        if (nq_>0) {
+          double tret;
+          THROWING(IDAGetQuad, m->mem, &tret, m->q);
+        }
+        m->seg_steps++;
+      }
+    } else if (fabs(m->t-t)>=ttol) {
       // Integrate forward ...
       if (nrx_>0) { // ... with taping
         THROWING(IDASolveF, m->mem, t, &m->t, m->xz, m->xzdot, IDA_NORMAL, &m->ncheck);
@@ -461,16 +514,27 @@ namespace casadi {
     }
 
     // Set function outputs
-    casadi_copy(NV_DATA_S(m->xz), nx_, x);
-    casadi_copy(NV_DATA_S(m->xz)+nx_, nz_, z);
-    casadi_copy(NV_DATA_S(m->q), nq_, q);
+    if (nrx_>0 && steps_per_segment_>0 && m->t!=t) {
+      // Interpolate, keeping the state at the last step
+      THROWING(IDAGetDky, m->mem, t, 0, m->xz_dky);
+      casadi_copy(NV_DATA_S(m->xz_dky), nx_, x);
+      casadi_copy(NV_DATA_S(m->xz_dky)+nx_, nz_, z);
+      if (nq_>0) {
+        THROWING(IDAGetQuadDky, m->mem, t, 0, m->q_dky);
+        casadi_copy(NV_DATA_S(m->q_dky), nq_, q);
+      }
+    } else {
+      casadi_copy(NV_DATA_S(m->xz), nx_, x);
+      casadi_copy(NV_DATA_S(m->xz)+nx_, nz_, z);
+      casadi_copy(NV_DATA_S(m->q), nq_, q);
+    }
 
     // Get stats
     THROWING(IDAGetIntegratorStats, m->mem, &m->nsteps, &m->nfevals, &m->nlinsetups,
              &m->netfails, &m->qlast, &m->qcur, &m->hinused,
              &m->hlast, &m->hcur, &m->tcur);
     THROWING(IDAGetNonlinSolvStats, m->mem, &m->nniters, &m->nncfails);
-
+    segment_stats(m, false, false);
   }
 
   void IdasInterface::resetB(IntegratorMemory* mem, double t, const double* rx,
@@ -557,7 +621,49 @@ namespace casadi {
     auto m = to_mem(mem);
 
     // Integrate, unless already at desired time
-    if (t<m->t) {
+    if (t<m->t && steps_per_segment_>0) {
+      // Segment by segment, only the last one is taped
+      while (true) {
+        casadi_int k = m->seg_t.size()-1;
+        double tk = std::max(t, m->seg_t[k]);
+        THROWING(IDASolveB, m->mem, tk, IDA_NORMAL);
+        THROWING(IDAGetB, m->mem, m->whichB, &m->t, m->rxz, m->rxzdot);
+        if (nrq_>0) {
+          THROWING(IDAGetQuadB, m->mem, m->whichB, &m->t, m->rq);
+        }
+        if (tk==t) break;
+
+        // Keep the counters of the backward problem
+        IDAMem IDAB_mem = IDAMem(m->mem)->ida_adj_mem->IDAB_mem->IDA_mem;
+        THROWING(IDAGetIntegratorStats, IDAB_mem, &m->nstepsB, &m->nfevalsB,
+                 &m->nlinsetupsB, &m->netfailsB, &m->qlastB, &m->qcurB, &m->hinusedB,
+                 &m->hlastB, &m->hcurB, &m->tcurB);
+        THROWING(IDAGetNonlinSolvStats, IDAB_mem, &m->nnitersB, &m->nncfailsB);
+        segment_stats(m, true, true);
+
+        // Drop the consumed segment, tape the previous one again with the same steps
+        double tB = m->t;
+        m->seg_t.pop_back();
+        m->seg_tout.pop_back();
+        m->seg_data.resize(k*seg_sz_);
+        restart_segment(m, k-1);
+        double tout = m->seg_tout[k-1];
+        while (m->t<tB) {
+          THROWING(IDASolveF, m->mem, tout, &m->t, m->xz, m->xzdot, IDA_ONE_STEP, &m->ncheck);
+          tout = tB;
+          m->nrecompute++;
+        }
+
+        // Continue the backward problem from the end of the segment
+        THROWING(IDAReInitB, m->mem, m->whichB, tB, m->rxz, m->rxzdot);
+        if (nrq_>0) {
+          // Workaround (bug in SUNDIALS), cf. resetB
+          void* memB = IDAGetAdjIDABmem(m->mem, m->whichB);
+          THROWING(IDAQuadReInit, memB, m->rq);
+        }
+        m->t = tB;
+      }
+    } else if (t<m->t) {
       THROWING(IDASolveB, m->mem, t, IDA_NORMAL);
       THROWING(IDAGetB, m->mem, m->whichB, &m->t, m->rxz, m->rxzdot);
       if (nrq_>0) {
@@ -578,6 +684,7 @@ namespace casadi {
              &m->nlinsetupsB, &m->netfailsB, &m->qlastB, &m->qcurB, &m->hinusedB,
              &m->hlastB, &m->hcurB, &m->tcurB);
     THROWING(IDAGetNonlinSolvStats, IDAB_mem->IDA_mem, &m->nnitersB, &m->nncfailsB);
+    segment_stats(m, true, false);
   }
 
   void IdasInterface::idas_error(const char* module, int flag) {
@@ -840,16 +947,40 @@ namespace casadi {
     try {
       auto m = to_mem(user_data);
       auto& s = m->self;
-      m->arg[0] = &t;
-      m->arg[1] = NV_DATA_S(xz);
-      m->arg[2] = NV_DATA_S(xz)+s.nx_;
-      m->arg[3] = m->p;
-      m->arg[4] = &cj;
-      m->res[0] = m->jac;
-      if (s.calc_function(m, "jacF")) casadi_error("Calculating Jacobian failed");
+      if (s.reuse_jacobian_) {
+        // Reevaluate the Jacobian if too old or after a convergence failure
+        auto ida_mem = static_cast<IDAMem>(m->mem);
+        if (ida_mem->ida_nst==0 || ida_mem->ida_nst >= m->nstlj + s.max_jacobian_age_
+            || ida_mem->ida_ncfn > m->ncfnlj) {
+          double cj0 = 0;
+          m->arg[0] = &t;
+          m->arg[1] = NV_DATA_S(xz);
+          m->arg[2] = NV_DATA_S(xz)+s.nx_;
+          m->arg[3] = m->p;
+          m->arg[4] = &cj0;
+          m->res[0] = m->jac0;
+          if (s.calc_function(m, "jacF")) casadi_error("Calculating Jacobian failed");
+          m->nstlj = ida_mem->ida_nst;
+          m->ncfnlj = ida_mem->ida_ncfn;
+          m->njevals++;
+        }
+
+        // Iteration matrix with the current cj
+        s.jac_from_saved(m, 1., -cj);
+      } else {
+        m->arg[0] = &t;
+        m->arg[1] = NV_DATA_S(xz);
+        m->arg[2] = NV_DATA_S(xz)+s.nx_;
+        m->arg[3] = m->p;
+        m->arg[4] = &cj;
+        m->res[0] = m->jac;
+        if (s.calc_function(m, "jacF")) casadi_error("Calculating Jacobian failed");
+        m->njevals++;
+      }
 
       // Factorize the linear system
       if (s.linsolF_.nfact(m->jac, m->mem_linsolF)) casadi_error("Linear solve failed");
+      m->nfacts++;
 
       return 0;
     } catch(int flag) { // recoverable error
@@ -877,9 +1008,11 @@ namespace casadi {
       m->arg[7] = &cj;
       m->res[0] = m->jacB;
       if (s.calc_function(m, "jacB")) casadi_error("'jacB' calculation failed");
+      m->njevalsB++;
 
       // Factorize the linear system
       if (s.linsolB_.nfact(m->jacB, m->mem_linsolB)) casadi_error("'jacB' factorization failed");
+      m->nfactsB++;
 
       return 0;
     } catch(int flag) { // recoverable error
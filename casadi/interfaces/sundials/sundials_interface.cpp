@@ -104,7 +104,23 @@ namespace casadi {
         "Maximum order"}},
       {"nonlin_conv_coeff",
        {OT_DOUBLE,
-        "Coefficient in the nonlinear convergence test"}}
+        "Coefficient in the nonlinear convergence test"}},
+      {"reuse_jacobian",
+       {OT_BOOL,
+        "Reuse the Jacobian of the forward problem in linear solver setups, "
+        "reevaluating it only when older than max_jacobian_age steps or after "
+        "a failure of the Newton iteration [false]"}},
+      {"max_jacobian_age",
+       {OT_INT,
+        "Maximum number of steps between Jacobian evaluations "
+        "with reuse_jacobian [50]"}},
+      {"max_checkpoint_memory",
+       {OT_DOUBLE,
+        "Memory budget in MB for the adjoint sensitivity data of the forward "
+        "problem. If set, steps_per_checkpoint is chosen automatically and the "
+        "taping is restarted when the budget is reached, at the cost of "
+        "recomputing the forward problem segment by segment during the "
+        "backward integration [0: unlimited]"}}
      }
   };
 
@@ -135,6 +151,11 @@ namespace casadi {
     max_step_size_ = 0;
     max_order_ = 0;
     nonlin_conv_coeff_ = 0;
+    reuse_jacobian_ = false;
+    max_jacobian_age_ = 50;
+    max_checkpoint_memory_ = 0;
+    steps_per_segment_ = 0;
+    seg_sz_ = 0;
 
     // Read options
     for (auto&& op : opts) {
@@ -176,6 +197,12 @@ namespace casadi {
         max_order_ = op.second;
       } else if (op.first=="nonlin_conv_coeff") {
         nonlin_conv_coeff_ = op.second;
+      } else if (op.first=="reuse_jacobian") {
+        reuse_jacobian_ = op.second;
+      } else if (op.first=="max_jacobian_age") {
+        max_jacobian_age_ = op.second;
+      } else if (op.first=="max_checkpoint_memory") {
+        max_checkpoint_memory_ = op.second;
       }
     }
 
@@ -228,9 +255,26 @@ namespace casadi {
     alloc_w(nrp_, true); // rp
     alloc_w(2*max(nx_+nz_, nrx_+nrz_), true); // v1, v2
 
+    // Saved Jacobian of the forward problem
+    const Sparsity& sp_jacF = get_function("jacF").sparsity_out(0);
+    if (reuse_jacobian_) {
+      casadi_assert(max_jacobian_age_>=1, "Option 'max_jacobian_age' must be positive");
+      alloc_w(sp_jacF.nnz(), true);
+
+      // Locate the identity term of the state block in the forward Jacobian
+      jac_diag_.resize(nx1_);
+      const casadi_int *colind = sp_jacF.colind(), *row = sp_jacF.row();
+      for (casadi_int c=0; c<nx1_; ++c) {
+        jac_diag_[c] = -1;
+        for (casadi_int k=colind[c]; k<colind[c+1]; ++k) {
+          if (row[k]==c) jac_diag_[c] = k;
+        }
+        casadi_assert_dev(jac_diag_[c]>=0);
+      }
+    }
+
     // Allocate linear solvers
-    linsolF_ = Linsol("linsolF", linear_solver_,
-      get_function("jacF").sparsity_out(0), linear_solver_options_);
+    linsolF_ = Linsol("linsolF", linear_solver_, sp_jacF, linear_solver_options_);
     if (nrx_>0) {
       linsolB_ = Linsol("linsolB", linear_solver_,
         get_function("jacB").sparsity_out(0), linear_solver_options_);
@@ -246,6 +290,10 @@ namespace casadi {
     m->q = N_VNew_Serial(nq_);
     m->rxz = N_VNew_Serial(nrx_+nrz_);
     m->rq = N_VNew_Serial(nrq_);
+    if (steps_per_segment_>0) {
+      m->xz_dky = N_VNew_Serial(nx_+nz_);
+      m->q_dky = N_VNew_Serial(nq_);
+    }
 
     m->mem_linsolF = linsolF_.checkout();
     if (!linsolB_.is_null()) m->mem_linsolB = linsolB_.checkout();
@@ -277,6 +325,20 @@ namespace casadi {
 
     // Reset summation states
     N_VConst(0., m->q);
+
+    // Reset counters, the saved Jacobian is reevaluated in the first step
+    m->njevals = m->nfacts = 0;
+    m->nstlj = m->ncfnlj = 0;
+
+    // No segments yet
+    m->seg_t.clear();
+    m->seg_data.clear();
+    m->seg_tout.clear();
+    m->seg_steps = 0;
+    m->nsegments = 0;
+    m->nrecompute = 0;
+    m->nsteps_seg = m->nfevals_seg = m->nlinsetups_seg = 0;
+    m->netfails_seg = m->nniters_seg = m->nncfails_seg = 0;
   }
 
   void SundialsInterface::resetB(IntegratorMemory* mem, double t, const double* rx,
@@ -294,19 +356,96 @@ namespace casadi {
 
     // Reset summation states
     N_VConst(0., m->rq);
+
+    // Reset counters
+    m->njevalsB = m->nfactsB = 0;
+    m->nstepsB_seg = m->nfevalsB_seg = m->nlinsetupsB_seg = 0;
+    m->netfailsB_seg = m->nnitersB_seg = m->nncfailsB_seg = 0;
+  }
+
+  void SundialsInterface::checkpoint_budget(casadi_int order, casadi_int nv) {
+    if (max_checkpoint_memory_<=0 || nrx_==0) return;
+    // Budget, in doubles
+    double b = max_checkpoint_memory_*(1 << 20)/sizeof(double);
+    // Size of a checkpoint and of the interpolation data for a step
+    double ck = static_cast<double>((order+1)*(nx_+nz_+nq_));
+    double st = static_cast<double>(nv*(nx_+nz_));
+    // Steps per checkpoint maximizing the segment length
+    casadi_int nd = std::max(static_cast<casadi_int>((b-ck-st)/(2*st)), casadi_int(1));
+    // Number of checkpoints per segment
+    casadi_int nck = static_cast<casadi_int>((b-(nd+1)*st)/ck) - 1;
+    casadi_assert(nck>=1, "'max_checkpoint_memory' too small, need at least "
+      + str(((nd+1)*st + 2*ck)*sizeof(double)/(1 << 20)) + " MB");
+    steps_per_checkpoint_ = nd;
+    steps_per_segment_ = nd*nck;
+    if (verbose_) {
+      casadi_message("Checkpointing with " + str(steps_per_checkpoint_) + " steps per "
+        "checkpoint, " + str(steps_per_segment_) + " steps per segment");
+    }
+  }
+
+  void SundialsInterface::segment_stats(SundialsMemory* m, bool backward, bool restart) const {
+    if (backward) {
+      if (restart) {
+        m->nstepsB_seg += m->nstepsB;
+        m->nfevalsB_seg += m->nfevalsB;
+        m->nlinsetupsB_seg += m->nlinsetupsB;
+        m->netfailsB_seg += m->netfailsB;
+        m->nnitersB_seg += m->nnitersB;
+        m->nncfailsB_seg += m->nncfailsB;
+      } else {
+        m->nstepsB += m->nstepsB_seg;
+        m->nfevalsB += m->nfevalsB_seg;
+        m->nlinsetupsB += m->nlinsetupsB_seg;
+        m->netfailsB += m->netfailsB_seg;
+        m->nnitersB += m->nnitersB_seg;
+        m->nncfailsB += m->nncfailsB_seg;
+      }
+    } else {
+      if (restart) {
+        m->nsteps_seg += m->nsteps;
+        m->nfevals_seg += m->nfevals;
+        m->nlinsetups_seg += m->nlinsetups;
+        m->netfails_seg += m->netfails;
+        m->nniters_seg += m->nniters;
+        m->nncfails_seg += m->nncfails;
+      } else {
+        m->nsteps += m->nsteps_seg;
+        m->nfevals += m->nfevals_seg;
+        m->nlinsetups += m->nlinsetups_seg;
+        m->netfails += m->netfails_seg;
+        m->nniters += m->nniters_seg;
+        m->nncfails += m->nncfails_seg;
+      }
+    }
+  }
+
+  void SundialsInterface::jac_from_saved(SundialsMemory* m, double c, double d) const {
+    casadi_int nnz = linsolF_.sparsity().nnz();
+    casadi_copy(m->jac0, nnz, m->jac);
+    casadi_scal(nnz, c, m->jac);
+    for (casadi_int k : jac_diag_) m->jac[k] += d;
   }
 
   SundialsMemory::SundialsMemory() {
     this->xz  = nullptr;
     this->q = nullptr;
+    this->xz_dky = nullptr;
+    this->q_dky = nullptr;
     this->rxz = nullptr;
     this->rq = nullptr;
     this->first_callB = true;
+    this->njevals = this->nfacts = this->njevalsB = this->nfactsB = 0;
+    this->seg_steps = 0;
+    this->nsegments = 0;
+    this->nrecompute = 0;
   }
 
   SundialsMemory::~SundialsMemory() {
     if (this->xz) N_VDestroy_Serial(this->xz);
     if (this->q) N_VDestroy_Serial(this->q);
+    if (this->xz_dky) N_VDestroy_Serial(this->xz_dky);
+    if (this->q_dky) N_VDestroy_Serial(this->q_dky);
     if (this->rxz) N_VDestroy_Serial(this->rxz);
     if (this->rq) N_VDestroy_Serial(this->rq);
   }
@@ -328,6 +467,10 @@ namespace casadi {
     stats["tcur"] = m->tcur;
     stats["nniters"] = static_cast<casadi_int>(m->nniters);
     stats["nncfails"] = static_cast<casadi_int>(m->nncfails);
+    stats["njevals"] = static_cast<casadi_int>(m->njevals);
+    stats["nfacts"] = static_cast<casadi_int>(m->nfacts);
+    stats["nsegments"] = m->nsegments;
+    stats["nrecompute"] = static_cast<casadi_int>(m->nrecompute);
 
     // Counters, backward problem
     stats["nstepsB"] = static_cast<casadi_int>(m->nstepsB);
@@ -342,6 +485,8 @@ namespace casadi {
     stats["tcurB"] = m->tcurB;
     stats["nnitersB"] = static_cast<casadi_int>(m->nnitersB);
     stats["nncfailsB"] = static_cast<casadi_int>(m->nncfailsB);
+    stats["njevalsB"] = static_cast<casadi_int>(m->njevalsB);
+    stats["nfactsB"] = static_cast<casadi_int>(m->nfactsB);
     return stats;
   }
 
@@ -360,6 +505,12 @@ namespace casadi {
     print("Current internal time reached: %g\n");
     print("Number of nonlinear iterations performed: %ld\n", m->nniters);
     print("Number of nonlinear convergence failures: %ld\n", m->nncfails);
+    print("Number of Jacobian evaluations: %ld\n", m->njevals);
+    print("Number of numeric factorizations: %ld\n", m->nfacts);
+    if (steps_per_segment_>0) {
+      print("Number of segments: %ld\n", static_cast<long>(m->nsegments));
+      print("Number of steps recomputed: %ld\n", m->nrecompute);
+    }
     if (nrx_>0) {
       print("BACKWARD INTEGRATION:\n");
       print("Number of steps taken by SUNDIALS: %ld\n", m->nstepsB);
@@ -374,6 +525,8 @@ namespace casadi {
       print("Current internal time reached: %g\n", m->tcurB);
       print("Number of nonlinear iterations performed: %ld\n", m->nnitersB);
       print("Number of nonlinear convergence failures: %ld\n", m->nncfailsB);
+      print("Number of Jacobian evaluations: %ld\n", m->njevalsB);
+      print("Number of numeric factorizations: %ld\n", m->nfactsB);
     }
     print("\n");
   }
@@ -391,13 +544,16 @@ namespace casadi {
     m->v1 = w; w += max(nx_+nz_, nrx_+nrz_);
     m->v2 = w; w += max(nx_+nz_, nrx_+nrz_);
     m->jac = w; w += get_function("jacF").nnz_out(0);
+    if (reuse_jacobian_) {
+      m->jac0 = w; w += get_function("jacF").nnz_out(0);
+    }
     if (nrx_>0) {
       m->jacB = w; w += get_function("jacB").nnz_out(0);
     }
   }
 
   SundialsInterface::SundialsInterface(DeserializingStream& s) : Integrator(s) {
-    int version = s.version("SundialsInterface", 1, 2);
+    int version = s.version("SundialsInterface", 1, 4);
     s.unpack("SundialsInterface::abstol", abstol_);
     s.unpack("SundialsInterface::reltol", reltol_);
     s.unpack("SundialsInterface::max_num_steps", max_num_steps_);
@@ -422,6 +578,23 @@ namespace casadi {
 
     s.unpack("SundialsInterface::nonlin_conv_coeff", nonlin_conv_coeff_);
     s.unpack("SundialsInterface::max_order", max_order_);
+    if (version>=3) {
+      s.unpack("SundialsInterface::reuse_jacobian", reuse_jacobian_);
+      s.unpack("SundialsInterface::max_jacobian_age", max_jacobian_age_);
+      s.unpack("SundialsInterface::jac_diag", jac_diag_);
+    } else {
+      reuse_jacobian_ = false;
+      max_jacobian_age_ = 50;
+    }
+    if (version>=4) {
+      s.unpack("SundialsInterface::max_checkpoint_memory", max_checkpoint_memory_);
+      s.unpack("SundialsInterface::steps_per_segment", steps_per_segment_);
+      s.unpack("SundialsInterface::seg_sz", seg_sz_);
+    } else {
+      max_checkpoint_memory_ = 0;
+      steps_per_segment_ = 0;
+      seg_sz_ = 0;
+    }
 
     s.unpack("SundialsInterface::linsolF", linsolF_);
     s.unpack("SundialsInterface::linsolB", linsolB_);
@@ -438,7 +611,7 @@ namespace casadi {
 
   void SundialsInterface::serialize_body(SerializingStream &s) const {
     Integrator::serialize_body(s);
-    s.version("SundialsInterface", 2);
+    s.version("SundialsInterface", 4);
     s.pack("SundialsInterface::abstol", abstol_);
     s.pack("SundialsInterface::reltol", reltol_);
     s.pack("SundialsInterface::max_num_steps", max_num_steps_);
@@ -459,6 +632,12 @@ namespace casadi {
 
     s.pack("SundialsInterface::nonlin_conv_coeff", nonlin_conv_coeff_);
     s.pack("SundialsInterface::max_order", max_order_);
+    s.pack("SundialsInterface::reuse_jacobian", reuse_jacobian_);
+    s.pack("SundialsInterface::max_jacobian_age", max_jacobian_age_);
+    s.pack("SundialsInterface::jac_diag", jac_diag_);
+    s.pack("SundialsInterface::max_checkpoint_memory", max_checkpoint_memory_);
+    s.pack("SundialsInterface::steps_per_segment", steps_per_segment_);
+    s.pack("SundialsInterface::seg_sz", seg_sz_);
 
     s.pack("SundialsInterface::linsolF", linsolF_);
     s.pack("SundialsInterface::linsolB", linsolB_);
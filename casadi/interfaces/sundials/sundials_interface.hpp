@@ -47,6 +47,9 @@ namespace casadi {
     // N-vectors for the forward integration
     N_Vector xz, xzdot, q;
 
+    // N-vectors for outputs interpolated between steps
+    N_Vector xz_dky, q_dky;
+
     // N-vectors for the backward integration
     N_Vector rxz, rxzdot, rq;
 
@@ -59,6 +62,12 @@ namespace casadi {
     // Jacobian
     double *jac, *jacB;
 
+    // Jacobian of the forward problem without the identity term, kept for reuse
+    double *jac0;
+
+    // Step number and convergence failures at the last forward Jacobian evaluation
+    long nstlj, ncfnlj;
+
     /// Stats
     long nsteps, nfevals, nlinsetups, netfails;
     int qlast, qcur;
@@ -70,6 +79,29 @@ namespace casadi {
     double hinusedB, hlastB, hcurB, tcurB;
     long nnitersB, nncfailsB;
 
+    // Jacobian evaluations and numeric factorizations
+    long njevals, nfacts, njevalsB, nfactsB;
+
+    // Start times and initial states of the segments of the forward problem
+    std::vector<double> seg_t, seg_data;
+
+    // Output time passed for the first step of each segment, sets its step size.
+    // The steps that follow only require an output time that lies ahead
+    std::vector<double> seg_tout;
+
+    // Segments created by the forward problem
+    casadi_int nsegments;
+
+    // Steps taken in the current segment
+    casadi_int seg_steps;
+
+    // Forward steps recomputed during the backward integration
+    long nrecompute;
+
+    // Counters from earlier segments, forward and backward problems
+    long nsteps_seg, nfevals_seg, nlinsetups_seg, netfails_seg, nniters_seg, nncfails_seg;
+    long nstepsB_seg, nfevalsB_seg, nlinsetupsB_seg, netfailsB_seg, nnitersB_seg, nncfailsB_seg;
+
     // Temporaries for [x;z] or [rx;rz]
     double *v1, *v2;
 
@@ -157,8 +189,39 @@ namespace casadi {
     double max_step_size_;
     double nonlin_conv_coeff_;
     casadi_int max_order_;
+    bool reuse_jacobian_;
+    casadi_int max_jacobian_age_;
+    double max_checkpoint_memory_;
     ///@}
 
+    /// Steps per segment of the forward problem when taping is restarted, 0 if never
+    casadi_int steps_per_segment_;
+
+    /// Number of doubles stored for the initial state of a segment
+    casadi_int seg_sz_;
+
+    /** \brief Choose the checkpoint and segment lengths for a memory budget
+
+        The adjoint data held by SUNDIALS for one segment consists of a
+        history array of order+1 vectors per checkpoint, plus nv vectors
+        per step between checkpoints for the interpolation.
+    */
+    void checkpoint_budget(casadi_int order, casadi_int nv);
+
+    /** \brief Account for the counters of a finished segment
+
+        With restart set, the counters of the solver, reset by the
+        reinitialization that follows, are added to those of earlier segments.
+        Otherwise the counters of the earlier segments are added to the solver counters.
+    */
+    void segment_stats(SundialsMemory* m, bool backward, bool restart) const;
+
+    /// Nonzeros of the forward Jacobian on the diagonal of the state block
+    std::vector<casadi_int> jac_diag_;
+
+    /// Form the forward Jacobian c*jac0 + d*I from the saved one
+    void jac_from_saved(SundialsMemory* m, double c, double d) const;
+
     /// Linear solver
     Linsol linsolF_, linsolB_;
 
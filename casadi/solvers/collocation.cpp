@@ -61,7 +61,11 @@ namespace casadi {
         "Order of the interpolating polynomials"}},
       {"collocation_scheme",
        {OT_STRING,
-        "Collocation scheme: radau|legendre"}}
+        "Collocation scheme: radau|legendre"}},
+      {"parallelization",
+       {OT_STRING,
+        "Evaluation of the DAE at the collocation points of a finite element, "
+        "as for Function::map: serial|openmp|thread [serial]"}}
      }
   };
 
@@ -69,6 +73,7 @@ namespace casadi {
     // Default options
     deg_ = 3;
     collocation_scheme_ = "radau";
+    parallelization_ = "serial";
 
     // Read options
     for (auto&& op : opts) {
@@ -76,6 +81,8 @@ namespace casadi {
         deg_ = op.second;
       } else if (op.first=="collocation_scheme") {
         collocation_scheme_ = op.second.to_string();
+      } else if (op.first=="parallelization") {
+        parallelization_ = op.second.to_string();
       }
     }
 
@@ -178,17 +185,18 @@ namespace casadi {
     // End state
     MX xf = D[0]*x0;
 
+    // Evaluate the DAE at all collocation points in one call
+    Function f_map = f_.map(deg_, parallelization_);
+    vector<MX> f_arg(DAE_NUM_IN);
+    f_arg[DAE_T] = horzcat(vector<MX>(tt.begin()+1, tt.end()));
+    f_arg[DAE_P] = repmat(p, 1, deg_);
+    f_arg[DAE_X] = horzcat(vector<MX>(x.begin()+1, x.end()));
+    f_arg[DAE_Z] = horzcat(vector<MX>(z.begin()+1, z.end()));
+    vector<vector<MX> > f_res_all = split_points(f_map(f_arg), f_);
+
     // For all collocation points
     for (casadi_int j=1; j<deg_+1; ++j) {
-      //for (casadi_int j=deg_; j>=1; --j) {
-
-      // Evaluate the DAE
-      vector<MX> f_arg(DAE_NUM_IN);
-      f_arg[DAE_T] = tt[j];
-      f_arg[DAE_P] = p;
-      f_arg[DAE_X] = x[j];
-      f_arg[DAE_Z] = z[j];
-      vector<MX> f_res = f_(f_arg);
+      const vector<MX>& f_res = f_res_all[j-1];
 
       // Get an expression for the state derivative at the collocation point
       MX xp_j = C[0][j] * x0;
@@ -258,19 +266,21 @@ namespace casadi {
       // End state
       MX rxf = D[0]*rx0;
 
+      // Evaluate the backward DAE at all collocation points in one call
+      Function g_map = g_.map(deg_, parallelization_);
+      vector<MX> g_arg(RDAE_NUM_IN);
+      g_arg[RDAE_T] = horzcat(vector<MX>(tt.begin()+1, tt.end()));
+      g_arg[RDAE_P] = repmat(p, 1, deg_);
+      g_arg[RDAE_X] = horzcat(vector<MX>(x.begin()+1, x.end()));
+      g_arg[RDAE_Z] = horzcat(vector<MX>(z.begin()+1, z.end()));
+      g_arg[RDAE_RX] = horzcat(vector<MX>(rx.begin()+1, rx.end()));
+      g_arg[RDAE_RZ] = horzcat(vector<MX>(rz.begin()+1, rz.end()));
+      g_arg[RDAE_RP] = repmat(rp, 1, deg_);
+      vector<vector<MX> > g_res_all = split_points(g_map(g_arg), g_);
+
       // For all collocation points
       for (casadi_int j=1; j<deg_+1; ++j) {
-
-        // Evaluate the backward DAE
-        vector<MX> g_arg(RDAE_NUM_IN);
-        g_arg[RDAE_T] = tt[j];
-        g_arg[RDAE_P] = p;
-        g_arg[RDAE_X] = x[j];
-        g_arg[RDAE_Z] = z[j];
-        g_arg[RDAE_RX] = rx[j];
-        g_arg[RDAE_RZ] = rz[j];
-        g_arg[RDAE_RP] = rp;
-        vector<MX> g_res = g_(g_arg);
+        const vector<MX>& g_res = g_res_all[j-1];
 
         // Get an expression for the state derivative at the collocation point
         MX rxp_j = -D[j]*rx0;
@@ -309,6 +319,18 @@ namespace casadi {
     }
   }
 
+  vector<vector<MX> >
+  Collocation::split_points(const vector<MX>& res, const Function& f) const {
+    vector<vector<MX> > ret(deg_, vector<MX>(res.size()));
+    vector<casadi_int> offset(deg_+1);
+    for (casadi_int i=0; i<res.size(); ++i) {
+      for (casadi_int j=0; j<=deg_; ++j) offset[j] = j*f.size2_out(i);
+      vector<MX> r = horzsplit(res[i], offset);
+      for (casadi_int j=0; j<deg_; ++j) ret[j][i] = r[j];
+    }
+    return ret;
+  }
+
   void Collocation::reset(IntegratorMemory* mem, double t, const double* x,
                                 const double* z, const double* p) const {
     auto m = static_cast<FixedStepMemory*>(mem);
@@ -344,18 +366,24 @@ namespace casadi {
   }
 
   Collocation::Collocation(DeserializingStream& s) : ImplicitFixedStepIntegrator(s) {
-    s.version("Collocation", 1);
+    int version = s.version("Collocation", 1, 2);
     s.unpack("Collocation::deg", deg_);
     s.unpack("Collocation::collocation_scheme", collocation_scheme_);
+    if (version>=2) {
+      s.unpack("Collocation::parallelization", parallelization_);
+    } else {
+      parallelization_ = "serial";
+    }
     s.unpack("Collocation::f", f_);
     s.unpack("Collocation::g", g_);
   }
 
   void Collocation::serialize_body(SerializingStream &s) const {
     ImplicitFixedStepIntegrator::serialize_body(s);
-    s.version("Collocation", 1);
+    s.version("Collocation", 2);
     s.pack("Collocation::deg", deg_);
     s.pack("Collocation::collocation_scheme", collocation_scheme_);
+    s.pack("Collocation::parallelization", parallelization_);
     s.pack("Collocation::f", f_);
     s.pack("Collocation::g", g_);
   }
@@ -106,6 +106,13 @@ namespace casadi {
     // Collocation scheme
     std::string collocation_scheme_;
 
+    // Parallelization of the evaluation at the collocation points
+    std::string parallelization_;
+
+    /// Split the outputs of a function mapped over the collocation points
+    std::vector<std::vector<MX> > split_points(const std::vector<MX>& res,
+                                               const Function& f) const;
+
     /// A documentation string
     static const std::string meta_doc;
 
@@ -0,0 +1,555 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "embedded_runge_kutta.hpp"
+#include "casadi/core/casadi_misc.hpp"
+
+using namespace std;
+namespace casadi {
+
+  extern "C"
+  int CASADI_INTEGRATOR_ERK_EXPORT
+      casadi_register_integrator_erk(Integrator::Plugin* plugin) {
+    plugin->creator = EmbeddedRungeKutta::creator;
+    plugin->name = "erk";
+    plugin->doc = EmbeddedRungeKutta::meta_doc.c_str();
+    plugin->version = CASADI_VERSION;
+    plugin->options = &EmbeddedRungeKutta::options_;
+    plugin->deserialize = &EmbeddedRungeKutta::deserialize;
+    return 0;
+  }
+
+  extern "C"
+  void CASADI_INTEGRATOR_ERK_EXPORT casadi_load_integrator_erk() {
+    Integrator::registerPlugin(casadi_register_integrator_erk);
+  }
+
+  EmbeddedRungeKutta::EmbeddedRungeKutta(const std::string& name, const Function& dae)
+    : Integrator(name, dae) {
+  }
+
+  EmbeddedRungeKutta::~EmbeddedRungeKutta() {
+    clear_mem();
+  }
+
+  const Options EmbeddedRungeKutta::options_
+  = {{&Integrator::options_},
+     {{"scheme",
+       {OT_STRING,
+        "Embedded Runge-Kutta pair: 'dopri5' (Dormand-Prince 5(4), default), "
+        "'tsit5' (Tsitouras 5(4)) or 'verner65' (Verner 6(5))"}},
+      {"abstol",
+       {OT_DOUBLE,
+        "Absolute tolerance on the local error estimate [default: 1e-8]"}},
+      {"reltol",
+       {OT_DOUBLE,
+        "Relative tolerance on the local error estimate [default: 1e-6]"}},
+      {"max_num_steps",
+       {OT_INT,
+        "Maximum number of accepted steps in each direction [default: 10000]"}}
+     }
+  };
+
+  void EmbeddedRungeKutta::init(const Dict& opts) {
+    // Call the base class init
+    Integrator::init(opts);
+
+    // Default options
+    scheme_ = "dopri5";
+    abstol_ = 1e-8;
+    reltol_ = 1e-6;
+    max_num_steps_ = 10000;
+
+    // Read options
+    for (auto&& op : opts) {
+      if (op.first=="scheme") {
+        scheme_ = op.second.to_string();
+      } else if (op.first=="abstol") {
+        abstol_ = op.second;
+      } else if (op.first=="reltol") {
+        reltol_ = op.second;
+      } else if (op.first=="max_num_steps") {
+        max_num_steps_ = op.second;
+      }
+    }
+
+    // Algebraic variables not supported
+    casadi_assert(nz_==0 && nrz_==0,
+      "Explicit Runge-Kutta integrators do not support algebraic variables");
+    casadi_assert(abstol_>0 && reltol_>=0, "Tolerances must be positive");
+    casadi_assert(max_num_steps_>0, "Option 'max_num_steps' must be positive");
+
+    // Butcher tableau
+    set_tableau();
+
+    // Right-hand-sides, forward and backward problem
+    create_function("rhsF", {"x", "p", "t"}, {"ode", "quad"});
+    if (nrx_>0) {
+      create_function("rhsB", {"rx", "rp", "x", "p", "t"}, {"rode", "rquad"});
+    }
+
+    // Allocate work vectors
+    alloc_w(np_ + (6 + s_)*(nx_ + nq_), true); // p, erk, y_out
+    if (nrx_>0) {
+      // rp, erkB, yB_out, x_tape, x_stages, x_tmp
+      alloc_w(nrp_ + (6 + s_)*(nrx_ + nrq_) + (2 + s_)*nx_, true);
+    }
+  }
+
+  void EmbeddedRungeKutta::set_tableau() {
+    if (scheme_=="dopri5") {
+      // Dormand-Prince 5(4), first same as last
+      s_ = 7;
+      q_ = 4;
+      fsal_ = true;
+      c_ = {0, 1./5, 3./10, 4./5, 8./9, 1, 1};
+      a_ = {0, 0, 0, 0, 0, 0, 0,
+            1./5, 0, 0, 0, 0, 0, 0,
+            3./40, 9./40, 0, 0, 0, 0, 0,
+            44./45, -56./15, 32./9, 0, 0, 0, 0,
+            19372./6561, -25360./2187, 64448./6561, -212./729, 0, 0, 0,
+            9017./3168, -355./33, 46732./5247, 49./176, -5103./18656, 0, 0,
+            35./384, 0, 500./1113, 125./192, -2187./6784, 11./84, 0};
+      b_ = {35./384, 0, 500./1113, 125./192, -2187./6784, 11./84, 0};
+      vector<double> bhat = {5179./57600, 0, 7571./16695, 393./640, -92097./339200,
+                             187./2100, 1./40};
+      e_.resize(s_);
+      for (casadi_int j=0; j<s_; ++j) e_[j] = b_[j] - bhat[j];
+      // Continuous extension of order 4, coefficients of theta, ..., theta^4
+      nd_ = 4;
+      bd_ = {1, -8048581381./2820520608, 8663915743./2820520608,
+             -12715105075./11282082432,
+             0, 0, 0, 0,
+             0, 131558114200./32700410799, -68118460800./10900136933,
+             87487479700./32700410799,
+             0, -1754552775./470086768, 14199869525./1410260304,
+             -10690763975./1880347072,
+             0, 127303824393./49829197408, -318862633887./49829197408,
+             701980252875./199316789632,
+             0, -282668133./205662961, 2019193451./616988883, -1453857185./822651844,
+             0, 40617522./29380423, -110615467./29380423, 69997945./29380423};
+    } else if (scheme_=="tsit5") {
+      // Tsitouras 5(4), first same as last
+      s_ = 7;
+      q_ = 4;
+      fsal_ = true;
+      c_ = {0, 0.161, 0.327, 0.9, 0.9800255409045097, 1, 1};
+      a_ = {0, 0, 0, 0, 0, 0, 0,
+            0.161, 0, 0, 0, 0, 0, 0,
+            -0.008480655492356989, 0.335480655492357, 0, 0, 0, 0, 0,
+            2.897153057105493, -6.359448489975075, 4.3622954328695815, 0, 0, 0, 0,
+            5.325864828439257, -11.748883564062828, 7.4955393428898365,
+            -0.09249506636175525, 0, 0, 0,
+            5.86145544294642, -12.92096931784711, 8.159367898576159,
+            -0.071584973281401, -0.028269050394068383, 0, 0,
+            0.09646076681806523, 0.01, 0.4798896504144996, 1.379008574103742,
+            -3.290069515436081, 2.324710524099774, 0};
+      b_ = {0.09646076681806523, 0.01, 0.4798896504144996, 1.379008574103742,
+            -3.290069515436081, 2.324710524099774, 0};
+      e_ = {-0.00178001105222577714, -0.0008164344596567469, 0.007880878010261995,
+            -0.1447110071732629, 0.5823571654525552, -0.45808210592918697,
+            0.015151515151515152};
+      // Continuous extension of order 4, coefficients of theta, ..., theta^4
+      nd_ = 4;
+      bd_ = {1, -2.763706197274826, 2.9132554618219126, -1.0530884977290216,
+             0, 0.1317, -0.2234, 0.1017,
+             0, 3.930296236894751, -5.941033872131505, 2.490627285651253,
+             0, -12.411077166933676, 30.33818863028232, -16.548102889244902,
+             0, 37.50931341651104, -88.1789048947664, 47.37952196281928,
+             0, -27.896526289197286, 65.09189467479368, -34.87065786149661,
+             0, 1.5, -4, 2.5};
+    } else if (scheme_=="verner65") {
+      // Verner 6(5), as in DVERK
+      s_ = 8;
+      q_ = 5;
+      fsal_ = false;
+      c_ = {0, 1./6, 4./15, 2./3, 5./6, 1, 1./15, 1};
+      a_ = {0, 0, 0, 0, 0, 0, 0, 0,
+            1./6, 0, 0, 0, 0, 0, 0, 0,
+            4./75, 16./75, 0, 0, 0, 0, 0, 0,
+            5./6, -8./3, 5./2, 0, 0, 0, 0, 0,
+            -165./64, 55./6, -425./64, 85./96, 0, 0, 0, 0,
+            12./5, -8, 4015./612, -11./36, 88./255, 0, 0, 0,
+            -8263./15000, 124./75, -643./680, -81./250, 2484./10625, 0, 0, 0,
+            3501./1720, -300./43, 297275./52632, -319./2322, 24068./84065, 0,
+            3850./26703, 0};
+      b_ = {3./40, 0, 875./2244, 23./72, 264./1955, 0, 125./11592, 43./616};
+      vector<double> bhat = {13./160, 0, 2375./5984, 5./16, 12./85, 3./44, 0, 0};
+      e_.resize(s_);
+      for (casadi_int j=0; j<s_; ++j) e_[j] = b_[j] - bhat[j];
+      // No continuous extension: steps end at the output times and the
+      // forward state is recomputed within a step for the backward problem
+      nd_ = 0;
+      bd_.clear();
+    } else {
+      casadi_error("Unknown scheme '" + scheme_ + "'. "
+                   "Possible values are 'dopri5', 'tsit5' and 'verner65'.");
+    }
+  }
+
+  int EmbeddedRungeKutta::init_mem(void* mem) const {
+    if (Integrator::init_mem(mem)) return 1;
+    auto m = static_cast<EmbeddedRungeKuttaMemory*>(mem);
+    setup_erk(&m->erk, nx_ + nq_, 1, grid_.back());
+    setup_erk(&m->erkB, nrx_ + nrq_, -1, grid_.front());
+    return 0;
+  }
+
+  void EmbeddedRungeKutta::setup_erk(casadi_erk_mem<double>* m, casadi_int n,
+                                     double dir, double tend) const {
+    m->s = s_;
+    m->c = get_ptr(c_);
+    m->a = get_ptr(a_);
+    m->b = get_ptr(b_);
+    m->e = get_ptr(e_);
+    m->q = q_;
+    m->fsal = fsal_;
+    m->bd = get_ptr(bd_);
+    m->nd = nd_;
+    m->n = n;
+    // Quadratures are not error controlled, unless there is nothing else
+    casadi_int nx = dir>0 ? nx_ : nrx_;
+    m->nerr = nx>0 ? nx : n;
+    m->dir = dir;
+    m->abstol = abstol_;
+    m->reltol = reltol_;
+    m->tend = tend;
+    m->max_num_steps = max_num_steps_;
+    m->nsteps = m->nrejects = m->nfevals = 0;
+  }
+
+  void EmbeddedRungeKutta::set_work(void* mem, const double**& arg, double**& res,
+                                    casadi_int*& iw, double*& w) const {
+    auto m = static_cast<EmbeddedRungeKuttaMemory*>(mem);
+
+    // Set work in base classes
+    Integrator::set_work(mem, arg, res, iw, w);
+
+    // Work vectors, forward and backward problem
+    for (bool backward : {false, true}) {
+      if (backward && nrx_==0) continue;
+      casadi_erk_mem<double>* e = backward ? &m->erkB : &m->erk;
+      casadi_int n = backward ? nrx_ + nrq_ : nx_ + nq_;
+      if (backward) {
+        m->rp = w; w += nrp_;
+      } else {
+        m->p = w; w += np_;
+      }
+      e->y = w; w += n;
+      e->yp = w; w += n;
+      e->f = w; w += n;
+      e->fp = w; w += n;
+      e->ytmp = w; w += n;
+      e->k = w; w += s_*n;
+      if (backward) {
+        m->yB_out = w; w += n;
+        m->x_tape = w; w += nx_;
+        m->x_stages = w; w += s_*nx_;
+        m->x_tmp = w; w += nx_;
+      } else {
+        m->y_out = w; w += n;
+      }
+    }
+  }
+
+  void EmbeddedRungeKutta::reset(IntegratorMemory* mem, double t, const double* x,
+                                 const double* z, const double* p) const {
+    auto m = static_cast<EmbeddedRungeKuttaMemory*>(mem);
+
+    // Initial state, quadratures start at zero
+    casadi_copy(p, np_, m->p);
+    casadi_copy(x, nx_, m->erk.y);
+    casadi_clear(m->erk.y + nx_, nq_);
+
+    // Reset the stepper
+    casadi_erk_reset(&m->erk, t);
+
+    // Clear the tape
+    m->tape_t.clear();
+    m->tape_x.clear();
+    m->tape_k.clear();
+  }
+
+  void EmbeddedRungeKutta::advance(IntegratorMemory* mem, double t,
+                                   double* x, double* z, double* q) const {
+    auto m = static_cast<EmbeddedRungeKuttaMemory*>(mem);
+    casadi_erk_mem<double>* e = &m->erk;
+
+    // Take steps until t is reached
+    int flag;
+    while ((flag = casadi_erk(e, t)) > 0) {
+      if (flag==1) {
+        // Evaluate the right-hand-side
+        m->arg[0] = e->yeval;
+        m->arg[1] = m->p;
+        m->arg[2] = &e->teval;
+        m->res[0] = e->feval;
+        m->res[1] = e->feval + nx_;
+        if (calc_function(m, "rhsF")) {
+          casadi_error("Evaluation of the right-hand-side failed at t=" + str(e->teval));
+        }
+      } else if (nrx_>0) {
+        // Store the accepted step for the backward problem
+        m->tape_t.push_back(e->t);
+        m->tape_x.insert(m->tape_x.end(), e->y, e->y + nx_);
+        if (e->nsteps>0) {
+          for (casadi_int j=0; j<s_; ++j) {
+            const double* kj = e->k + j*(nx_ + nq_);
+            m->tape_k.insert(m->tape_k.end(), kj, kj + nx_);
+          }
+        }
+      }
+    }
+    casadi_assert(flag!=-1, "Maximum number of steps reached at t=" + str(e->t));
+    casadi_assert(flag!=-2, "Step size too small at t=" + str(e->t));
+
+    // Interpolate to the output time
+    casadi_erk_interp(e, t, m->y_out);
+    casadi_copy(m->y_out, nx_, x);
+    casadi_copy(m->y_out + nx_, nq_, q);
+  }
+
+  void EmbeddedRungeKutta::resetB(IntegratorMemory* mem, double t, const double* rx,
+                                  const double* rz, const double* rp) const {
+    auto m = static_cast<EmbeddedRungeKuttaMemory*>(mem);
+
+    // Terminal state, quadratures start at zero
+    casadi_copy(rp, nrp_, m->rp);
+    casadi_copy(rx, nrx_, m->erkB.y);
+    casadi_clear(m->erkB.y + nrx_, nrq_);
+
+    // Reset the stepper
+    casadi_erk_reset(&m->erkB, t);
+  }
+
+  void EmbeddedRungeKutta::interp_tape(EmbeddedRungeKuttaMemory* m, double t) const {
+    // Locate the step containing t
+    casadi_int n = m->tape_t.size();
+    casadi_assert_dev(n>0);
+    casadi_int k = upper_bound(m->tape_t.begin(), m->tape_t.end(), t) - m->tape_t.begin();
+    k = min(max(k, casadi_int(1)), n - 1);
+    if (n==1 || t==m->tape_t[k - 1]) {
+      casadi_copy(get_ptr(m->tape_x) + (n==1 ? 0 : k - 1)*nx_, nx_, m->x_tape);
+      return;
+    } else if (t==m->tape_t[k]) {
+      casadi_copy(get_ptr(m->tape_x) + k*nx_, nx_, m->x_tape);
+      return;
+    }
+
+    // Step from the taped state and its stage derivatives
+    double t0 = m->tape_t[k - 1], h = m->tape_t[k] - t0;
+    const double* x0 = get_ptr(m->tape_x) + (k - 1)*nx_;
+    const double* k0 = get_ptr(m->tape_k) + (k - 1)*s_*nx_;
+    if (nd_>0) {
+      // Continuous extension of the scheme
+      casadi_erk_dense(&m->erk, nx_, (t - t0)/h, h, x0, k0, m->x_tape);
+      return;
+    }
+
+    // Without a continuous extension, repeat the step with a shorter step size
+    h = t - t0;
+    casadi_copy(k0, nx_, m->x_stages);
+    for (casadi_int j=1; j<s_; ++j) {
+      casadi_copy(x0, nx_, m->x_tmp);
+      for (casadi_int l=0; l<j; ++l) {
+        casadi_axpy(nx_, h*a_[j*s_ + l], m->x_stages + l*nx_, m->x_tmp);
+      }
+      double tj = t0 + c_[j]*h;
+      m->arg[0] = m->x_tmp;
+      m->arg[1] = m->p;
+      m->arg[2] = &tj;
+      m->res[0] = m->x_stages + j*nx_;
+      m->res[1] = nullptr;
+      if (calc_function(m, "rhsF")) {
+        casadi_error("Evaluation of the right-hand-side failed at t=" + str(tj));
+      }
+    }
+    casadi_copy(x0, nx_, m->x_tape);
+    for (casadi_int j=0; j<s_; ++j) {
+      casadi_axpy(nx_, h*b_[j], m->x_stages + j*nx_, m->x_tape);
+    }
+  }
+
+  void EmbeddedRungeKutta::retreat(IntegratorMemory* mem, double t,
+                                   double* rx, double* rz, double* rq) const {
+    auto m = static_cast<EmbeddedRungeKuttaMemory*>(mem);
+    casadi_erk_mem<double>* e = &m->erkB;
+
+    // Take steps until t is reached
+    int flag;
+    while ((flag = casadi_erk(e, t)) > 0) {
+      if (flag==1) {
+        // Forward state at the current time
+        interp_tape(m, e->teval);
+
+        // Evaluate the right-hand-side
+        m->arg[0] = e->yeval;
+        m->arg[1] = m->rp;
+        m->arg[2] = m->x_tape;
+        m->arg[3] = m->p;
+        m->arg[4] = &e->teval;
+        m->res[0] = e->feval;
+        m->res[1] = e->feval + nrx_;
+        if (calc_function(m, "rhsB")) {
+          casadi_error("Evaluation of the right-hand-side failed at t=" + str(e->teval));
+        }
+      }
+    }
+    casadi_assert(flag!=-1, "Maximum number of steps reached at t=" + str(e->t));
+    casadi_assert(flag!=-2, "Step size too small at t=" + str(e->t));
+
+    // Interpolate to the output time
+    casadi_erk_interp(e, t, m->yB_out);
+    casadi_copy(m->yB_out, nrx_, rx);
+    casadi_copy(m->yB_out + nrx_, nrq_, rq);
+  }
+
+  Dict EmbeddedRungeKutta::get_stats(void* mem) const {
+    Dict stats = Integrator::get_stats(mem);
+    auto m = static_cast<EmbeddedRungeKuttaMemory*>(mem);
+
+    // Counters, forward problem
+    stats["nsteps"] = m->erk.nsteps;
+    stats["nrejects"] = m->erk.nrejects;
+    stats["nfevals"] = m->erk.nfevals;
+
+    // Counters, backward problem
+    stats["nstepsB"] = m->erkB.nsteps;
+    stats["nrejectsB"] = m->erkB.nrejects;
+    stats["nfevalsB"] = m->erkB.nfevals;
+    return stats;
+  }
+
+  void EmbeddedRungeKutta::print_stats(IntegratorMemory* mem) const {
+    auto m = static_cast<EmbeddedRungeKuttaMemory*>(mem);
+    print("FORWARD INTEGRATION:\n");
+    print("Number of accepted steps: %lld\n", m->erk.nsteps);
+    print("Number of rejected steps: %lld\n", m->erk.nrejects);
+    print("Number of right-hand-side evaluations: %lld\n", m->erk.nfevals);
+    if (nrx_>0) {
+      print("BACKWARD INTEGRATION:\n");
+      print("Number of accepted steps: %lld\n", m->erkB.nsteps);
+      print("Number of rejected steps: %lld\n", m->erkB.nrejects);
+      print("Number of right-hand-side evaluations: %lld\n", m->erkB.nfevals);
+    }
+  }
+
+  void EmbeddedRungeKutta::codegen_declarations(CodeGenerator& g) const {
+    g.add_dependency(get_function("rhsF"));
+  }
+
+  void EmbeddedRungeKutta::codegen_body(CodeGenerator& g) const {
+    g.add_auxiliary(CodeGenerator::AUX_ERK);
+    casadi_int n = nx_ + nq_;
+
+    g.local("m", "struct casadi_erk_mem");
+    g.local("flag", "int");
+    g.local("k", "casadi_int");
+    g.local("tout", "const casadi_real*");
+
+    // Butcher tableau and settings
+    g << "m.s = " << s_ << ";\n";
+    g << "m.c = " << g.constant(c_) << ";\n";
+    g << "m.a = " << g.constant(a_) << ";\n";
+    g << "m.b = " << g.constant(b_) << ";\n";
+    g << "m.e = " << g.constant(e_) << ";\n";
+    g << "m.q = " << q_ << ";\n";
+    g << "m.fsal = " << (fsal_ ? 1 : 0) << ";\n";
+    g << "m.bd = " << (nd_>0 ? g.constant(bd_) : "0") << ";\n";
+    g << "m.nd = " << nd_ << ";\n";
+    g << "m.n = " << n << ";\n";
+    g << "m.nerr = " << (nx_>0 ? nx_ : n) << ";\n";
+    g << "m.dir = 1;\n";
+    g << "m.abstol = " << g.constant(abstol_) << ";\n";
+    g << "m.reltol = " << g.constant(reltol_) << ";\n";
+    g << "m.tend = " << g.constant(grid_.back()) << ";\n";
+    g << "m.max_num_steps = " << max_num_steps_ << ";\n";
+
+    // Work vectors, as in set_work
+    casadi_int w_offset = 0;
+    string p = "w+" + str(w_offset); w_offset += np_;
+    g << "m.y = w+" << w_offset << ";\n"; w_offset += n;
+    g << "m.yp = w+" << w_offset << ";\n"; w_offset += n;
+    g << "m.f = w+" << w_offset << ";\n"; w_offset += n;
+    g << "m.fp = w+" << w_offset << ";\n"; w_offset += n;
+    g << "m.ytmp = w+" << w_offset << ";\n"; w_offset += n;
+    g << "m.k = w+" << w_offset << ";\n"; w_offset += s_*n;
+    string y_out = "w+" + str(w_offset); w_offset += n;
+
+    // Initial state, quadratures start at zero
+    g.comment("Initial conditions");
+    g << g.copy(g.arg(INTEGRATOR_P), np_, p) << "\n";
+    g << g.copy(g.arg(INTEGRATOR_X0), nx_, "m.y") << "\n";
+    g << g.clear("m.y+" + str(nx_), nq_) << "\n";
+    g << "casadi_erk_reset(&m, " << g.constant(grid_.front()) << ");\n";
+
+    // Loop over output times
+    g.comment("Integrate over the output grid");
+    vector<double> tout(grid_.begin() + (output_t0_ ? 0 : 1), grid_.end());
+    g << "tout = " << g.constant(tout) << ";\n";
+    g << "for (k=0; k<" << tout.size() << "; ++k) {\n";
+    g << "while ((flag=casadi_erk(&m, tout[k]))>0) {\n";
+    g << "if (flag==1) {\n";
+    g << "arg[" << INTEGRATOR_NUM_IN << "] = m.yeval;\n";
+    g << "arg[" << INTEGRATOR_NUM_IN + 1 << "] = " << p << ";\n";
+    g << "arg[" << INTEGRATOR_NUM_IN + 2 << "] = &m.teval;\n";
+    g << "res[" << INTEGRATOR_NUM_OUT << "] = m.feval;\n";
+    g << "res[" << INTEGRATOR_NUM_OUT + 1 << "] = m.feval+" << nx_ << ";\n";
+    string flag = g(get_function("rhsF"), "arg+" + str(INTEGRATOR_NUM_IN),
+      "res+" + str(INTEGRATOR_NUM_OUT), "iw", "w+" + str(w_offset));
+    g << "if (" << flag << ") return 1;\n";
+    g << "}\n";
+    g << "}\n";
+    g << "if (flag<0) return 1;\n";
+
+    // Interpolate to the output time
+    g << "casadi_erk_interp(&m, tout[k], " << y_out << ");\n";
+    g << "if (res[" << INTEGRATOR_XF << "]) "
+      << g.copy(y_out, nx_, "res[" + str(INTEGRATOR_XF) + "]+k*" + str(nx_)) << "\n";
+    g << "if (res[" << INTEGRATOR_QF << "]) "
+      << g.copy(y_out + "+" + str(nx_), nq_, "res[" + str(INTEGRATOR_QF) + "]+k*" + str(nq_))
+      << "\n";
+    g << "}\n";
+  }
+
+  void EmbeddedRungeKutta::serialize_body(SerializingStream &s) const {
+    Integrator::serialize_body(s);
+    s.version("EmbeddedRungeKutta", 1);
+    s.pack("EmbeddedRungeKutta::scheme", scheme_);
+    s.pack("EmbeddedRungeKutta::abstol", abstol_);
+    s.pack("EmbeddedRungeKutta::reltol", reltol_);
+    s.pack("EmbeddedRungeKutta::max_num_steps", max_num_steps_);
+  }
+
+  EmbeddedRungeKutta::EmbeddedRungeKutta(DeserializingStream& s) : Integrator(s) {
+    s.version("EmbeddedRungeKutta", 1);
+    s.unpack("EmbeddedRungeKutta::scheme", scheme_);
+    s.unpack("EmbeddedRungeKutta::abstol", abstol_);
+    s.unpack("EmbeddedRungeKutta::reltol", reltol_);
+    s.unpack("EmbeddedRungeKutta::max_num_steps", max_num_steps_);
+    set_tableau();
+  }
+
+} // namespace casadi
@@ -0,0 +1,186 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef CASADI_EMBEDDED_RUNGE_KUTTA_HPP
+#define CASADI_EMBEDDED_RUNGE_KUTTA_HPP
+
+#include "casadi/core/integrator_impl.hpp"
+#include <casadi/solvers/casadi_integrator_erk_export.h>
+
+/** \defgroup plugin_Integrator_erk
+      Adaptive explicit Runge-Kutta integrator for ODEs, with the step size
+      controlled by an embedded error estimate. Implements Dormand-Prince 5(4),
+      Tsitouras 5(4) and Verner 6(5). Outputs at the grid points are
+      obtained from the continuous extension of the scheme (Dormand-Prince,
+      Tsitouras) or by ending a step at each grid point (Verner).
+*/
+/** \pluginsection{Integrator,erk} */
+
+/// \cond INTERNAL
+namespace casadi {
+
+  struct CASADI_INTEGRATOR_ERK_EXPORT EmbeddedRungeKuttaMemory : public IntegratorMemory {
+    // Runtime memory, forward and backward problem
+    casadi_erk_mem<double> erk, erkB;
+
+    // Parameters, forward and backward problem
+    double *p, *rp;
+
+    // Dense output, forward and backward problem
+    double *y_out, *yB_out;
+
+    // Interpolated forward state
+    double *x_tape;
+
+    // Stage derivatives and temporary state for recomputing the forward state
+    double *x_stages, *x_tmp;
+
+    // Accepted steps of the forward problem: time, state, stage derivatives
+    std::vector<double> tape_t, tape_x, tape_k;
+  };
+
+  /** \brief \pluginbrief{Integrator,erk}
+
+      @copydoc DAE_doc
+      @copydoc plugin_Integrator_erk
+  */
+  class CASADI_INTEGRATOR_ERK_EXPORT EmbeddedRungeKutta : public Integrator {
+  public:
+
+    /// Constructor
+    explicit EmbeddedRungeKutta(const std::string& name, const Function& dae);
+
+    /** \brief  Create a new integrator */
+    static Integrator* creator(const std::string& name, const Function& dae) {
+      return new EmbeddedRungeKutta(name, dae);
+    }
+
+    /// Destructor
+    ~EmbeddedRungeKutta() override;
+
+    // Get name of the plugin
+    const char* plugin_name() const override { return "erk";}
+
+    // Get name of the class
+    std::string class_name() const override { return "EmbeddedRungeKutta";}
+
+    ///@{
+    /** \brief Options */
+    static const Options options_;
+    const Options& get_options() const override { return options_;}
+    ///@}
+
+    /// Initialize stage
+    void init(const Dict& opts) override;
+
+    /** \brief Create memory block */
+    void* alloc_mem() const override { return new EmbeddedRungeKuttaMemory();}
+
+    /** \brief Initalize memory block */
+    int init_mem(void* mem) const override;
+
+    /** \brief Free memory block */
+    void free_mem(void *mem) const override {
+      delete static_cast<EmbeddedRungeKuttaMemory*>(mem);
+    }
+
+    /** \brief Set the (persistent) work vectors */
+    void set_work(void* mem, const double**& arg, double**& res,
+                  casadi_int*& iw, double*& w) const override;
+
+    /** \brief Reset the forward problem */
+    void reset(IntegratorMemory* mem, double t,
+               const double* x, const double* z, const double* p) const override;
+
+    /** \brief  Advance solution in time */
+    void advance(IntegratorMemory* mem, double t,
+                 double* x, double* z, double* q) const override;
+
+    /** \brief Reset the backward problem */
+    void resetB(IntegratorMemory* mem, double t,
+                const double* rx, const double* rz, const double* rp) const override;
+
+    /** \brief  Retreat solution in time */
+    void retreat(IntegratorMemory* mem, double t,
+                 double* rx, double* rz, double* rq) const override;
+
+    /** \brief Get all statistics */
+    Dict get_stats(void* mem) const override;
+
+    /** \brief  Print solver statistics */
+    void print_stats(IntegratorMemory* mem) const override;
+
+    /** \brief Is codegen supported? */
+    bool has_codegen() const override { return nrx_==0;}
+
+    /** \brief Generate code for the declarations of the C function */
+    void codegen_declarations(CodeGenerator& g) const override;
+
+    /** \brief Generate code for the function body */
+    void codegen_body(CodeGenerator& g) const override;
+
+    /// A documentation string
+    static const std::string meta_doc;
+
+    /** \brief Serialize an object without type information */
+    void serialize_body(SerializingStream &s) const override;
+
+    /** \brief Deserialize into MX */
+    static ProtoFunction* deserialize(DeserializingStream& s) {
+      return new EmbeddedRungeKutta(s);
+    }
+
+  protected:
+    /** \brief Deserializing constructor */
+    explicit EmbeddedRungeKutta(DeserializingStream& s);
+
+    /// Set the Butcher tableau corresponding to scheme_
+    void set_tableau();
+
+    /// Configure the runtime memory for the forward or backward problem
+    void setup_erk(casadi_erk_mem<double>* m, casadi_int n, double dir, double tend) const;
+
+    /// Interpolate the taped forward state at time t
+    void interp_tape(EmbeddedRungeKuttaMemory* m, double t) const;
+
+    // Options
+    std::string scheme_;
+    double abstol_, reltol_;
+    casadi_int max_num_steps_;
+
+    // Butcher tableau: nodes, coefficients (row major), weights, error weights
+    casadi_int s_, q_;
+    bool fsal_;
+    std::vector<double> c_, a_, b_, e_;
+
+    // Continuous extension, s_-by-nd_ (row major), nd_=0 if none
+    casadi_int nd_;
+    std::vector<double> bd_;
+  };
+
+} // namespace casadi
+
+/// \endcond
+#endif // CASADI_EMBEDDED_RUNGE_KUTTA_HPP
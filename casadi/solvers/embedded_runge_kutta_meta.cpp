@@ -0,0 +1,61 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+      #include "embedded_runge_kutta.hpp"
+      #include <string>
+
+      const std::string casadi::EmbeddedRungeKutta::meta_doc=
+      "\n"
+"Adaptive explicit Runge-Kutta integrator for ODEs, with the step size\n"
+"controlled by an embedded error estimate. Implements Dormand-Prince 5(4),\n"
+"Tsitouras 5(4) and Verner 6(5). Outputs at the grid points are obtained\n"
+"from the continuous extension of the scheme (Dormand-Prince, Tsitouras) or\n"
+"by ending a step at each grid point (Verner).\n"
+"\n"
+"\n"
+">List of available options\n"
+"\n"
+"+-----------------+-----------+-------------------------------------------+\n"
+"|       Id        |   Type    |                Description                |\n"
+"+=================+===========+===========================================+\n"
+"| abstol          | OT_DOUBLE | Absolute tolerance on the local error     |\n"
+"|                 |           | estimate [default: 1e-8]                  |\n"
+"+-----------------+-----------+-------------------------------------------+\n"
+"| max_num_steps   | OT_INT    | Maximum number of accepted steps in each  |\n"
+"|                 |           | direction [default: 10000]                |\n"
+"+-----------------+-----------+-------------------------------------------+\n"
+"| reltol          | OT_DOUBLE | Relative tolerance on the local error     |\n"
+"|                 |           | estimate [default: 1e-6]                  |\n"
+"+-----------------+-----------+-------------------------------------------+\n"
+"| scheme          | OT_STRING | Embedded Runge-Kutta pair: 'dopri5'       |\n"
+"|                 |           | (Dormand-Prince 5(4), default), 'tsit5'   |\n"
+"|                 |           | (Tsitouras 5(4)) or 'verner65' (Verner    |\n"
+"|                 |           | 6(5))                                     |\n"
+"+-----------------+-----------+-------------------------------------------+\n"
+"\n"
+"\n"
+"\n"
+"\n"
+;
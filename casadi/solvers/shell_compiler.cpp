@@ -27,6 +27,7 @@
 #include "casadi/core/casadi_misc.hpp"
 #include "casadi/core/casadi_meta.hpp"
 #include "casadi/core/casadi_logger.hpp"
+#include "casadi/core/thread_pool.hpp"
 #include <fstream>
 
 // Set default object file suffix
@@ -71,6 +72,9 @@ namespace casadi {
     if (cleanup_) {
       if (remove(bin_name_.c_str())) casadi_warning("Failed to remove " + bin_name_);
       if (remove(obj_name_.c_str())) casadi_warning("Failed to remove " + obj_name_);
+      for (const std::string& s : extra_obj_names_) {
+        if (remove(s.c_str())) casadi_warning("Failed to remove " + s);
+      }
       for (const std::string& s : extra_suffixes_) {
         std::string name = base_name_+s;
         remove(name.c_str());
@@ -131,6 +135,14 @@ namespace casadi {
         "This is desired for thread-safety. "
         "This behaviour may defeat caching compiler wrappers. "
         "Default: true"}},
+      {"sources",
+       {OT_STRINGVECTOR,
+        "Additional source files, compiled separately and linked into the same library, "
+        "cf. the code generation option 'split_files'. Default: None"}},
+      {"max_jobs",
+       {OT_INT,
+        "Maximum number of source files compiled concurrently. "
+        "Default: number of hardware threads"}},
      }
   };
 
@@ -146,6 +158,8 @@ namespace casadi {
 
     vector<string> compiler_flags;
     vector<string> linker_flags;
+    vector<string> sources;
+    casadi_int max_jobs = ThreadPool::default_num_threads();
     string suffix = OBJECT_FILE_SUFFIX;
 
 #ifdef _WIN32
@@ -191,6 +205,11 @@ namespace casadi {
         bare_name = op.second.to_string();
       } else if (op.first=="temp_suffix") {
         temp_suffix = op.second;
+      } else if (op.first=="sources") {
+        sources = op.second;
+      } else if (op.first=="max_jobs") {
+        max_jobs = op.second;
+        casadi_assert(max_jobs>=1, "Option 'max_jobs' must be positive");
       }
     }
 
@@ -202,6 +221,9 @@ namespace casadi {
     }
     base_name_ = std::string(obj_name_.begin(), obj_name_.begin()+obj_name_.size()-suffix.size());
     bin_name_ = base_name_+SHARED_LIBRARY_SUFFIX;
+    for (casadi_int k=0; k<sources.size(); ++k) {
+      extra_obj_names_.push_back(base_name_ + "_" + str(k+1) + suffix);
+    }
 
 #ifndef _WIN32
     // Have relative paths start with ./
@@ -212,34 +234,52 @@ namespace casadi {
     if (bin_name_.at(0)!='/') {
       bin_name_ = "./" + bin_name_;
     }
-#endif // _WIN32
 
-    // Construct the compiler command
-    stringstream cccmd;
-    cccmd << compiler;
-    for (vector<string>::const_iterator i=compiler_flags.begin(); i!=compiler_flags.end(); ++i) {
-      cccmd << " " << *i;
+    for (std::string& s : extra_obj_names_) {
+      if (s.at(0)!='/') s = "./" + s;
     }
-    cccmd << " " << compiler_setup;
+#endif // _WIN32
 
-    // C/C++ source file
-    cccmd << " " << name_;
+    // Construct the compiler commands, one for each source file
+    sources.insert(sources.begin(), name_);
+    vector<string> objects = extra_obj_names_;
+    objects.insert(objects.begin(), obj_name_);
+    vector<string> cccmd(sources.size());
+    for (casadi_int k=0; k<sources.size(); ++k) {
+      stringstream ss;
+      ss << compiler;
+      for (vector<string>::const_iterator i=compiler_flags.begin(); i!=compiler_flags.end(); ++i) {
+        ss << " " << *i;
+      }
+      ss << " " << compiler_setup;
+
+      // C/C++ source file
+      ss << " " << sources[k];
 
-    // Temporary object file
-    cccmd << " " + compiler_output_flag << obj_name_;
+      // Temporary object file
+      ss << " " + compiler_output_flag << objects[k];
+      cccmd[k] = ss.str();
+      if (verbose_) casadi_message("calling \"" + cccmd[k] + "\"");
+    }
 
-    // Compile into an object
-    if (verbose_) casadi_message("calling \"" + cccmd.str() + "\"");
-    if (system(cccmd.str().c_str())) {
-      casadi_error("Compilation failed. Tried \"" + cccmd.str() + "\"");
+    // Compile into objects, in parallel
+    vector<int> status(sources.size(), 0);
+    ThreadPool::instance().run(sources.size(), max_jobs, [&](casadi_int w, casadi_int k) {
+      status[k] = system(cccmd[k].c_str());
+    }, 1);
+    for (casadi_int k=0; k<sources.size(); ++k) {
+      if (status[k]) {
+        casadi_error("Compilation failed. Tried \"" + cccmd[k] + "\"");
+      }
     }
 
     // Link step
     stringstream ldcmd;
     ldcmd << linker;
 
-    // Temporary file
-    ldcmd << " " << obj_name_ << " " + linker_output_flag + bin_name_;
+    // Temporary files
+    for (const string& o : objects) ldcmd << " " << o;
+    ldcmd << " " + linker_output_flag + bin_name_;
 
     // Add flags
     for (vector<string>::const_iterator i=linker_flags.begin(); i!=linker_flags.end(); ++i) {
@@ -94,6 +94,9 @@ namespace casadi {
     /// Temporary file
     std::string obj_name_;
 
+    /// Temporary files for the additional sources
+    std::vector<std::string> extra_obj_names_;
+
     /// Extra files
     std::vector<std::string> extra_suffixes_;
 
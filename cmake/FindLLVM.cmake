@@ -0,0 +1,66 @@
+# Locate LLVM (with ORC JIT support) using the llvm-config script
+#
+# Sets:
+#  LLVM_FOUND, LLVM_VERSION, LLVM_INCLUDE_DIR, LLVM_LIBRARIES,
+#  LLVM_DEFINITIONS, LLVM_CXX_FLAGS
+
+set(LLVM_LIBRARIES)
+set(LLVM_DEFINITIONS)
+set(LLVM_CXX_FLAGS)
+
+# Locate the LLVM config script
+find_program(LLVM_CONFIG NAMES llvm-config llvm-config-14 llvm-config-13 llvm-config-12
+             HINTS $ENV{LLVM}/bin)
+if(NOT LLVM_CONFIG)
+  if(LLVM_FIND_REQUIRED)
+    message(FATAL_ERROR "Could not find llvm-config")
+  endif()
+  return()
+endif()
+
+# LLVM version
+execute_process(COMMAND ${LLVM_CONFIG} --version
+                OUTPUT_VARIABLE LLVM_VERSION
+                OUTPUT_STRIP_TRAILING_WHITESPACE)
+message(STATUS "Found LLVM ${LLVM_VERSION}")
+if(LLVM_VERSION VERSION_LESS 12)
+  message(FATAL_ERROR "The LLVM JIT requires LLVM 12 or later (ORC LLJIT)")
+endif()
+
+# LLVM include directory
+execute_process(COMMAND ${LLVM_CONFIG} --includedir
+                OUTPUT_VARIABLE LLVM_INCLUDE_DIR
+                OUTPUT_STRIP_TRAILING_WHITESPACE)
+
+# LLVM libraries needed for the ORC JIT
+execute_process(COMMAND ${LLVM_CONFIG} --libfiles core orcjit native passes
+                OUTPUT_VARIABLE LLVM_LIBRARIES
+                OUTPUT_STRIP_TRAILING_WHITESPACE)
+separate_arguments(LLVM_LIBRARIES)
+
+# System libraries
+execute_process(COMMAND ${LLVM_CONFIG} --system-libs core orcjit native passes
+                OUTPUT_VARIABLE LLVM_SYSTEM_LIBS
+                OUTPUT_STRIP_TRAILING_WHITESPACE)
+separate_arguments(LLVM_SYSTEM_LIBS)
+foreach(D ${LLVM_SYSTEM_LIBS})
+  string(REGEX REPLACE "^-l" "" D ${D})
+  set(LLVM_LIBRARIES ${LLVM_LIBRARIES} ${D})
+endforeach()
+
+# C++ compiler flags: keep definitions and the language standard
+execute_process(COMMAND ${LLVM_CONFIG} --cxxflags
+                OUTPUT_VARIABLE LLVM_CXXFLAGS
+                OUTPUT_STRIP_TRAILING_WHITESPACE)
+separate_arguments(LLVM_CXXFLAGS)
+foreach(D ${LLVM_CXXFLAGS})
+  if(${D} MATCHES "^-D")
+    set(LLVM_DEFINITIONS ${LLVM_DEFINITIONS} ${D})
+  elseif(${D} MATCHES "^-std=")
+    set(LLVM_CXX_FLAGS "${LLVM_CXX_FLAGS} ${D}")
+  else()
+    message(STATUS "Ignoring LLVM C++ flag '${D}'")
+  endif()
+endforeach()
+
+set(LLVM_FOUND TRUE)
@@ -0,0 +1,73 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "casadi_bench.hpp"
+#include <casadi/core/simd_kernels.hpp>
+#include <memory>
+
+using namespace casadi;
+using namespace std;
+
+/**
+ * Crossover between the built-in dense kernels and an external BLAS
+ *
+ * Times the dense matrix-matrix and matrix-vector products of simd_kernels.hpp
+ * for square matrices of increasing size, once with the built-in kernels and
+ * once handed to dgemm/dgemv. The smallest size where the BLAS wins is a
+ * sensible value for GlobalOptions::blas_threshold (given in multiply-adds).
+ * The BLAS variants are skipped unless CasADi is built with WITH_BLAS=ON.
+ */
+void blas_crossover_benchmarks(vector<Benchmark>& b) {
+  for (bool blas : {false, true}) {
+    string variant = blas ? "blas" : "builtin";
+    for (casadi_int n : {4, 8, 16, 32, 64, 128, 256, 512}) {
+      for (bool gemm : {true, false}) {
+        string kernel = gemm ? "gemm" : "gemv";
+        b.push_back({"blas_crossover/" + kernel + "_" + str(n) + "_" + variant,
+                     [n, blas, gemm](Dict& info) -> Op {
+          if (blas && !blas_available()) return nullptr;
+          auto x = make_shared<vector<double>>(random_vector(n*n, 1));
+          auto y = make_shared<vector<double>>(random_vector(n*n, 2));
+          auto z = make_shared<vector<double>>(n*n, 0);
+          info["simd_level"] = simd_level();
+          info["n_mac"] = gemm ? n*n*n : n*n;
+          // Hand all products to the BLAS, or none
+          casadi_int threshold = blas ? 0 : -1;
+          return [n, gemm, threshold, x, y, z]() {
+            casadi_int threshold0 = GlobalOptions::blas_threshold;
+            GlobalOptions::blas_threshold = threshold;
+            if (gemm) {
+              simd_gemm(n, n, n, get_ptr(*x), get_ptr(*y), get_ptr(*z));
+            } else {
+              simd_mv_dense(get_ptr(*x), n, n, get_ptr(*y), get_ptr(*z), false);
+            }
+            GlobalOptions::blas_threshold = threshold0;
+          };
+        }});
+      }
+    }
+  }
+}
@@ -0,0 +1,497 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#include "casadi_bench.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <random>
+
+using namespace casadi;
+using namespace std;
+
+/**
+ * Benchmark harness, the single entry point for all benchmarks in test/bench.
+ *
+ * Benchmarks are named group/case. The groups defined here cover function
+ * evaluation, derivative construction, sparsity pattern algorithms, maps,
+ * solvers and code generation. The groups in separate files (concurrent
+ * evaluation, SX graph construction, the vectorized kernels and the BLAS
+ * crossover) are declared in casadi_bench.hpp and registered in benchmarks().
+ *
+ * Each benchmark has an untimed setup returning the operation to be timed. The
+ * operation is repeated in samples of at least 1 ms until both a minimum number
+ * of samples and a minimum total time are reached, reporting the time per call.
+ * Random data is generated with fixed seeds, so that runs are reproducible.
+ *
+ * Usage: casadi_bench [--filter STR] [--min-time SEC] [--min-samples N]
+ *                     [--output FILE] [--list]
+ * where --filter selects the benchmarks whose name contains STR, e.g. a group.
+ */
+
+// Timing results
+struct Result {
+  string name;
+  casadi_int n_call, n_sample;
+  double t_min, t_median, t_mean;
+  Dict info;
+};
+
+// Evaluate a Function numerically with preallocated work vectors
+struct NumericCall {
+  Function f;
+  vector<vector<double>> in, out;
+  vector<const double*> arg;
+  vector<double*> res;
+  vector<casadi_int> iw;
+  vector<double> w;
+  int mem;
+  NumericCall(const Function& f, unsigned seed) : f(f) {
+    mt19937 gen(seed);
+    uniform_real_distribution<double> dist(0.1, 1.);
+    arg.resize(f.sz_arg(), nullptr);
+    res.resize(f.sz_res(), nullptr);
+    iw.resize(f.sz_iw());
+    w.resize(f.sz_w());
+    for (casadi_int i=0; i<f.n_in(); ++i) {
+      in.emplace_back(f.nnz_in(i));
+      for (double& v : in.back()) v = dist(gen);
+      arg[i] = get_ptr(in.back());
+    }
+    for (casadi_int i=0; i<f.n_out(); ++i) {
+      out.emplace_back(f.nnz_out(i));
+      res[i] = get_ptr(out.back());
+    }
+    mem = f.checkout();
+  }
+  ~NumericCall() { f.release(mem);}
+  void operator()() { f(get_ptr(arg), get_ptr(res), get_ptr(iw), get_ptr(w), mem);}
+};
+
+// Timed numerical evaluation of a Function
+Op eval_op(const Function& f, Dict& info, unsigned seed=1) {
+  if (f.is_a("SXFunction") || f.is_a("MXFunction")) {
+    info["n_instructions"] = f.n_instructions();
+  }
+  info["nnz_in"] = f.nnz_in();
+  info["nnz_out"] = f.nnz_out();
+  auto c = make_shared<NumericCall>(f, seed);
+  return [c]() { (*c)();};
+}
+
+vector<double> random_vector(casadi_int n, unsigned seed) {
+  mt19937 gen(seed);
+  uniform_real_distribution<double> dist(0.1, 1.);
+  vector<double> v(n);
+  for (double& e : v) e = dist(gen);
+  return v;
+}
+
+// Random sparsity pattern with about nz_per_col nonzeros per column and a full diagonal
+Sparsity random_sparsity(casadi_int n, casadi_int nz_per_col, unsigned seed) {
+  mt19937 gen(seed);
+  uniform_int_distribution<casadi_int> dist(0, n-1);
+  vector<casadi_int> row, col;
+  for (casadi_int c=0; c<n; ++c) {
+    row.push_back(c);
+    col.push_back(c);
+    for (casadi_int k=1; k<nz_per_col; ++k) {
+      row.push_back(dist(gen));
+      col.push_back(c);
+    }
+  }
+  return Sparsity::triplet(n, n, row, col);
+}
+
+// Chained Rosenbrock function
+template<typename M>
+M rosenbrock(const M& x) {
+  M f = 0;
+  for (casadi_int i=0; i+1<x.numel(); ++i) {
+    M xi = x(i), xn = x(i+1);
+    f += sq(1-xi) + 100*sq(xn-sq(xi));
+  }
+  return f;
+}
+
+// Van der Pol oscillator
+SXDict vdp_dae() {
+  SX x = SX::sym("x", 2), p = SX::sym("p");
+  SX x0 = x(0), x1 = x(1);
+  SX ode = vertcat(x1, p*(1-sq(x0))*x1 - x0);
+  return {{"x", x}, {"p", p}, {"ode", ode}};
+}
+
+// Small nonlinear model for maps: a few explicit Euler steps of the Van der Pol oscillator
+Function vdp_steps(casadi_int n_steps) {
+  SX x = SX::sym("x", 2), p = SX::sym("p");
+  SX xk = x;
+  for (casadi_int k=0; k<n_steps; ++k) {
+    SX x0 = xk(0), x1 = xk(1);
+    xk += 0.01*vertcat(x1, p*(1-sq(x0))*x1 - x0);
+  }
+  return Function("vdp_steps", {x, p}, {xk});
+}
+
+vector<Benchmark> benchmarks() {
+  vector<Benchmark> b;
+
+  // Numerical evaluation of SXFunction
+  b.push_back({"sx_eval/rosenbrock_grad_1000", [](Dict& info) {
+    SX x = SX::sym("x", 1000);
+    SX f = rosenbrock(x);
+    return eval_op(Function("f", {x}, {f, gradient(f, x)}), info);
+  }});
+  b.push_back({"sx_eval/expanded_map_500", [](Dict& info) {
+    return eval_op(vdp_steps(10).map(500).expand(), info);
+  }});
+
+  // Instruction throughput of the SXFunction virtual machine, with and without the bytecode
+  for (bool compact_tape : {false, true}) {
+    string name = "sx_eval/nlls_hessian_500_compact_tape_" + string(compact_tape ? "on" : "off");
+    b.push_back({name, [compact_tape](Dict& info) {
+      SX x = SX::sym("x", 500);
+      SX r = x(Slice(0, 498))*exp(0.1*x(Slice(1, 499))) - sin(x(Slice(2, 500))) + 1;
+      SX f = 0.5*sumsqr(r);
+      info["compact_tape"] = compact_tape;
+      return eval_op(Function("H", {x}, {hessian(f, x)}, Dict{{"compact_tape", compact_tape}}),
+                     info);
+    }});
+  }
+
+  // Numerical evaluation of MXFunction
+  b.push_back({"mx_eval/dense_ops_100", [](Dict& info) {
+    MX A = MX::sym("A", 100, 100), x = MX::sym("x", 100);
+    MX y = mtimes(A, x);
+    MX B = mtimes(A, A.T()) + sin(A);
+    MX z = mtimes(B, y) + dot(y, y)*x;
+    return eval_op(Function("f", {A, x}, {z, trace(B)}), info);
+  }});
+  b.push_back({"mx_eval/call_chain_200", [](Dict& info) {
+    Function g = vdp_steps(5);
+    MX x = MX::sym("x", 2), p = MX::sym("p");
+    MX xk = x;
+    for (casadi_int k=0; k<200; ++k) xk = g(vector<MX>{xk, p}).at(0);
+    return eval_op(Function("f", {x, p}, {xk}), info);
+  }});
+
+  // Construction of derivatives
+  b.push_back({"jacobian/sx_rosenbrock_grad_500", [](Dict& info) {
+    SX x = SX::sym("x", 500);
+    SX g = gradient(rosenbrock(x), x);
+    info["n"] = 500;
+    return [x, g]() { Function("J", {x}, {jacobian(g, x)});};
+  }});
+  b.push_back({"hessian/sx_rosenbrock_500", [](Dict& info) {
+    SX x = SX::sym("x", 500);
+    SX f = rosenbrock(x);
+    info["n"] = 500;
+    return [x, f]() { Function("H", {x}, {hessian(f, x)});};
+  }});
+  b.push_back({"jacobian/mx_call_chain_50", [](Dict& info) {
+    Function g = vdp_steps(5);
+    MX x = MX::sym("x", 2), p = MX::sym("p");
+    MX xk = x;
+    for (casadi_int k=0; k<50; ++k) xk = g(vector<MX>{xk, p}).at(0);
+    return [x, p, xk]() { Function("J", {x, p}, {jacobian(xk, vertcat(x, p))});};
+  }});
+  b.push_back({"jacobian/function_jacobian_expanded_map_200", [](Dict& info) {
+    Function f = vdp_steps(10).map(200).expand();
+    return [f]() { f.jacobian();};
+  }});
+
+  // Sparsity pattern algorithms
+  const casadi_int n_sp = 5000;
+  b.push_back({"sparsity/mtimes_5000", [n_sp](Dict& info) {
+    Sparsity A = random_sparsity(n_sp, 5, 1), B = random_sparsity(n_sp, 5, 2);
+    info["nnz"] = A.nnz();
+    return [A, B]() { Sparsity::mtimes(A, B);};
+  }});
+  b.push_back({"sparsity/transpose_5000", [n_sp](Dict& info) {
+    Sparsity A = random_sparsity(n_sp, 5, 1);
+    info["nnz"] = A.nnz();
+    return [A]() { vector<casadi_int> mapping; A.transpose(mapping);};
+  }});
+  b.push_back({"sparsity/uni_coloring_5000", [n_sp](Dict& info) {
+    Sparsity A = random_sparsity(n_sp, 5, 1);
+    info["nnz"] = A.nnz();
+    info["n_colors"] = A.uni_coloring().size2();
+    return [A]() { A.uni_coloring();};
+  }});
+  b.push_back({"sparsity/star_coloring_5000", [n_sp](Dict& info) {
+    Sparsity A = random_sparsity(n_sp, 3, 1);
+    Sparsity H = A + A.T();
+    info["nnz"] = H.nnz();
+    info["n_colors"] = H.star_coloring().size2();
+    return [H]() { H.star_coloring();};
+  }});
+  b.push_back({"sparsity/amd_5000", [n_sp](Dict& info) {
+    Sparsity A = random_sparsity(n_sp, 3, 1);
+    Sparsity H = A + A.T();
+    info["nnz"] = H.nnz();
+    return [H]() { H.amd();};
+  }});
+  b.push_back({"sparsity/btf_5000", [n_sp](Dict& info) {
+    Sparsity A = random_sparsity(n_sp, 3, 1);
+    info["nnz"] = A.nnz();
+    return [A]() {
+      vector<casadi_int> rowperm, colperm, rowblock, colblock, coarse_rowblock, coarse_colblock;
+      A.btf(rowperm, colperm, rowblock, colblock, coarse_rowblock, coarse_colblock);
+    };
+  }});
+  b.push_back({"sparsity/etree_5000", [n_sp](Dict& info) {
+    Sparsity A = random_sparsity(n_sp, 3, 1);
+    Sparsity H = A + A.T();
+    info["nnz"] = H.nnz();
+    return [H]() { H.etree();};
+  }});
+
+  // Map variants
+  for (string parallelization : {"serial", "unroll", "thread"}) {
+    b.push_back({"map/" + parallelization + "_1000", [parallelization](Dict& info) {
+      info["parallelization"] = parallelization;
+      return eval_op(vdp_steps(20).map(1000, parallelization), info);
+    }});
+  }
+
+  // Solvers
+  b.push_back({"nlpsol/sqpmethod_rosenbrock_20", [](Dict& info) -> Op {
+    if (!has_nlpsol("sqpmethod") || !has_conic("qrqp")) return nullptr;
+    SX x = SX::sym("x", 20);
+    Dict opts = {{"qpsol", "qrqp"}, {"print_header", false}, {"print_iteration", false},
+                 {"print_status", false}, {"print_time", false},
+                 {"qpsol_options", Dict{{"print_iter", false}, {"print_header", false},
+                                        {"print_info", false}}}};
+    Function solver = nlpsol("solver", "sqpmethod", SXDict{{"x", x}, {"f", rosenbrock(x)}}, opts);
+    DMDict arg = {{"x0", DM::zeros(20)}};
+    return [solver, arg]() { solver(arg);};
+  }});
+  for (string plugin : {"cvodes", "rk", "erk", "collocation"}) {
+    b.push_back({"integrator/" + plugin + "_vdp", [plugin](Dict& info) -> Op {
+      if (!has_integrator(plugin)) return nullptr;
+      Function F = integrator("F", plugin, vdp_dae(), Dict{{"tf", 10.}});
+      DMDict arg = {{"x0", DM(vector<double>{1, 0})}, {"p", 1.}};
+      return [F, arg]() { F(arg);};
+    }});
+  }
+
+  // Code generation
+  b.push_back({"codegen/sx_rosenbrock_grad_1000", [](Dict& info) {
+    SX x = SX::sym("x", 1000);
+    SX f = rosenbrock(x);
+    Function F("f", {x}, {f, gradient(f, x)});
+    info["n_instructions"] = F.n_instructions();
+    return [F]() {
+      CodeGenerator g("bench");
+      g.add(F);
+      g.dump();
+    };
+  }});
+  b.push_back({"codegen/mx_call_chain_200", [](Dict& info) {
+    Function g = vdp_steps(5);
+    MX x = MX::sym("x", 2), p = MX::sym("p");
+    MX xk = x;
+    for (casadi_int k=0; k<200; ++k) xk = g(vector<MX>{xk, p}).at(0);
+    Function F("f", {x, p}, {xk});
+    info["n_instructions"] = F.n_instructions();
+    return [F]() {
+      CodeGenerator g("bench");
+      g.add(F);
+      g.dump();
+    };
+  }});
+
+  // Benchmark groups defined in separate files
+  checkout_benchmarks(b);
+  sx_construction_benchmarks(b);
+  simd_kernels_benchmarks(b);
+  blas_crossover_benchmarks(b);
+
+  return b;
+}
+
+double elapsed(chrono::steady_clock::time_point t0) {
+  return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+// Time an operation: samples of at least 1 ms until min_samples and min_time are reached
+Result run(const string& name, const Op& op, const Dict& info,
+           double min_time, casadi_int min_samples) {
+  // Warm-up, also used to calibrate the number of calls per sample
+  auto t0 = chrono::steady_clock::now();
+  op();
+  double t_first = elapsed(t0);
+  casadi_int n_inner = max(casadi_int(1), static_cast<casadi_int>(1e-3/max(t_first, 1e-9)));
+
+  vector<double> t_sample;
+  double t_total = 0;
+  while (t_sample.size()<min_samples || t_total<min_time) {
+    t0 = chrono::steady_clock::now();
+    for (casadi_int k=0; k<n_inner; ++k) op();
+    double t = elapsed(t0);
+    t_total += t;
+    t_sample.push_back(t/n_inner);
+  }
+
+  Result r;
+  r.name = name;
+  r.info = info;
+  r.n_sample = t_sample.size();
+  r.n_call = r.n_sample*n_inner;
+  r.t_mean = t_total/r.n_call;
+  sort(t_sample.begin(), t_sample.end());
+  r.t_min = t_sample.front();
+  r.t_median = t_sample[t_sample.size()/2];
+  return r;
+}
+
+string json_string(const string& s) {
+  stringstream ss;
+  ss << "\"";
+  for (char c : s) {
+    if (c=='"' || c=='\\') {
+      ss << "\\" << c;
+    } else if (c=='\n') {
+      ss << "\\n";
+    } else if (static_cast<unsigned char>(c)>=0x20) {
+      ss << c;
+    }
+  }
+  ss << "\"";
+  return ss.str();
+}
+
+string json_value(const GenericType& v) {
+  if (v.is_bool()) return v.as_bool() ? "true" : "false";
+  if (v.is_int()) return str(v.as_int());
+  if (v.is_double()) {
+    stringstream ss;
+    ss << setprecision(17) << v.as_double();
+    return ss.str();
+  }
+  return json_string(v.to_string());
+}
+
+void write_json(ostream& s, const vector<Result>& results, double min_time,
+                casadi_int min_samples) {
+  char date[32];
+  time_t now = time(nullptr);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+  s << "{\n";
+  s << "  \"casadi_version\": " << json_string(CasadiMeta::version()) << ",\n";
+  s << "  \"git_revision\": " << json_string(CasadiMeta::git_revision()) << ",\n";
+  s << "  \"compiler\": " << json_string(CasadiMeta::compiler_id()) << ",\n";
+  s << "  \"build_type\": " << json_string(CasadiMeta::build_type()) << ",\n";
+  s << "  \"date\": " << json_string(date) << ",\n";
+  s << "  \"min_time\": " << min_time << ",\n";
+  s << "  \"min_samples\": " << min_samples << ",\n";
+  s << "  \"benchmarks\": [";
+  for (casadi_int i=0; i<results.size(); ++i) {
+    const Result& r = results[i];
+    s << (i==0 ? "\n" : ",\n");
+    s << "    {\"name\": " << json_string(r.name)
+      << ", \"n_call\": " << r.n_call
+      << ", \"n_sample\": " << r.n_sample << setprecision(6) << scientific
+      << ", \"t_min\": " << r.t_min
+      << ", \"t_median\": " << r.t_median
+      << ", \"t_mean\": " << r.t_mean << defaultfloat
+      << ", \"info\": {";
+    bool first = true;
+    for (auto&& e : r.info) {
+      s << (first ? "" : ", ") << json_string(e.first) << ": " << json_value(e.second);
+      first = false;
+    }
+    s << "}}";
+  }
+  s << "\n  ]\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+  string filter, output;
+  double min_time = 0.5;
+  casadi_int min_samples = 5;
+  bool list = false;
+  for (int i=1; i<argc; ++i) {
+    string a = argv[i];
+    bool has_value = i+1<argc;
+    if (a=="--filter" && has_value) {
+      filter = argv[++i];
+    } else if (a=="--min-time" && has_value) {
+      min_time = atof(argv[++i]);
+    } else if (a=="--min-samples" && has_value) {
+      min_samples = atoi(argv[++i]);
+    } else if (a=="--output" && has_value) {
+      output = argv[++i];
+    } else if (a=="--list") {
+      list = true;
+    } else {
+      cerr << "Usage: " << argv[0] << " [--filter STR] [--min-time SEC] [--min-samples N] "
+           << "[--output FILE] [--list]" << endl;
+      return a=="--help" ? 0 : 1;
+    }
+  }
+
+  vector<Result> results;
+  if (!list) {
+    cout << setw(48) << left << "benchmark" << setw(10) << right << "calls"
+         << setw(14) << "min [us]" << setw(14) << "median [us]" << endl;
+  }
+  for (auto&& b : benchmarks()) {
+    if (b.name.find(filter)==string::npos) continue;
+    if (list) {
+      cout << b.name << endl;
+      continue;
+    }
+    Dict info;
+    Op op;
+    try {
+      op = b.setup(info);
+    } catch (exception& e) {
+      cout << setw(48) << left << b.name << " skipped: " << e.what() << endl;
+      continue;
+    }
+    if (!op) {
+      cout << setw(48) << left << b.name << " skipped: not available" << endl;
+      continue;
+    }
+    Result r = run(b.name, op, info, min_time, min_samples);
+    cout << setw(48) << left << r.name << setw(10) << right << r.n_call << fixed
+         << setprecision(2) << setw(14) << 1e6*r.t_min << setw(14) << 1e6*r.t_median
+         << defaultfloat << endl;
+    results.push_back(r);
+  }
+
+  if (!output.empty()) {
+    ofstream f(output);
+    casadi_assert(f.good(), "Cannot open " + output);
+    write_json(f, results, min_time, min_samples);
+    cout << "Results written to " << output << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,65 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef CASADI_BENCH_HPP
+#define CASADI_BENCH_HPP
+
+#include <casadi/casadi.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Shared definitions of the benchmark harness. A group of benchmarks in a
+ * separate file provides a function appending its benchmarks, declared below,
+ * which is called from benchmarks() in casadi_bench.cpp. Its source file is
+ * added to the casadi_bench target in CMakeLists.txt.
+ */
+
+// Operation to be timed
+typedef std::function<void()> Op;
+
+// A named benchmark: the setup fills in problem information and returns the operation
+struct Benchmark {
+  std::string name;
+  std::function<Op(casadi::Dict& info)> setup;
+};
+
+// Random vector with entries in [0.1, 1) and a fixed seed
+std::vector<double> random_vector(casadi_int n, unsigned seed);
+
+// Concurrent evaluation of a shared Function, checkout_stress.cpp
+void checkout_benchmarks(std::vector<Benchmark>& b);
+
+// Construction and destruction of large SX graphs, sx_construction.cpp
+void sx_construction_benchmarks(std::vector<Benchmark>& b);
+
+// Vectorized numerical kernels against the scalar runtime, simd_kernels.cpp
+void simd_kernels_benchmarks(std::vector<Benchmark>& b);
+
+// Built-in dense kernels against an external BLAS, blas_crossover.cpp
+void blas_crossover_benchmarks(std::vector<Benchmark>& b);
+
+#endif // CASADI_BENCH_HPP
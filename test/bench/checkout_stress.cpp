@@ -0,0 +1,92 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "casadi_bench.hpp"
+#include <atomic>
+#include <memory>
+#ifdef CASADI_WITH_THREAD
+#ifdef CASADI_WITH_THREAD_MINGW
+#include <mingw.thread.h>
+#else // CASADI_WITH_THREAD_MINGW
+#include <thread>
+#endif // CASADI_WITH_THREAD_MINGW
+#endif // CASADI_WITH_THREAD
+
+using namespace casadi;
+using namespace std;
+
+/**
+ * Concurrent evaluation of a shared Function
+ *
+ * Several threads repeatedly evaluate the same (cheap) Function through the
+ * checkout/release interface, so that the cost of obtaining a memory object
+ * dominates. One operation is calls_per_thread evaluations in each thread,
+ * the results are checked.
+ */
+void checkout_benchmarks(vector<Benchmark>& b) {
+#ifdef CASADI_WITH_THREAD
+  for (casadi_int n_threads : {1, 2, 4, 8}) {
+    b.push_back({"checkout/shared_function_" + str(n_threads) + "_threads",
+                 [n_threads](Dict& info) {
+      const casadi_int n_calls = 10000;
+      info["n_threads"] = n_threads;
+      info["calls_per_thread"] = n_calls;
+
+      // A cheap function, so that overhead dominates
+      SX x = SX::sym("x"), y = SX::sym("y");
+      Function f("f", {x, y}, {sin(x)*y + x});
+
+      // Work vector sizes
+      auto sz = make_shared<vector<size_t>>(4);
+      f.sz_work(sz->at(0), sz->at(1), sz->at(2), sz->at(3));
+
+      return [f, sz, n_threads, n_calls]() {
+        atomic<casadi_int> n_errors(0);
+        auto work = [&](casadi_int t) {
+          // Thread-local work vectors
+          vector<const double*> arg(sz->at(0));
+          vector<double*> res(sz->at(1));
+          vector<casadi_int> iw(sz->at(2));
+          vector<double> w(sz->at(3));
+          double xv = 0.1*static_cast<double>(t), yv = 2, r;
+          arg[0] = &xv;
+          arg[1] = &yv;
+          res[0] = &r;
+          for (casadi_int k=0; k<n_calls; ++k) {
+            // Checks out and releases a memory object on every call
+            if (f(get_ptr(arg), get_ptr(res), get_ptr(iw), get_ptr(w))) n_errors++;
+            if (r!=sin(xv)*yv + xv) n_errors++;
+          }
+        };
+        vector<thread> threads;
+        for (casadi_int t=0; t<n_threads; ++t) threads.emplace_back(work, t);
+        for (auto&& th : threads) th.join();
+        casadi_assert(n_errors==0, str(n_errors.load()) + " incorrect evaluations");
+      };
+    }});
+  }
+#endif // CASADI_WITH_THREAD
+}
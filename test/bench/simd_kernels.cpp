@@ -0,0 +1,120 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "casadi_bench.hpp"
+#include <casadi/core/simd_kernels.hpp>
+#include <memory>
+#include <random>
+
+using namespace casadi;
+using namespace std;
+
+/**
+ * Vectorized numerical kernels
+ *
+ * Compares the kernels in simd_kernels.hpp ("simd") with the scalar C runtime
+ * routines casadi_dot, casadi_axpy and casadi_mtimes ("scalar") for vectors of
+ * different lengths and 200-by-200 matrix products with different densities of
+ * the right factor. The instruction set and the relative deviation from the
+ * scalar routine are reported in the benchmark info.
+ */
+
+// Random n-by-n matrix with the given density
+DM random_matrix(casadi_int n, double density, unsigned seed) {
+  mt19937 gen(seed);
+  uniform_real_distribution<double> dist(0, 1);
+  vector<casadi_int> r, c;
+  for (casadi_int j=0; j<n; ++j) {
+    for (casadi_int i=0; i<n; ++i) {
+      if (density>=1 || dist(gen)<density) {
+        r.push_back(i);
+        c.push_back(j);
+      }
+    }
+  }
+  Sparsity sp = Sparsity::triplet(n, n, r, c);
+  return DM(sp, random_vector(sp.nnz(), seed + 1));
+}
+
+void simd_kernels_benchmarks(vector<Benchmark>& b) {
+  for (bool simd : {false, true}) {
+    string variant = simd ? "simd" : "scalar";
+
+    // Vector kernels
+    for (casadi_int len : {100, 10000, 1000000}) {
+      b.push_back({"simd_kernels/dot_" + str(len) + "_" + variant, [len, simd](Dict& info) {
+        auto x = make_shared<vector<double>>(random_vector(len, 1));
+        auto y = make_shared<vector<double>>(random_vector(len, 2));
+        double d_ref = casadi_dot(len, get_ptr(*x), get_ptr(*y));
+        double d = simd_dot(len, get_ptr(*x), get_ptr(*y));
+        info["simd_level"] = simd_level();
+        info["rel_error"] = fabs(d - d_ref)/fabs(d_ref);
+        // Keep the result, so that the call is not optimized away
+        auto r = make_shared<double>();
+        if (simd) return Op([len, x, y, r]() { *r = simd_dot(len, get_ptr(*x), get_ptr(*y));});
+        return Op([len, x, y, r]() { *r = casadi_dot(len, get_ptr(*x), get_ptr(*y));});
+      }});
+      b.push_back({"simd_kernels/axpy_" + str(len) + "_" + variant, [len, simd](Dict& info) {
+        auto x = make_shared<vector<double>>(random_vector(len, 1));
+        auto y = make_shared<vector<double>>(random_vector(len, 2));
+        info["simd_level"] = simd_level();
+        if (simd) return Op([len, x, y]() { simd_axpy(len, 1e-9, get_ptr(*x), get_ptr(*y));});
+        return Op([len, x, y]() { casadi_axpy(len, 1e-9, get_ptr(*x), get_ptr(*y));});
+      }});
+    }
+
+    // Matrix products with a dense left factor and different densities of the right factor
+    for (double density : {1., 0.5, 0.1, 0.01}) {
+      b.push_back({"simd_kernels/mtimes_200_density_" + str(density) + "_" + variant,
+                   [density, simd](Dict& info) {
+        const casadi_int n = 200;
+        auto x = make_shared<DM>(random_matrix(n, 1, 1));
+        auto y = make_shared<DM>(random_matrix(n, density, 3));
+        auto z = make_shared<DM>(DM::zeros(n, n));
+        auto w = make_shared<vector<double>>(n);
+        // Compare results after a single product
+        DM z_ref = DM::zeros(n, n);
+        casadi_mtimes(x->ptr(), x->sparsity(), y->ptr(), y->sparsity(),
+                      z_ref.ptr(), z_ref.sparsity(), get_ptr(*w), false);
+        simd_mtimes(x->ptr(), x->sparsity(), y->ptr(), y->sparsity(),
+                    z->ptr(), z->sparsity(), get_ptr(*w), false);
+        info["simd_level"] = simd_level();
+        info["nnz"] = y->nnz();
+        info["rel_error"] = norm_inf(z_ref - *z).scalar()/norm_inf(z_ref).scalar();
+        if (simd) {
+          return Op([x, y, z, w]() {
+            simd_mtimes(x->ptr(), x->sparsity(), y->ptr(), y->sparsity(),
+                        z->ptr(), z->sparsity(), get_ptr(*w), false);
+          });
+        }
+        return Op([x, y, z, w]() {
+          casadi_mtimes(x->ptr(), x->sparsity(), y->ptr(), y->sparsity(),
+                        z->ptr(), z->sparsity(), get_ptr(*w), false);
+        });
+      }});
+    }
+  }
+}
@@ -0,0 +1,90 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010-2014 Joel Andersson, Joris Gillis, Moritz Diehl,
+ *                            K.U. Leuven. All rights reserved.
+ *    Copyright (C) 2011-2014 Greg Horn
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+#include "casadi_bench.hpp"
+#include <fstream>
+#ifndef _WIN32
+#include <unistd.h>
+#endif // _WIN32
+
+using namespace casadi;
+using namespace std;
+
+/**
+ * Construction and destruction of large SX graphs
+ *
+ * Builds a long chain of scalar operations and destroys it again, with and
+ * without GlobalOptions::sx_node_pool. The growth of the resident set size
+ * after construction and after destruction of one graph is reported in the
+ * benchmark info.
+ */
+
+// Resident set size in MiB, 0 if not available
+double rss_mib() {
+#ifdef _WIN32
+  return 0;
+#else // _WIN32
+  ifstream statm("/proc/self/statm");
+  double pages = 0, rss = 0;
+  if (!(statm >> pages >> rss)) return 0;
+  return rss*static_cast<double>(sysconf(_SC_PAGESIZE))/(1024*1024);
+#endif // _WIN32
+}
+
+// Chain of scalar operations, each step creates several nodes including a new constant
+SX sx_chain(const SX& x, casadi_int n_steps) {
+  vector<SXElem> z(x.nonzeros());
+  for (casadi_int k=0; k<n_steps; ++k) {
+    SXElem& zk = z[k % z.size()];
+    zk = sin(zk*z[(k+1) % z.size()] + static_cast<double>(k)) - zk/2;
+  }
+  return SX(z);
+}
+
+void sx_construction_benchmarks(vector<Benchmark>& b) {
+  for (bool pool : {false, true}) {
+    b.push_back({"sx_construction/chain_100000_" + string(pool ? "pool" : "heap"),
+                 [pool](Dict& info) {
+      const casadi_int n_steps = 100000;
+      SX x = SX::sym("x", 16);
+      bool pool0 = GlobalOptions::getSXNodePool();
+      GlobalOptions::setSXNodePool(pool);
+      double rss0 = rss_mib();
+      SX f = sx_chain(x, n_steps);
+      info["n_nodes"] = SX::n_nodes(f);
+      info["rss_mib_constructed"] = rss_mib() - rss0;
+      f = SX();
+      info["rss_mib_destroyed"] = rss_mib() - rss0;
+      GlobalOptions::setSXNodePool(pool0);
+      return [x, n_steps, pool]() {
+        bool pool0 = GlobalOptions::getSXNodePool();
+        GlobalOptions::setSXNodePool(pool);
+        sx_chain(x, n_steps);
+        GlobalOptions::setSXNodePool(pool0);
+      };
+    }});
+  }
+}
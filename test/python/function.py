@@ -627,6 +627,10 @@ class Functiontests(casadiTestCase):
     self.checkfunction_light(fun.map(4,"thread",2),fun.map(4),inputs=[hcat(X_[:4]),hcat(Y_[:4]),hcat(Z_[:4]),hcat(V_[:4])])
     self.checkfunction_light(fun.map(4,"thread",5),fun.map(4),inputs=[hcat(X_[:4]),hcat(Y_[:4]),hcat(Z_[:4]),hcat(V_[:4])])
 
+    F = fun.map(10,"thread",3)
+    self.assertEqual(F.info()["max_num_threads"],3)
+    self.checkfunction_light(F,fun.map(10),inputs=[hcat(X_),hcat(Y_),hcat(Z_),hcat(V_)])
+
   @memory_heavy()
   def test_mapsum(self):
     x = SX.sym("x")
@@ -904,6 +908,18 @@ class Functiontests(casadiTestCase):
     for sf,sF in zip(scheme_out_fun,scheme_out_F):
       self.assertTrue(sf==sF)
 
+  @requiresPlugin(Importer,"llvm")
+  def test_jitfunction_llvm(self):
+    x = SX.sym("x",3)
+    p = SX.sym("p")
+    e = vertcat(sin(x[0])*p, if_else(x[1]<p,exp(x[1]),erf(x[2])), fmax(x[2],p)**3)
+    f = Function("f",[x,p],[e,jacobian(e,x)])
+    for opt_level in [0,2]:
+      F = Function("f",[x,p],[e,jacobian(e,x)],{'jit':True,'compiler':'llvm','jit_options':{'opt_level':opt_level}})
+      self.checkfunction(F,f,inputs=[DM([0.3,-0.2,0.7]),0.1],hessian=False)
+      F = Function.deserialize(F.serialize())
+      self.checkfunction(F,f,inputs=[DM([0.3,-0.2,0.7]),0.1],hessian=False)
+
   # @requiresPlugin(Importer,"clang")
   # def test_jitfunction_clang(self):
   #   x = MX.sym("x")
@@ -1777,6 +1793,81 @@ class Functiontests(casadiTestCase):
 
     self.assertTrue("ffff_acc4_acc4_acc4" in code)
 
+  def test_jac_num_threads(self):
+    x = MX.sym("x",20)
+    e = x
+    for k in range(3):
+      e = sin(mtimes(DM.rand(20,20),e))+x*e
+    ref = Function("ref",[x],[jacobian(e,x),jacobian(dot(e,e)*vertcat(x[0],x[1]),x)])
+    for num_threads in [1,3]:
+      opts = {"max_num_dir":4,"jac_num_threads":num_threads}
+      f = Function("f",[x],[e,dot(e,e)*vertcat(x[0],x[1])],opts)
+      J = Function("J",[x],[jacobian(f(x)[0],x),jacobian(f(x)[1],x)],opts)
+      x0 = DM.rand(20)
+      for r,s in zip(J(x0),ref(x0)):
+        self.checkarray(r,s,digits=10)
+      self.checkarray(f.jacobian()(x0,DM(),DM()),vertcat(*ref(x0)),digits=10)
+      self.checkfunction_light(Function.deserialize(f.serialize()),f,inputs=[x0])
+
+  def test_eval_num_threads(self):
+    x = MX.sym("x",5)
+    y = MX.sym("y",5)
+    f = Function("f",[x,y],[sin(x)*y+cos(y),mtimes(DM.rand(5,5),x)*y])
+    g = Function("g",[x],[cumsum(x)**2])
+    # Several independent calls, followed by calls depending on them
+    r = [f(x*k,y) for k in range(4)]
+    e = [g(a+b) for a,b in r]
+    e = [e[0]*e[1], e[2]-e[3], f(e[0],e[2])[1], x]
+    ref = Function("ref",[x,y],e)
+    inputs = [DM.rand(5),DM.rand(5)]
+    for live in [None, True]:
+      opts = {"eval_num_threads":3,"record_time":True}
+      if live is not None: opts["live_variables"] = live
+      F = Function("F",[x,y],e,opts)
+      self.checkfunction_light(F,ref,inputs=inputs)
+      F(*inputs)
+      stats = F.stats()
+      self.assertEqual(len(stats["t_wall_node"]),F.n_instructions())
+      self.assertTrue(max(stats["level_node"])<F.n_instructions()-1)
+      self.checkfunction_light(Function.deserialize(F.serialize()),ref,inputs=inputs)
+
+  def test_alias_io(self):
+    x = MX.sym("x",4)
+    y = MX.sym("y",2,2)
+    p = MX.sym("p")
+    z = x*p
+    z[1] = p**2
+    e = [sin(x)*p, x, mtimes(y,x[:2])+z[2:], z, vec(y)]
+    ref = Function("ref",[x,y,p],e,{"alias_io":False})
+    F = Function("F",[x,y,p],e)
+    inputs = [DM.rand(4),DM.rand(2,2),DM.rand(1)]
+    self.checkfunction(F,ref,inputs=inputs)
+    self.check_codegen(F,inputs=inputs)
+    self.check_serialize(F,inputs=inputs)
+    # Null inputs and outputs
+    self.checkarray(F(x=inputs[0],p=3)["o2"],ref(x=inputs[0],p=3)["o2"])
+    self.assertTrue(F.sz_w()<=ref.sz_w())
+
+  def test_work_allocation(self):
+    x = MX.sym("x",10)
+    A = MX.sym("A",10,10)
+    # Mix of large and small intermediate results of different sizes
+    e = x
+    for k in range(4):
+      B = mtimes(A,A.T)+k
+      e = mtimes(B,e)/(1+dot(e,e))
+      e = vertcat(e[:5]*sum1(e[5:]),sin(e[5:]))
+      e = e + sum1(B[:9,k])
+    ref = Function("ref",[x,A],[e],{"live_variables":False})
+    F = Function("F",[x,A],[e])
+    self.checkfunction(F,ref,inputs=[DM.rand(10),DM.rand(10,10)])
+    self.check_codegen(F,inputs=[DM.rand(10),DM.rand(10,10)])
+    stats = F.stats()
+    self.assertTrue(stats["w_bytes"]<stats["w_bytes_total"])
+    self.assertTrue(F.sz_w()<ref.sz_w())
+    stats = ref.stats()
+    self.assertEqual(stats["w_bytes"],stats["w_bytes_total"])
+
   def test_2d_linear_multiout(self):
     np.random.seed(0)
 
@@ -1946,6 +2037,53 @@ class Functiontests(casadiTestCase):
     self.check_codegen(f,inputs=[np.random.random((3,3))])
     self.check_codegen(f,inputs=[np.random.random((3,3))], opts={"avoid_stack": True})
 
+  def test_codegen_split(self):
+    x = SX.sym("x",4,4)
+    y = SX.sym("y")
+    f = Function('f',[x,y],[det(x)*y,sin(x)+y,y**2])
+    np.random.seed(0)
+    inputs = [np.random.random((4,4)),2.5]
+    for opts in [{"max_body_size":1},{"max_body_size":7},{"max_body_size":7,"avoid_stack":True},{"max_body_size":10000}]:
+      self.check_codegen(f,inputs=inputs,opts=opts)
+
+  @requiresPlugin(Importer,"shell")
+  def test_jit_split(self):
+    x = SX.sym("x",4,4)
+    y = SX.sym("y")
+    f = Function('f',[x,y],[det(x)*y,sin(x)+y])
+    np.random.seed(0)
+    inputs = [np.random.random((4,4)),2.5]
+    # Parts in separate compilation units, compiled in parallel
+    g = Function('f',[x,y],[det(x)*y,sin(x)+y],{"jit":True,"compiler":"shell",
+      "jit_codegen_options":{"max_body_size":20,"split_files":True},
+      "jit_options":{"max_jobs":2}})
+    self.checkfunction_light(f,g,inputs=inputs)
+
+  def test_codegen_roll_loops(self):
+    x = SX.sym("x",3)
+    p = SX.sym("p")
+    f = Function('f',[x,p],[vertcat(sin(x[0])*x[1]+p,x[2]**2-cos(x[0]*p),3.7*x[1])])
+    # Expanded map: identical instances except for input/output offsets
+    F = f.map(20).expand()
+    # Expanded mapaccum: instances chained, partially rollable
+    G = Function('g',[x,p],[f(x,p)]).mapaccum(10).expand()
+    np.random.seed(0)
+    for opts in [{"roll_loops":True},{"roll_loops":True,"avoid_stack":True},
+                 {"roll_loops":True,"max_body_size":100}]:
+      self.check_codegen(F,inputs=[np.random.random((3,20)),np.random.random((1,20))],opts=opts)
+      self.check_codegen(G,inputs=[np.random.random((3,1)),np.random.random((1,10))],opts=opts)
+
+  @requiresPlugin(Importer,"shell")
+  def test_jit_split_roll_loops(self):
+    x = SX.sym("x",10)
+    # Gather with a non-affine index: rolled loops need an index table in each part
+    idx = [3,1,4,1,5,9,2,6,5,3,5,8,9,7,9,3,2,3,8,4,6,2,6,4,3,3,8,3,2,7,9,5,0,2,8,8,4,1,9,7]
+    y = vertcat(*[sin(x[i])*x[i]+2.5 for i in idx])
+    f = Function('f',[x],[y])
+    g = Function('f',[x],[y],{"jit":True,"compiler":"shell",
+      "jit_codegen_options":{"roll_loops":True,"max_body_size":100,"split_files":True},
+      "jit_options":{"max_jobs":2}})
+    self.checkfunction_light(f,g,inputs=[np.random.random(10)])
 
   def test_serialize(self):
     for opts in [{"debug":True},{}]:
@@ -2437,6 +2575,74 @@ class Functiontests(casadiTestCase):
     with self.assertOutput("2 forward sweeps needed","1 reverse sweeps needed"):
       jacobian(f(sin(x)),x)
 
+  def test_map_sx_batch(self):
+    x = SX.sym("x")
+    y = SX.sym("y",2)
+    z = SX.sym("z",2,2)
+
+    fun = Function("f",[x,y,z],[mtimes(z,y)+x,sin(y*x).T,3])
+
+    for n in [1,7,8,19]:
+      X_ = [ DM(x.sparsity(),np.random.random(x.nnz())) for i in range(n) ]
+      Y_ = [ DM(y.sparsity(),np.random.random(y.nnz())) for i in range(n) ]
+      Z_ = [ DM(z.sparsity(),np.random.random(z.nnz())) for i in range(n) ]
+
+      res = fun.map(n)(hcat(X_),hcat(Y_),hcat(Z_))
+      resref = [fun(*e) for e in zip(X_,Y_,Z_)]
+      for i in range(fun.n_out()):
+        self.checkarray(res[i],hcat([r[i] for r in resref]))
+
+  def test_compact_tape(self):
+    x = SX.sym("x",3)
+    y = SX.sym("y")
+
+    e = vertcat(sin(x*y)+x*y+2, 3-x/y, 1/(x+y), exp(x)*y+1, fmax(x,0.1)*x[0]+x[1], sqrt(x*x+y), 7)
+
+    f = Function("f",[x,y],[e,dot(e,e)])
+    g = Function("g",[x,y],[e,dot(e,e)],{"compact_tape":True})
+
+    X_ = DM([0.1,0.2,0.3])
+    for r,r_ref in zip(g(X_,0.7),f(X_,0.7)):
+      self.checkarray(r,r_ref)
+
+    g = Function.deserialize(g.serialize())
+    for r,r_ref in zip(g(X_,0.7),f(X_,0.7)):
+      self.checkarray(r,r_ref)
+
+  def test_precision(self):
+    x = SX.sym("x",3)
+    y = SX.sym("y")
+
+    e = vertcat(sin(x*y)+x*y+2, 3-x/y, 1/(x+y), exp(x)*y+1, fmax(x,0.1)*x[0]+x[1], sqrt(x*x+y), 7)
+
+    f = Function("f",[x,y],[e,dot(e,e)])
+    X_ = DM([0.1,0.2,0.3])
+    for precision in ["single","mixed"]:
+      g = Function("g",[x,y],[e,dot(e,e)],{"precision":precision})
+      for r,r_ref in zip(g(X_,0.7),f(X_,0.7)):
+        self.checkarray(r,r_ref,digits=5)
+        self.assertTrue(float(norm_inf(r-r_ref))>0)
+
+      # Evaluate in both precisions, returning the reduced precision result
+      g = Function("g",[x,y],[e,dot(e,e)],{"precision":precision,"precision_check":True})
+      g(X_,0.7)
+      dev = g.stats()["precision_deviation"]
+      self.assertEqual(len(dev),2)
+      for d in dev: self.assertTrue(0<d<1e-5)
+
+      g = Function.deserialize(g.serialize())
+      for r,r_ref in zip(g(X_,0.7),f(X_,0.7)):
+        self.checkarray(r,r_ref,digits=5)
+
+    # Double precision result, deviation of single precision
+    g = Function("g",[x,y],[e,dot(e,e)],{"precision_check":True})
+    for r,r_ref in zip(g(X_,0.7),f(X_,0.7)):
+      self.checkarray(r,r_ref)
+    self.assertTrue(max(g.stats()["precision_deviation_max"])>0)
+
+    with self.assertInException("Unknown precision"):
+      Function("g",[x,y],[e],{"precision":"half"})
+
   def test_map_exception(self):
     x = MX.sym("x",4)
     y = MX.sym("y",4)
@@ -2629,6 +2835,41 @@ class Functiontests(casadiTestCase):
     f = Function("f",[],[c])
     self.check_codegen(f,inputs=[])
 
+  @requiresPlugin(Importer,"shell")
+  def test_jit_cache(self):
+    import tempfile
+    import shutil
+    cache_dir = tempfile.mkdtemp()
+    try:
+      GlobalOptions.setJitCacheDir(cache_dir)
+      x = SX.sym("x",2)
+      opts = {"jit":True,"compiler":"shell"}
+      ref = Function('f',[x],[sin(x)*x[0]])
+      stats0 = Importer.cache_stats()
+      f = Function('f',[x],[sin(x)*x[0]],opts)
+      self.checkfunction_light(f,ref,inputs=[DM([0.1,0.7])])
+      stats1 = Importer.cache_stats()
+      self.assertEqual(stats1["misses"]-stats0["misses"],1)
+      self.assertEqual(stats1["stores"]-stats0["stores"],1)
+      # Identical function: loaded from the cache
+      g = Function('f',[x],[sin(x)*x[0]],opts)
+      self.checkfunction_light(g,ref,inputs=[DM([0.1,0.7])])
+      stats2 = Importer.cache_stats()
+      self.assertEqual(stats2["hits"]-stats1["hits"],1)
+      self.assertEqual(stats2["entries"],1)
+      # Different flags: new entry, evicting the old one
+      GlobalOptions.setJitCacheSize(1)
+      h = Function('f',[x],[sin(x)*x[0]],{"jit":True,"compiler":"shell","jit_options":{"flags":["-O1"]}})
+      self.checkfunction_light(h,ref,inputs=[DM([0.1,0.7])])
+      stats3 = Importer.cache_stats()
+      self.assertEqual(stats3["misses"]-stats2["misses"],1)
+      self.assertEqual(stats3["entries"],1)
+      self.assertTrue(stats3["evictions"]>stats2["evictions"])
+    finally:
+      GlobalOptions.setJitCacheDir("")
+      GlobalOptions.setJitCacheSize(1073741824)
+      shutil.rmtree(cache_dir)
+
   def test_jit_serialize(self):
     if not args.run_slow: return
 
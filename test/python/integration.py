@@ -56,6 +56,8 @@ integrators.append(("collocation",["dae","ode"],{"rootfinder":"newton","number_o
 
 integrators.append(("rk",["ode"],{"number_of_finite_elements": 1000}))
 
+integrators.append(("erk",["ode"],{"abstol": 1e-12,"reltol":1e-12}))
+
 integrators.append(("collocation",["dae","ode"],{"rootfinder":"newton","number_of_finite_elements": 18,"simplify":True,"rootfinder":"fast_newton"}))
 
 integrators.append(("rk",["ode"],{"number_of_finite_elements": 1000,"simplify":True}))
@@ -1102,6 +1104,146 @@ class Integrationtests(casadiTestCase):
       sol = I(x0=0, p=0.15)
       # xf:0.259754<=0, zf:0.26948<=0
 
+  def test_batch(self):
+    x = SX.sym("x",2)
+    p = SX.sym("p")
+    dae = {'x':x, 'p':p, 'ode':vertcat(x[1],-p*x[0]), 'quad':x[0]**2}
+    N = 5
+    X0 = DM.rand(2,N)
+    P = 1+DM.rand(1,N)
+    for Integrator, features, options in integrators:
+      opts = dict(options)
+      opts["tf"] = 1
+      I = integrator("I", Integrator, dae, opts)
+      opts["batch"] = N
+      Ib = integrator("Ib", Integrator, dae, opts)
+      self.assertEqual(Ib.size_in("x0"),(2*N,1))
+      sol = Ib(x0=vec(X0), p=vec(P))
+      for k in range(N):
+        ref = I(x0=X0[:,k], p=P[k])
+        self.checkarray(sol["xf"][2*k:2*k+2], ref["xf"], digits=5)
+        self.checkarray(sol["qf"][k], ref["qf"], digits=5)
+
+      # Sensitivities are block diagonal
+      x0 = MX.sym("x0",2*N)
+      J = Function("J",[x0],[jacobian(Ib(x0=x0, p=vec(P))["xf"],x0)])
+      self.assertEqual(J(vec(X0)).nnz(), 4*N)
+
+
+  def test_reuse_jacobian(self):
+    # Van der Pol oscillator, stiff
+    x = SX.sym("x",2)
+    dae = {'x':x, 'ode':vertcat(x[1],100*(1-x[0]**2)*x[1]-x[0])}
+    for Integrator in ["cvodes", "idas"]:
+      if not has_integrator(Integrator): continue
+      opts = {"tf": 10, "abstol": 1e-10, "reltol": 1e-10}
+      I = integrator("I", Integrator, dae, opts)
+      ref = I(x0=vertcat(2,0))["xf"]
+      stats = I.stats()
+      self.assertEqual(stats["njevals"], stats["nfacts"])
+      for age in [1, 50]:
+        opts["reuse_jacobian"] = True
+        opts["max_jacobian_age"] = age
+        Ir = integrator("I", Integrator, dae, opts)
+        self.checkarray(Ir(x0=vertcat(2,0))["xf"], ref, digits=5)
+        stats = Ir.stats()
+        self.assertTrue(stats["njevals"]<=stats["nfacts"])
+        if age>1: self.assertTrue(stats["njevals"]<stats["nfacts"])
+
+  def test_checkpoint_memory(self):
+    # Van der Pol oscillator with adjoint sensitivities
+    x = SX.sym("x",2)
+    rx = SX.sym("rx",2)
+    ode = vertcat(x[1],10*(1-x[0]**2)*x[1]-x[0])
+    dae = {'x':x, 'ode':ode, 'quad':x[0]**2, 'rx':rx,
+           'rode':mtimes(jacobian(ode,x).T,rx), 'rquad':x[1]*rx[0]}
+    for Integrator in ["cvodes", "idas"]:
+      if not has_integrator(Integrator): continue
+      opts = {"grid": list(numpy.linspace(0,30,21)), "abstol": 1e-10, "reltol": 1e-10}
+      I = integrator("I", Integrator, dae, opts)
+      ref = I(x0=vertcat(2,0), rx0=vertcat(1,0.5))
+      self.assertEqual(I.stats()["nsegments"], 0)
+      opts["max_checkpoint_memory"] = 0.002
+      I = integrator("I", Integrator, dae, opts)
+      for I in [I, Function.deserialize(I.serialize())]:
+        res = I(x0=vertcat(2,0), rx0=vertcat(1,0.5))
+        for k in ["xf", "qf", "rxf", "rqf"]:
+          self.checkarray(res[k], ref[k], digits=5)
+        stats = I.stats()
+        self.assertTrue(stats["nsegments"]>1)
+        self.assertTrue(stats["nrecompute"]>0)
+
+  def test_collocation_parallelization(self):
+    x = SX.sym("x",2)
+    z = SX.sym("z")
+    p = SX.sym("p")
+    rx = SX.sym("rx",2)
+    dae = {'x':x, 'z':z, 'p':p, 'ode':vertcat(x[1],p*(1-z)*x[1]-x[0]),
+           'alg':z-x[0]**2, 'quad':z, 'rx':rx,
+           'rode':vertcat(-rx[1],rx[0]+p*(1-z)*rx[1]), 'rquad':x[1]*rx[1]}
+    arg = {"x0": vertcat(1,0), "z0": 1, "p": 1.3, "rx0": vertcat(1,0.5)}
+    ref = integrator("I", "collocation", dae, {"tf": 2})(**arg)
+    for par in ["serial", "openmp", "thread"]:
+      I = integrator("I", "collocation", dae, {"tf": 2, "parallelization": par})
+      for I in [I, Function.deserialize(I.serialize())]:
+        res = I(**arg)
+        for k in ["xf", "zf", "qf", "rxf", "rqf"]:
+          self.checkarray(res[k], ref[k], digits=12)
+
+  def test_erk(self):
+    x = SX.sym("x",2)
+    p = SX.sym("p")
+    t = SX.sym("t")
+    rx = SX.sym("rx",2)
+    dae = {'x':x, 'p':p, 't':t, 'ode':vertcat(x[1],p*(1-x[0]**2)*x[1]-x[0]+0.1*sin(t)),
+           'quad':x[0]**2, 'rx':rx, 'rode':vertcat(-rx[1],rx[0]+p*(1-x[0]**2)*rx[1]),
+           'rquad':x[1]*rx[1]}
+    arg = {"x0": vertcat(1,0.5), "p": 0.7, "rx0": vertcat(1,0.5)}
+    grid = [0, 0.3, 1.1, 2.5, 4]
+    ref = integrator("I", "rk", dae, {"grid": grid, "number_of_finite_elements": 2000})(**arg)
+    for scheme in ["dopri5", "tsit5", "verner65"]:
+      I = integrator("I", "erk", dae, {"grid": grid, "scheme": scheme,
+                                       "abstol": 1e-12, "reltol": 1e-12})
+      for I in [I, Function.deserialize(I.serialize())]:
+        res = I(**arg)
+        for k in ["xf", "qf", "rxf", "rqf"]:
+          self.checkarray(res[k], ref[k], digits=6)
+      stats = I.stats()
+      self.assertTrue(stats["nsteps"]>0 and stats["nstepsB"]>0)
+
+      # Code generation of the forward problem and its forward sensitivities
+      dae_fwd = {k: dae[k] for k in ['x', 'p', 't', 'ode', 'quad']}
+      I = integrator("I", "erk", dae_fwd, {"tf": 4, "scheme": scheme})
+      x0 = MX.sym("x0",2)
+      xf = I(x0=x0, p=0.7)["xf"]
+      F = Function("F", [x0], [xf, jtimes(xf, x0, vertcat(1,0))])
+      self.check_codegen(F, inputs=[vertcat(1,0.5)])
+
+  def test_erk_accuracy(self):
+    # Outputs on a fine grid as accurate as at the end time, default tolerances
+    x = SX.sym("x",2)
+    grid = [0.05*i for i in range(201)]
+    osc = {'x':x, 'ode':vertcat(x[1],-x[0])}
+    for scheme in ["dopri5", "tsit5", "verner65"]:
+      I = integrator("I", "erk", osc, {"grid": grid, "output_t0": True, "scheme": scheme})
+      xf = I(x0=vertcat(1,0))["xf"]
+      self.checkarray(xf[0,:], DM(numpy.cos(grid)).T, digits=5)
+      self.checkarray(xf[1,:], DM(-numpy.sin(grid)).T, digits=5)
+
+    # Adjoint sensitivities of Van der Pol, default tolerances
+    p = SX.sym("p")
+    vdp = {'x':x, 'p':p, 'ode':vertcat(x[1],p*(1-x[0]**2)*x[1]-x[0])}
+    x0 = MX.sym("x0",2)
+    P = MX.sym("p")
+    def grad(I):
+      xf = I(x0=x0, p=P)["xf"]
+      J = dot(xf, xf)
+      return Function("G", [x0, P], [J, gradient(J, vertcat(x0, P))])(vertcat(2,0), 1)
+    ref = grad(integrator("I", "rk", vdp, {"tf": 10, "number_of_finite_elements": 2000}))
+    for scheme in ["dopri5", "tsit5", "verner65"]:
+      res = grad(integrator("I", "erk", vdp, {"tf": 10, "scheme": scheme}))
+      self.checkarray(res[0], ref[0], digits=4)
+      self.checkarray(res[1], ref[1], digits=4)
 
 
 if __name__ == '__main__':
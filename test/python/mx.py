@@ -29,6 +29,7 @@ import unittest
 from types import *
 from helpers import *
 from copy import deepcopy
+from ctypes.util import find_library
 
 import sys
 
@@ -2906,6 +2907,59 @@ class MXtests(casadiTestCase):
     self.checkarray(i,A[i].mapping())
 
 
+  def test_cse(self):
+    x = MX.sym("x",2)
+    y = MX.sym("y",2)
+    e1 = sin(x)*y + 3
+    e2 = sin(x)*y + 3
+    e3 = y*sin(x)
+    self.assertFalse(is_equal(e1,e2))
+    [r1,r2,r3] = cse([e1,e2,e3])
+    self.assertTrue(is_equal(r1,r2))
+    self.assertTrue(is_equal(r3,r1.dep(1)))
+    [r1,r3] = cse([e1,e3],False)
+    self.assertFalse(is_equal(r3,r1.dep(1)))
+
+    f = Function("f",[x,y],[e1,e2,e3])
+    fc = Function("f",[x,y],[e1,e2,e3],{"cse":True})
+    self.assertTrue(fc.n_instructions()<f.n_instructions())
+    self.checkfunction(f,fc,inputs=[DM([0.3,0.4]),DM([0.7,0.1])])
+
+  def test_simd_kernels(self):
+    np.random.seed(0)
+    A = MX.sym("A",19,23)
+    B = MX.sym("B",23,13)
+    Bs = MX.sym("Bs",sprandn(23,13,0.2).sparsity())
+    v = MX.sym("v",23)
+    f = Function("f",[A,B,Bs,v],[mtimes(A,B),mtimes(A,Bs),mtimes(A,v),dot(v,v),mtimes(A.T,A)])
+    inputs = [DM(np.random.random(A.shape)),DM(np.random.random(B.shape)),
+              DM(Bs.sparsity(),np.random.random(Bs.nnz())),DM(np.random.random(v.shape))]
+    fs = f.expand()
+    try:
+      for level in [0,1,2]:
+        GlobalOptions.setSimdLevel(level)
+        self.checkfunction_light(f,fs,inputs=inputs)
+    finally:
+      GlobalOptions.setSimdLevel(-1)
+
+  def test_blas(self):
+    np.random.seed(0)
+    A = MX.sym("A",40,30)
+    B = MX.sym("B",30,20)
+    v = MX.sym("v",30)
+    f = Function("f",[A,B,v],[mtimes(A,B),mtimes(A,v),mtimes(A.T,A),mtimes(A,B)+A[:,:20]])
+    inputs = [DM(np.random.random(A.shape)),DM(np.random.random(B.shape)),DM(np.random.random(v.shape))]
+    fs = f.expand()
+    try:
+      for threshold in [-1,0,1000]:
+        GlobalOptions.setBlasThreshold(threshold)
+        self.checkfunction_light(f,fs,inputs=inputs)
+    finally:
+      GlobalOptions.setBlasThreshold(32768)
+    # Generated code calling dgemm_ needs a BLAS to link against
+    if find_library("blas") is not None:
+      self.check_codegen(f,inputs=inputs,opts={"blas":True,"blas_threshold":0},extralibs=["blas"])
+
   def test_convexify(self):
     A = diagcat(1,2,-1,blockcat([[1.2,1.3],[1.3,4]]),sparsify(blockcat([[0,1,0],[1,4,7],[0,7,9]])),DM(2,2))
 
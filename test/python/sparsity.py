@@ -479,6 +479,48 @@ class Sparsitytests(casadiTestCase):
 
     self.assertTrue(DM(J.sparsity_out(0))[:X.nnz(),:].sparsity()==Sparsity.diag(100))
 
+  def test_jacsparsity_threads(self):
+    x = SX.sym("x",500)
+    e = vertcat(*[sin(x[i])*x[(7*i+3)%500]+x[(13*i)%500]**2 for i in range(500)])
+    f = Function('f',[x],[e, gradient(dot(e,e),x)])
+    for hierarchical in [True, False]:
+      GlobalOptions.setHierarchicalSparsity(hierarchical)
+      ref = []
+      for n_threads in [1, 3]:
+        GlobalOptions.setSparsityNumThreads(n_threads)
+        g = Function.deserialize(f.serialize())
+        sp = [g.sparsity_jac(0,0), g.sparsity_jac(0,1,False,True)]
+        if n_threads==1:
+          ref = sp
+        else:
+          self.assertTrue(sp[0]==ref[0])
+          self.assertTrue(sp[1]==ref[1])
+    GlobalOptions.setSparsityNumThreads(1)
+    GlobalOptions.setHierarchicalSparsity(True)
+
+  def test_coloring(self):
+    random.seed(1)
+    n = 1500
+    sp = Sparsity.triplet(200,n,[random.randint(0,199) for i in range(4*n)],
+                                [random.randint(0,n-1) for i in range(4*n)])
+    A = DM(sp,1)
+    for ordering in range(4):
+      for n_threads in [1, 2, 3]:
+        D = sp.uni_coloring(sp.T(), n, ordering, n_threads)
+        # Each column has one color, columns of the same color share no row
+        self.checkarray(mtimes(DM(D,1),DM.ones(D.size2(),1)),DM.ones(n,1))
+        self.assertTrue(np.max(np.array(mtimes(A,DM(D,1))))<=1)
+      D = sp.uni_coloring(sp.T(), n, ordering, 2)
+      self.assertTrue(D==sp.uni_coloring(sp.T(), n, ordering, 4))
+      ord = sp.coloring_ordering(ordering, sp.T())
+      self.assertEqual(sorted(ord), list(range(n)))
+    S = Sparsity.banded(50,2)
+    for ordering in range(4):
+      for D in [S.star_coloring(ordering), S.star_coloring2(ordering)]:
+        self.checkarray(mtimes(DM(D,1),DM.ones(D.size2(),1)),DM.ones(50,1))
+        self.assertTrue(D.size2()<=9)
+    self.assertTrue(sp.uni_coloring(sp.T(), 1).is_null())
+
   @memory_heavy()
   def test_jacsparsityHierarchicalSymm(self):
     GlobalOptions.setHierarchicalSparsity(False)
@@ -1438,6 +1438,46 @@ class SXtests(casadiTestCase):
   def test_ufunc(self):
     y = np.sin(casadi.SX.sym('x'))
 
+  def test_cse(self):
+    x = SX.sym("x")
+    y = SX.sym("y")
+    e1 = sin(x)*y + 3
+    e2 = sin(x)*y + 3
+    e3 = y*sin(x)
+    self.assertFalse(is_equal(e1,e2))
+    [r1,r2,r3] = cse([e1,e2,e3])
+    self.assertTrue(is_equal(r1,r2))
+    self.assertTrue(is_equal(r3,r1.dep(0)))
+    # Operand order matters without canonicalization of commutative operations
+    [r1,r3] = cse([e1,e3],False)
+    self.assertFalse(is_equal(r3,r1.dep(0)))
+
+    f = Function("f",[x,y],[e1,e2,e3])
+    fc = Function("f",[x,y],[e1,e2,e3],{"cse":True})
+    self.assertTrue(fc.n_instructions()<f.n_instructions())
+    self.checkfunction(f,fc,inputs=[0.3,0.7])
+
+  def test_node_pool(self):
+    x = SX.sym("x",3)
+    ref = None
+    for pool in [False, True]:
+      GlobalOptions.setSXNodePool(pool)
+      try:
+        e = x
+        for k in range(100):
+          e = sin(e*x[k%3]+k) - e/2
+        f = Function("f",[x],[e, e*x])
+        r = f(vertcat(0.1,0.2,0.3))
+      finally:
+        GlobalOptions.setSXNodePool(False)
+      # Nodes created with the pool enabled must survive disabling it
+      r2 = f(vertcat(0.1,0.2,0.3))
+      for i in range(2): self.checkarray(r[i],r2[i])
+      if ref is None:
+        ref = r
+      else:
+        for i in range(2): self.checkarray(r[i],ref[i])
+
 
 
 if __name__ == '__main__':